@@ -0,0 +1,634 @@
+// Headless performance benchmarks for OpenKJ.
+//
+// Builds a synthetic library in a throwaway SQLite database and times the hot paths that are otherwise only
+// exercised by the GUI torture tests: catalog load/search/sort, rotation reorders and wait time estimates,
+// DbUpdater scans, zip extraction, CDG decoding and the songbook catalog upload against a local HTTP stand-in.  Results are written as JSON so runs from different builds
+// can be diffed, pass --compare with a previous result file to get a quick summary of the changes on stderr.
+// A few correctness checks run alongside (row counts, songbook retries, the zip optimizer keeping the members that
+// play), any failure makes the run exit nonzero.
+//
+// Nothing touches the user's real settings or database; settings and data locations are redirected into a
+// temporary directory before anything reads them.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "syntheticlibrary.h"
+#include "src/cdg/cdgfilereader.h"
+#include "src/dbupdater.h"
+#include "src/idledetect.h"
+#include "src/miniz/miniz.h"
+#include "src/models/tablemodelkaraokesongs.h"
+#include "src/models/tablemodelrotation.h"
+#include "src/mzarchive.h"
+#include "src/okjversion.h"
+#include "src/songbookuploader.h"
+#include "src/zipoptimizer.h"
+
+// Referenced by okjsongbookapi.cpp, normally defined in main.cpp
+IdleDetect *filter{nullptr};
+
+namespace {
+
+struct BenchResult {
+    QString name;
+    int items{0};
+    std::vector<double> samplesMs;
+
+    [[nodiscard]] QJsonObject toJson() const
+    {
+        auto sorted = samplesMs;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = sorted.empty() ? 0.0 : std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        double median{0.0};
+        if (!sorted.empty()) {
+            auto mid = sorted.size() / 2;
+            median = (sorted.size() % 2) ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2.0;
+        }
+        QJsonArray samples;
+        for (auto sample : samplesMs)
+            samples.append(sample);
+        return QJsonObject{
+                {"name", name},
+                {"items", items},
+                {"iterations", static_cast<int>(samplesMs.size())},
+                {"unit", "ms"},
+                {"min", sorted.empty() ? 0.0 : sorted.front()},
+                {"median", median},
+                {"mean", mean},
+                {"max", sorted.empty() ? 0.0 : sorted.back()},
+                {"samples", samples}
+        };
+    }
+};
+
+class BenchRunner
+{
+public:
+    BenchRunner(int iterations, const QString &nameFilter) :
+            m_iterations(iterations), m_filter(nameFilter) {}
+
+    [[nodiscard]] bool enabled(const QString &name) const
+    {
+        return m_filter.isEmpty() || name.contains(m_filter, Qt::CaseInsensitive);
+    }
+
+    // Runs setup (untimed) then op (timed) m_iterations times
+    void run(const QString &name, int items, const std::function<void()> &setup, const std::function<void()> &op)
+    {
+        if (!enabled(name))
+            return;
+        BenchResult result{name, items, {}};
+        QElapsedTimer timer;
+        for (int i = 0; i < m_iterations; i++) {
+            if (setup)
+                setup();
+            timer.start();
+            op();
+            result.samplesMs.push_back(static_cast<double>(timer.nsecsElapsed()) / 1000000.0);
+        }
+        report(result);
+    }
+
+    // For operations that time themselves, op returns the elapsed ms for one iteration
+    void runTimed(const QString &name, int items, const std::function<double()> &op)
+    {
+        if (!enabled(name))
+            return;
+        BenchResult result{name, items, {}};
+        for (int i = 0; i < m_iterations; i++)
+            result.samplesMs.push_back(op());
+        report(result);
+    }
+
+    [[nodiscard]] QJsonArray results() const { return m_results; }
+
+private:
+    int m_iterations;
+    QString m_filter;
+    QJsonArray m_results;
+
+    void report(const BenchResult &result)
+    {
+        auto json = result.toJson();
+        QTextStream(stderr) << QString("%1 median %2 ms (min %3, max %4, %5 items)\n")
+                .arg(result.name, -40)
+                .arg(json.value("median").toDouble(), 0, 'f', 3)
+                .arg(json.value("min").toDouble(), 0, 'f', 3)
+                .arg(json.value("max").toDouble(), 0, 'f', 3)
+                .arg(result.items);
+        m_results.append(json);
+    }
+};
+
+void compareWithBaseline(const QJsonArray &results, const QString &baselinePath)
+{
+    QFile baselineFile(baselinePath);
+    if (!baselineFile.open(QIODevice::ReadOnly)) {
+        QTextStream(stderr) << "Unable to open baseline " << baselinePath << "\n";
+        return;
+    }
+    QHash<QString, double> baselineMedians;
+    const auto baselineResults = QJsonDocument::fromJson(baselineFile.readAll()).object().value("results").toArray();
+    for (const auto &entry : baselineResults)
+        baselineMedians.insert(entry.toObject().value("name").toString(), entry.toObject().value("median").toDouble());
+    QTextStream err(stderr);
+    err << "\nChange in median vs " << baselinePath << "\n";
+    for (const auto &entry : results) {
+        auto obj = entry.toObject();
+        auto name = obj.value("name").toString();
+        if (!baselineMedians.contains(name) || baselineMedians.value(name) <= 0.0)
+            continue;
+        double change = (obj.value("median").toDouble() / baselineMedians.value(name) - 1.0) * 100.0;
+        err << QString("%1 %2%3%\n").arg(name, -40).arg(change >= 0 ? "+" : "").arg(change, 0, 'f', 1);
+    }
+}
+
+// The bench functions return false when the operation they time didn't do what it should (a query failing against
+// the synthetic schema times nothing useful), main turns that into a nonzero exit code.
+bool benchCatalog(BenchRunner &runner, int songCount)
+{
+    TableModelKaraokeSongs model;
+    // loadData applies the current filter before returning, so this covers the initial filtering pass too
+    runner.run("catalog.loadData", songCount, nullptr, [&model] { model.loadData(); });
+    model.loadData();
+    if (model.rowCount(QModelIndex()) != songCount) {
+        QTextStream(stderr) << "catalog.loadData loaded " << model.rowCount(QModelIndex()) << " of " << songCount
+                            << " songs\n";
+        return false;
+    }
+
+    // search() is debounced through a timer, the actual filtering happens between these two signals
+    QElapsedTimer searchTimer;
+    double lastSearchMs{0.0};
+    QObject::connect(&model, &TableModelKaraokeSongs::layoutAboutToBeChanged, [&searchTimer] { searchTimer.start(); });
+    QObject::connect(&model, &TableModelKaraokeSongs::layoutChanged, [&] {
+        if (searchTimer.isValid())
+            lastSearchMs = static_cast<double>(searchTimer.nsecsElapsed()) / 1000000.0;
+    });
+    auto timedSearch = [&](const QString &terms) {
+        searchTimer.invalidate();
+        lastSearchMs = 0.0;
+        QEventLoop loop;
+        auto connection = QObject::connect(&model, &TableModelKaraokeSongs::layoutChanged, &loop, &QEventLoop::quit);
+        model.search(terms);
+        loop.exec();
+        QObject::disconnect(connection);
+        return lastSearchMs;
+    };
+    const std::vector<std::pair<QString, QString>> searches{
+            {"catalog.search.single", "midnight"},
+            {"catalog.search.multi", "lonely heart fire"},
+            {"catalog.search.songid", "syn00042"},
+            {"catalog.search.nomatch", "zzzzqqq"},
+            {"catalog.search.all", ""}
+    };
+    for (const auto &[name, terms] : searches)
+        runner.runTimed(name, songCount, [&, terms = terms] { return timedSearch(terms); });
+
+    timedSearch("");
+    if (model.rowCount(QModelIndex()) != songCount) {
+        QTextStream(stderr) << "catalog.search.all matched " << model.rowCount(QModelIndex()) << " of " << songCount
+                            << " songs\n";
+        return false;
+    }
+    runner.run("catalog.sort.artist", songCount, nullptr, [&model] { model.sort(TableModelKaraokeSongs::COL_ARTIST, Qt::AscendingOrder); });
+    runner.run("catalog.sort.title", songCount, nullptr, [&model] { model.sort(TableModelKaraokeSongs::COL_TITLE, Qt::AscendingOrder); });
+    runner.run("catalog.sort.songid", songCount, nullptr, [&model] { model.sort(TableModelKaraokeSongs::COL_SONGID, Qt::DescendingOrder); });
+    runner.run("catalog.sort.plays", songCount, nullptr, [&model] { model.sort(TableModelKaraokeSongs::COL_PLAYS, Qt::DescendingOrder); });
+    return true;
+}
+
+void benchRotation(BenchRunner &runner, int singerCount, quint32 seed)
+{
+    TableModelRotation model;
+    runner.run("rotation.loadData", singerCount, nullptr, [&model] { model.loadData(); });
+    if (model.rowCount(QModelIndex()) < 2)
+        return;
+    model.setCurrentSinger(model.getSingerAtPosition(singerCount / 2).id);
+    model.setCurRemainSecs(90);
+
+    constexpr int movesPerIteration{50};
+    QRandomGenerator rng(seed);
+    runner.run("rotation.singerMove", movesPerIteration, nullptr, [&] {
+        for (int i = 0; i < movesPerIteration; i++) {
+            int from = static_cast<int>(rng.bounded(singerCount));
+            int to = static_cast<int>(rng.bounded(singerCount));
+            if (from != to)
+                model.singerMove(from, to);
+        }
+    });
+    runner.run("rotation.positionWaitTime", singerCount, nullptr, [&] {
+        int total{0};
+        for (int pos = 0; pos < singerCount; pos++)
+            total += model.positionWaitTime(pos);
+        Q_UNUSED(total)
+    });
+    runner.run("rotation.rotationDuration", 1, nullptr, [&model] { Q_UNUSED(model.rotationDuration()) });
+}
+
+bool benchDbUpdater(BenchRunner &runner, const QString &libraryDir, int fileCount)
+{
+    QSqlQuery query;
+    query.prepare("INSERT OR REPLACE INTO sourceDirs (path, pattern, custompattern) VALUES(:path, 0, 0)");
+    query.bindValue(":path", libraryDir);
+    if (!query.exec()) {
+        QTextStream(stderr) << "Unable to add the dbupdater source dir: " << query.lastError().text() << "\n";
+        return false;
+    }
+    auto clearLibrarySongs = [&libraryDir] {
+        QSqlQuery clearQuery;
+        clearQuery.prepare("DELETE FROM dbsongs WHERE path LIKE :prefix");
+        clearQuery.bindValue(":prefix", libraryDir + "%");
+        clearQuery.exec();
+    };
+    auto scan = [&libraryDir] {
+        DbUpdater updater;
+        updater.process({libraryDir}, DbUpdater::ProcessingOption::PrepareForRemovalOfMissing);
+    };
+    runner.run("dbupdater.scan.new", fileCount, clearLibrarySongs, scan);
+    runner.run("dbupdater.scan.unchanged", fileCount, nullptr, scan);
+    if (!runner.enabled("dbupdater.scan.new") && !runner.enabled("dbupdater.scan.unchanged"))
+        return true;
+    query.prepare("SELECT COUNT(*) FROM dbsongs WHERE path LIKE :prefix");
+    query.bindValue(":prefix", libraryDir + "%");
+    int scannedSongs = (query.exec() && query.first()) ? query.value(0).toInt() : -1;
+    if (scannedSongs != fileCount) {
+        QTextStream(stderr) << "dbupdater.scan added " << scannedSongs << " of " << fileCount << " songs\n";
+        return false;
+    }
+    return true;
+}
+
+void benchArchives(BenchRunner &runner, const QStringList &zipFiles, const QString &extractDir)
+{
+    const int count = std::min(static_cast<int>(zipFiles.size()), 50);
+    runner.run("mzarchive.validate", count, nullptr, [&] {
+        MzArchive archive;
+        for (int i = 0; i < count; i++) {
+            archive.setArchiveFile(zipFiles.at(i));
+            archive.isValidKaraokeFile();
+        }
+    });
+    runner.run("mzarchive.extract", count, nullptr, [&] {
+        for (int i = 0; i < count; i++) {
+            MzArchive archive(zipFiles.at(i));
+            archive.extractCdg(extractDir, "bench.cdg");
+            archive.extractAudio(extractDir, "bench" + archive.audioExtension());
+        }
+    });
+}
+
+// Zips packed on macOS carry AppleDouble "._" copies of every member under __MACOSX/, after the real ones.  The
+// optimizer has to keep the members MzArchive plays and drop the junk, anything else destroys the song.
+bool checkZipOptimizer(const BenchRunner &runner, SyntheticLibrary &library, const QString &dirPath)
+{
+    if (!runner.enabled("zipoptimizer"))
+        return true;
+    QDir().mkpath(dirPath);
+    const QString zipPath = dirPath + QDir::separator() + "SYN00001 - Apple Double - Junk Members.zip";
+    const QByteArray cdg = library.cdgData(10);
+    const QByteArray wav = SyntheticLibrary::wavData(10);
+    // AppleDouble header magic and version followed by filler, far too short to be a valid cdg or wav
+    QByteArray appleDouble = QByteArray::fromHex("0005160700020000") + QByteArray(74, '\0');
+    mz_zip_archive archive;
+    memset(&archive, 0, sizeof(archive));
+    bool ok = mz_zip_writer_init_file(&archive, zipPath.toLocal8Bit().constData(), 0);
+    ok = ok && mz_zip_writer_add_mem(&archive, "Song.cdg", cdg.constData(), cdg.size(), MZ_DEFAULT_COMPRESSION);
+    ok = ok && mz_zip_writer_add_mem(&archive, "Song.wav", wav.constData(), wav.size(), MZ_DEFAULT_COMPRESSION);
+    ok = ok && mz_zip_writer_add_mem(&archive, "__MACOSX/._Song.cdg", appleDouble.constData(), appleDouble.size(), MZ_DEFAULT_COMPRESSION);
+    ok = ok && mz_zip_writer_add_mem(&archive, "__MACOSX/._Song.wav", appleDouble.constData(), appleDouble.size(), MZ_DEFAULT_COMPRESSION);
+    ok = ok && mz_zip_writer_finalize_archive(&archive);
+    mz_zip_writer_end(&archive);
+    if (!ok) {
+        QTextStream(stderr) << "zipoptimizer check: unable to write " << zipPath << "\n";
+        return false;
+    }
+
+    ZipOptimizer optimizer;
+    auto report = optimizer.run({zipPath}, false);
+    QString problem;
+    if (report.optimized != 1)
+        problem = "archive wasn't optimized: " + report.errors.join("; ");
+    MzArchive optimized(zipPath);
+    const QString extractDir = dirPath + QDir::separator() + "extract";
+    QDir().mkpath(extractDir);
+    if (problem.isEmpty() && !optimized.isValidKaraokeFile())
+        problem = "optimized archive isn't a valid karaoke file: " + optimized.getLastError();
+    if (problem.isEmpty() && (!optimized.extractCdg(extractDir, "check.cdg") || !optimized.extractAudio(extractDir, "check.wav")))
+        problem = "unable to extract the optimized members";
+    auto readAll = [&extractDir] (const QString &name) {
+        QFile file(extractDir + QDir::separator() + name);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    if (problem.isEmpty() && (readAll("check.cdg") != cdg || readAll("check.wav") != wav))
+        problem = "optimized members don't match the original song";
+    QTextStream(stderr) << "zipoptimizer AppleDouble check " << (problem.isEmpty() ? "passed" : "FAILED: " + problem) << "\n";
+    return problem.isEmpty();
+}
+
+void benchCdg(BenchRunner &runner, const QString &cdgPath, int seconds)
+{
+    int frames{0};
+    runner.run("cdg.decode.full", seconds * 300, nullptr, [&] {
+        CdgFileReader reader(cdgPath);
+        frames = 0;
+        while (reader.moveToNextFrame())
+            frames++;
+    });
+    QRandomGenerator rng(seconds);
+    constexpr int seeksPerIteration{100};
+    runner.run("cdg.seek.random", seeksPerIteration, nullptr, [&] {
+        CdgFileReader reader(cdgPath);
+        for (int i = 0; i < seeksPerIteration; i++)
+            reader.seek(static_cast<int>(rng.bounded(seconds * 1000)));
+    });
+    QTextStream(stderr) << "cdg.decode.full produced " << frames << " frames\n";
+}
+
+
+// Just enough HTTP/1.1 to stand in for the songbook server: answers every POST over keep-alive connections,
+// inflates gzip bodies and counts the songs received.  Every failEvery'th request gets a 503 to exercise retries.
+class SongbookStandIn
+{
+public:
+    SongbookStandIn()
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection, [this] {
+            while (auto socket = m_server.nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::readyRead, [this, socket] { readRequests(socket); });
+                QObject::connect(socket, &QTcpSocket::disconnected, [this, socket] {
+                    m_buffers.remove(socket);
+                    socket->deleteLater();
+                });
+            }
+        });
+        m_server.listen(QHostAddress::LocalHost);
+    }
+
+    [[nodiscard]] QUrl url() const { return QUrl(QString("http://127.0.0.1:%1/api").arg(m_server.serverPort())); }
+    void setFailEvery(int failEvery) { m_failEvery = failEvery; }
+    void reset() { songsReceived = 0; requests = 0; failedRequests = 0; }
+
+    int songsReceived{0};
+    int requests{0};
+    int failedRequests{0};
+
+private:
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    int m_failEvery{0};
+
+    void readRequests(QTcpSocket *socket)
+    {
+        auto &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        while (true) {
+            int headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0)
+                return;
+            int contentLength{0};
+            bool gzipped{false};
+            for (const auto &header : QString::fromLatin1(buffer.left(headerEnd)).split("\r\n")) {
+                auto name = header.section(':', 0, 0).trimmed().toLower();
+                auto value = header.section(':', 1).trimmed();
+                if (name == "content-length")
+                    contentLength = value.toInt();
+                else if (name == "content-encoding")
+                    gzipped = value.compare("gzip", Qt::CaseInsensitive) == 0;
+            }
+            if (buffer.size() < headerEnd + 4 + contentLength)
+                return;
+            auto body = buffer.mid(headerEnd + 4, contentLength);
+            buffer.remove(0, headerEnd + 4 + contentLength);
+            requests++;
+            if (m_failEvery > 0 && requests % m_failEvery == 0) {
+                failedRequests++;
+                respond(socket, 503, R"({"error":true,"errorString":"stand-in failure"})");
+                continue;
+            }
+            auto request = QJsonDocument::fromJson(gzipped ? gunzip(body) : body).object();
+            songsReceived += request.value("songs").toArray().size();
+            respond(socket, 200, QJsonDocument(QJsonObject{
+                    {"command", request.value("command")},
+                    {"error", false}
+            }).toJson(QJsonDocument::Compact));
+        }
+    }
+
+    static QByteArray gunzip(const QByteArray &data)
+    {
+        // SongbookDocumentWorker writes a plain 10 byte header with no optional fields and an 8 byte trailer
+        if (data.size() < 18)
+            return {};
+        size_t size{0};
+        auto inflated = tinfl_decompress_mem_to_heap(data.constData() + 10, data.size() - 18, &size, 0);
+        if (!inflated)
+            return {};
+        QByteArray result(static_cast<const char*>(inflated), static_cast<int>(size));
+        mz_free(inflated);
+        return result;
+    }
+
+    static void respond(QTcpSocket *socket, int status, const QByteArray &body)
+    {
+        socket->write(QString("HTTP/1.1 %1 %2\r\nContent-Type: application/json\r\nContent-Length: %3\r\n\r\n")
+                              .arg(status)
+                              .arg(status == 200 ? "OK" : "Service Unavailable")
+                              .arg(body.size())
+                              .toLatin1() + body);
+    }
+};
+
+bool benchSongbookUpload(BenchRunner &runner)
+{
+    if (!runner.enabled("songbook.upload.gzip") && !runner.enabled("songbook.upload.plain"))
+        return true;
+    QSqlQuery query;
+    int expectedSongs{0};
+    if (query.exec("SELECT COUNT(*) FROM (SELECT DISTINCT artist, title FROM dbsongs WHERE discid != '!!DROPPED!!' AND discid != '!!BAD!!')") && query.first())
+        expectedSongs = query.value(0).toInt();
+    const auto dbFilePath = QSqlDatabase::database().databaseName();
+    SongbookStandIn standIn;
+    bool allReceived{true};
+    auto upload = [&] (bool compress) {
+        standIn.reset();
+        SongbookUploader uploader;
+        uploader.setCompressionEnabled(compress);
+        QElapsedTimer timer;
+        timer.start();
+        bool success = uploader.upload(standIn.url(), "openkj-bench", 1, dbFilePath);
+        double elapsedMs = static_cast<double>(timer.nsecsElapsed()) / 1000000.0;
+        if (!success || standIn.songsReceived != expectedSongs) {
+            allReceived = false;
+            QTextStream(stderr) << "songbook upload received " << standIn.songsReceived << " of " << expectedSongs
+                                << " songs" << (success ? "" : ", upload reported failure") << "\n";
+        }
+        return elapsedMs;
+    };
+    runner.runTimed("songbook.upload.gzip", expectedSongs, [&] { return upload(true); });
+    runner.runTimed("songbook.upload.plain", expectedSongs, [&] { return upload(false); });
+
+    // One untimed pass against a flaky server, retried documents must arrive exactly once.  Uploads big enough to
+    // reach the failing request have to have actually retried for the check to mean anything.
+    constexpr int failEvery{7};
+    standIn.setFailEvery(failEvery);
+    upload(true);
+    bool retriesOk = allReceived && (standIn.failedRequests > 0 || standIn.requests < failEvery);
+    QTextStream(stderr) << "songbook.upload retry check " << (retriesOk ? "passed" : "FAILED") << ": "
+                        << standIn.songsReceived << " of " << expectedSongs << " songs received with "
+                        << standIn.failedRequests << " failed requests\n";
+    return retriesOk;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        QTextStream(stderr) << "Unable to create a temporary directory\n";
+        return 1;
+    }
+    // Keep Settings away from the user's real configuration on every platform
+    QStandardPaths::setTestMode(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, workDir.filePath("settings"));
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, workDir.filePath("settings"));
+
+    // The models grab the "logger" logger on construction, it has to exist before any of them are created.
+    // Logs go to stderr so stdout stays clean for the JSON results.
+    auto stderrSink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+    stderrSink->set_level(spdlog::level::warn);
+    auto logger = std::make_shared<spdlog::logger>("logger", stderrSink);
+    logger->set_level(spdlog::level::warn);
+    spdlog::register_logger(logger);
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("openkj-bench");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("OpenKJ headless performance benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption songsOption("songs", "Synthetic catalog size.", "count", "100000");
+    QCommandLineOption singersOption("singers", "Rotation singer count.", "count", "60");
+    QCommandLineOption queueOption("queue", "Queued songs per rotation singer.", "count", "5");
+    QCommandLineOption historyOption("history", "History singer count.", "count", "500");
+    QCommandLineOption zipsOption("zips", "Zip files to generate for the scan and extraction benchmarks.", "count", "500");
+    QCommandLineOption cdgSecondsOption("cdg-seconds", "Length of the synthetic CDG tracks.", "seconds", "210");
+    QCommandLineOption iterationsOption("iterations", "Timed iterations per benchmark.", "count", "5");
+    QCommandLineOption seedOption("seed", "Seed for the synthetic data generator.", "seed", "20130");
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text.", "text");
+    QCommandLineOption outputOption({"o", "output"}, "Write JSON results to this file instead of stdout.", "file");
+    QCommandLineOption compareOption("compare", "Print the change in median times against a previous result file.", "file");
+    parser.addOptions({songsOption, singersOption, queueOption, historyOption, zipsOption, cdgSecondsOption,
+                       iterationsOption, seedOption, filterOption, outputOption, compareOption});
+    parser.process(app);
+
+    const int songs = std::max(1, parser.value(songsOption).toInt());
+    const int singers = std::max(2, parser.value(singersOption).toInt());
+    const int queueSize = std::max(0, parser.value(queueOption).toInt());
+    const int historySingers = std::max(0, parser.value(historyOption).toInt());
+    const int zipCount = std::max(1, parser.value(zipsOption).toInt());
+    const int cdgSeconds = std::max(1, parser.value(cdgSecondsOption).toInt());
+    const int iterations = std::max(1, parser.value(iterationsOption).toInt());
+    const auto seed = parser.value(seedOption).toUInt();
+
+    auto database = QSqlDatabase::addDatabase("QSQLITE");
+    database.setDatabaseName(workDir.filePath("openkj-bench.sqlite"));
+    if (!database.open() || !SyntheticLibrary::createSchema()) {
+        QTextStream(stderr) << "Unable to set up the benchmark database: " << database.lastError().text() << "\n";
+        return 1;
+    }
+
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+    SyntheticLibrary library(seed);
+    if (!library.populateCatalog(songs)) {
+        QTextStream(stderr) << "Unable to populate the synthetic catalog\n";
+        return 1;
+    }
+    library.populateRotation(singers, queueSize);
+    library.populateHistory(historySingers, 20);
+    const QString libraryDir = workDir.filePath("library");
+    const QStringList zipFiles = library.writeKaraokeZips(libraryDir, zipCount, 30);
+    const QString cdgPath = workDir.filePath("bench-track.cdg");
+    QFile cdgFile(cdgPath);
+    if (cdgFile.open(QIODevice::WriteOnly)) {
+        cdgFile.write(library.cdgData(cdgSeconds));
+        cdgFile.close();
+    }
+    QTextStream(stderr) << "Generated synthetic data in " << generateTimer.elapsed() << " ms\n";
+
+    BenchRunner runner(iterations, parser.value(filterOption));
+    bool checksPassed = benchCatalog(runner, songs);
+    benchRotation(runner, singers, seed);
+    checksPassed &= benchDbUpdater(runner, libraryDir, static_cast<int>(zipFiles.size()));
+    QDir().mkpath(workDir.filePath("extract"));
+    benchArchives(runner, zipFiles, workDir.filePath("extract"));
+    benchCdg(runner, cdgPath, cdgSeconds);
+    checksPassed &= checkZipOptimizer(runner, library, workDir.filePath("zipoptimizer"));
+    checksPassed &= benchSongbookUpload(runner);
+
+    QJsonObject output{
+            {"benchmark", "openkj-bench"},
+            {"version", OKJ_VERSION_STRING},
+            {"qtVersion", qVersion()},
+            {"parameters", QJsonObject{
+                    {"songs", songs},
+                    {"singers", singers},
+                    {"queue", queueSize},
+                    {"history", historySingers},
+                    {"zips", zipCount},
+                    {"cdgSeconds", cdgSeconds},
+                    {"iterations", iterations},
+                    {"seed", static_cast<qint64>(seed)}
+            }},
+            {"results", runner.results()}
+    };
+    QByteArray json = QJsonDocument(output).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile outFile(parser.value(outputOption));
+        if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "Unable to write " << outFile.fileName() << "\n";
+            return 1;
+        }
+        outFile.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    if (parser.isSet(compareOption))
+        compareWithBaseline(runner.results(), parser.value(compareOption));
+
+    database.close();
+    if (!checksPassed) {
+        QTextStream(stderr) << "One or more benchmark checks failed, the timings above aren't meaningful\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include "syntheticlibrary.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtEndian>
+#include <QDebug>
+#include <array>
+#include "src/miniz/miniz.h"
+
+namespace {
+constexpr int cdgPacketSize{24};
+constexpr int cdgPacketsPerSecond{300};
+constexpr char cdgCommand{0x09};
+// Fixed reference point for play timestamps so the data doesn't depend on when the benchmark runs
+const QDateTime historyEpoch{QDate(2024, 1, 1), QTime(0, 0)};
+
+bool execAll(QSqlQuery &query, const QStringList &statements)
+{
+    for (const auto &statement : statements) {
+        if (!query.exec(statement)) {
+            qWarning() << "Schema statement failed:" << statement << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+SyntheticLibrary::SyntheticLibrary(quint32 seed) :
+        m_rng(seed)
+{
+    m_words = QString("Midnight Highway Lonely Heart Fire River Dancing Summer Rain Golden Broken Wild Electric Velvet "
+                      "Thunder Sweet Little Crazy Love Blue Moon Silver Morning Shadow Angel Paper Stone Honey Neon "
+                      "Ocean Whiskey Diamond Runaway Starlight Memory Carolina Desert Rose Satellite Dream Hollow "
+                      "Tennessee Crystal Rebel Gypsy Jukebox Cherry Sunset Phantom Harbor Bonfire Lucky Paradise").split(' ');
+}
+
+bool SyntheticLibrary::createSchema()
+{
+    QSqlQuery query;
+    return execAll(query, {
+            "CREATE TABLE dbSongs ( songid INTEGER PRIMARY KEY AUTOINCREMENT, Artist COLLATE NOCASE, Title COLLATE NOCASE, DiscId COLLATE NOCASE, 'Duration' INTEGER, path VARCHAR(700) NOT NULL UNIQUE, filename COLLATE NOCASE, searchstring TEXT, plays INT DEFAULT(0), lastplay TIMESTAMP, audiopath TEXT, loudness REAL, truepeak REAL)",
+            "CREATE TABLE rotationSingers ( singerid INTEGER PRIMARY KEY AUTOINCREMENT, name COLLATE NOCASE UNIQUE, 'position' INTEGER NOT NULL, 'regular' LOGICAL DEFAULT(0), 'regularid' INTEGER, addts TIMESTAMP)",
+            "CREATE TABLE queueSongs ( qsongid INTEGER PRIMARY KEY AUTOINCREMENT, singer INT, song INTEGER NOT NULL, artist INT, title INT, discid INT, path INT, keychg INT, played LOGICAL DEFAULT(0), 'position' INT)",
+            "CREATE TABLE regularSingers ( regsingerid INTEGER PRIMARY KEY AUTOINCREMENT, Name COLLATE NOCASE UNIQUE, ph1 INT, ph2 INT, ph3 INT)",
+            "CREATE TABLE regularSongs ( regsongid INTEGER PRIMARY KEY AUTOINCREMENT, regsingerid INTEGER NOT NULL, songid INTEGER NOT NULL, 'keychg' INTEGER, 'position' INTEGER)",
+            "CREATE TABLE sourceDirs ( path VARCHAR(255) UNIQUE, pattern INTEGER, custompattern INTEGER)",
+            "CREATE TABLE bmsongs ( songid INTEGER PRIMARY KEY AUTOINCREMENT, Artist COLLATE NOCASE, Title COLLATE NOCASE, path VARCHAR(700) NOT NULL UNIQUE, Filename COLLATE NOCASE, Duration TEXT, searchstring TEXT, loudness REAL, truepeak REAL)",
+            "CREATE TABLE bmplaylists ( playlistid INTEGER PRIMARY KEY AUTOINCREMENT, title COLLATE NOCASE NOT NULL UNIQUE)",
+            "CREATE TABLE bmplsongs ( plsongid INTEGER PRIMARY KEY AUTOINCREMENT, playlist INT, position INT, Artist INT, Title INT, Filename INT, Duration INT, path INT)",
+            "CREATE TABLE bmsrcdirs ( path NOT NULL)",
+            "CREATE TABLE custompatterns ( patternid INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, artistregex TEXT, artistcapturegrp INT, titleregex TEXT, titlecapturegrp INT, discidregex TEXT, discidcapturegrp INT)",
+            "CREATE UNIQUE INDEX idx_path ON dbsongs(path)",
+            "CREATE TABLE dbSongHistory ( id INTEGER PRIMARY KEY AUTOINCREMENT, filepath TEXT, artist TEXT, title TEXT, songid TEXT, timestamp TIMESTAMP)",
+            "CREATE INDEX idx_filepath ON dbSongHistory(filepath)",
+            "CREATE TABLE historySingers(id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL UNIQUE)",
+            "CREATE TABLE historySongs(id INTEGER PRIMARY KEY AUTOINCREMENT, historySinger INT NOT NULL, filepath TEXT NOT NULL, artist TEXT, title TEXT, songid TEXT, keychange INT DEFAULT(0), plays INT DEFAULT(0), lastplay TIMESTAMP)",
+            "CREATE INDEX idx_historySinger on historySongs(historySinger)",
+            "CREATE TABLE playbackJournal ( id INTEGER PRIMARY KEY AUTOINCREMENT, timestamp TIMESTAMP, backend TEXT, filepath TEXT, filetype TEXT, sourcedir TEXT, prepare_ms INT, first_audio_ms INT, first_video_ms INT, audio_qos_events INT, video_frames_dropped INT, warnings INT, watchdog_trips INT, seeks INT, seek_total_ms INT, seek_max_ms INT, played_ms INT, error INT)",
+            "CREATE INDEX idx_playbackJournal_timestamp ON playbackJournal(timestamp)",
+            "CREATE TABLE fileIntegrity ( path TEXT PRIMARY KEY, checked TIMESTAMP, ok INT, error TEXT)",
+            "PRAGMA user_version = 110"
+    });
+}
+
+bool SyntheticLibrary::populateCatalog(int songCount)
+{
+    QSqlQuery query;
+    bool success{true};
+    query.exec("BEGIN TRANSACTION");
+    query.prepare("INSERT INTO dbSongs (discid, artist, title, path, filename, duration, searchstring, plays, lastplay) "
+                  "VALUES(:discid, :artist, :title, :path, :filename, :duration, :searchstring, :plays, :lastplay)");
+    // Roughly a dozen songs per artist, like a typical commercial catalog
+    int artistCount = std::max(1, (m_catalogSize + songCount) / 12);
+    for (int i = m_catalogSize; i < m_catalogSize + songCount; i++) {
+        QString artist = artistName(static_cast<int>(m_rng.bounded(artistCount)));
+        QString title = songTitle(i);
+        QString discId = songId(i);
+        QString baseName = discId + " - " + artist + " - " + title;
+        int plays = (m_rng.bounded(3) == 0) ? static_cast<int>(m_rng.bounded(1, 40)) : 0;
+        query.bindValue(":discid", discId);
+        query.bindValue(":artist", artist);
+        query.bindValue(":title", title);
+        query.bindValue(":path", "/synthetic/karaoke/" + baseName + ".zip");
+        query.bindValue(":filename", baseName + ".zip");
+        query.bindValue(":duration", static_cast<int>(m_rng.bounded(120000, 360000)));
+        query.bindValue(":searchstring", baseName + " " + artist + " " + title + " " + discId);
+        query.bindValue(":plays", plays);
+        query.bindValue(":lastplay", plays > 0 ? historyEpoch.addSecs(m_rng.bounded(365 * 86400)) : QVariant());
+        if (!query.exec()) {
+            qWarning() << "Catalog insert failed:" << query.lastError().text();
+            success = false;
+            break;
+        }
+    }
+    query.exec("COMMIT");
+    m_catalogSize += songCount;
+    return success;
+}
+
+void SyntheticLibrary::populateRotation(int singerCount, int queueSize)
+{
+    QSqlQuery singerQuery;
+    QSqlQuery songQuery;
+    singerQuery.exec("BEGIN TRANSACTION");
+    singerQuery.prepare("INSERT INTO rotationsingers (name,position,regular,regularid,addts) "
+                        "VALUES(:name,:pos,0,-1,:addts)");
+    songQuery.prepare("INSERT INTO queuesongs (singer,song,artist,title,discid,path,keychg,played,position) "
+                      "VALUES (:singerId,:songId,:songId,:songId,:songId,:songId,:key,0,:position)");
+    for (int s = 0; s < singerCount; s++) {
+        singerQuery.bindValue(":name", QString("Singer %1").arg(s + 1, 4, 10, QChar('0')));
+        singerQuery.bindValue(":pos", s);
+        singerQuery.bindValue(":addts", historyEpoch.addSecs(s * 60));
+        if (!singerQuery.exec()) {
+            qWarning() << "Rotation insert failed:" << singerQuery.lastError().text();
+            continue;
+        }
+        int singerId = singerQuery.lastInsertId().toInt();
+        for (int q = 0; q < queueSize && m_catalogSize > 0; q++) {
+            songQuery.bindValue(":singerId", singerId);
+            songQuery.bindValue(":songId", static_cast<int>(m_rng.bounded(1, m_catalogSize + 1)));
+            songQuery.bindValue(":key", static_cast<int>(m_rng.bounded(-3, 4)));
+            songQuery.bindValue(":position", q);
+            songQuery.exec();
+        }
+    }
+    singerQuery.exec("COMMIT");
+}
+
+void SyntheticLibrary::populateHistory(int singerCount, int songsPerSinger)
+{
+    struct CatalogRow {
+        QString path;
+        QString artist;
+        QString title;
+        QString discId;
+    };
+    std::vector<CatalogRow> catalog;
+    catalog.reserve(m_catalogSize);
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.exec("SELECT path, artist, title, discid FROM dbsongs ORDER BY songid");
+    while (query.next())
+        catalog.emplace_back(CatalogRow{query.value(0).toString(), query.value(1).toString(),
+                                        query.value(2).toString(), query.value(3).toString()});
+    if (catalog.empty())
+        return;
+
+    QSqlQuery singerQuery;
+    QSqlQuery songQuery;
+    singerQuery.exec("BEGIN TRANSACTION");
+    singerQuery.prepare("INSERT INTO historySingers (name) VALUES( :name )");
+    songQuery.prepare("INSERT INTO historySongs (historySinger, filepath, artist, title, songid, keychange, plays, lastplay) "
+                      "values (:historySinger, :filepath, :artist, :title, :songid, :keychange, :plays, :datetime)");
+    for (int s = 0; s < singerCount; s++) {
+        singerQuery.bindValue(":name", QString("History Singer %1").arg(s + 1, 5, 10, QChar('0')));
+        if (!singerQuery.exec()) {
+            qWarning() << "History singer insert failed:" << singerQuery.lastError().text();
+            continue;
+        }
+        int historySingerId = singerQuery.lastInsertId().toInt();
+        for (int h = 0; h < songsPerSinger; h++) {
+            const auto &row = catalog.at(m_rng.bounded(static_cast<quint32>(catalog.size())));
+            songQuery.bindValue(":historySinger", historySingerId);
+            songQuery.bindValue(":filepath", row.path);
+            songQuery.bindValue(":artist", row.artist);
+            songQuery.bindValue(":title", row.title);
+            songQuery.bindValue(":songid", row.discId);
+            songQuery.bindValue(":keychange", static_cast<int>(m_rng.bounded(-3, 4)));
+            songQuery.bindValue(":plays", static_cast<int>(m_rng.bounded(1, 12)));
+            songQuery.bindValue(":datetime", historyEpoch.addSecs(m_rng.bounded(365 * 86400)));
+            songQuery.exec();
+        }
+    }
+    singerQuery.exec("COMMIT");
+}
+
+QStringList SyntheticLibrary::writeKaraokeZips(const QString &dirPath, int fileCount, int songSeconds)
+{
+    QStringList files;
+    QDir().mkpath(dirPath);
+    QByteArray wav = wavData(songSeconds);
+    for (int i = 0; i < fileCount; i++) {
+        // Spread the files over a few subdirectories so the scan has to recurse
+        QString subDir = dirPath + QDir::separator() + QString("disc%1").arg(i / 250, 3, 10, QChar('0'));
+        QDir().mkpath(subDir);
+        QString baseName = songId(i) + " - " + artistName(i / 12) + " - " + songTitle(i);
+        QString zipPath = subDir + QDir::separator() + baseName + ".zip";
+        QByteArray cdg = cdgData(songSeconds);
+        mz_zip_archive archive;
+        memset(&archive, 0, sizeof(archive));
+        if (!mz_zip_writer_init_file(&archive, zipPath.toLocal8Bit().constData(), 0)) {
+            qWarning() << "Unable to create" << zipPath;
+            continue;
+        }
+        bool ok = mz_zip_writer_add_mem(&archive, QString(baseName + ".cdg").toLocal8Bit().constData(),
+                                        cdg.constData(), cdg.size(), MZ_DEFAULT_COMPRESSION);
+        ok = ok && mz_zip_writer_add_mem(&archive, QString(baseName + ".wav").toLocal8Bit().constData(),
+                                         wav.constData(), wav.size(), MZ_DEFAULT_COMPRESSION);
+        ok = ok && mz_zip_writer_finalize_archive(&archive);
+        mz_zip_writer_end(&archive);
+        if (ok)
+            files.append(zipPath);
+        else
+            qWarning() << "Unable to write" << zipPath;
+    }
+    return files;
+}
+
+QByteArray SyntheticLibrary::cdgData(int seconds)
+{
+    const int packetCount = seconds * cdgPacketsPerSecond;
+    QByteArray data(packetCount * cdgPacketSize, '\0');
+    auto packet = [&data](int idx) { return data.data() + (idx * cdgPacketSize); };
+    auto setPalette = [&](int idx, char instruction) {
+        char *p = packet(idx);
+        p[0] = cdgCommand;
+        p[1] = instruction;
+        for (int c = 0; c < 16; c++)
+            p[4 + c] = static_cast<char>(m_rng.bounded(0x40));
+    };
+    for (int idx = 0; idx < packetCount; idx++) {
+        char *p = packet(idx);
+        // Start of every "page" clears the screen and loads a fresh palette, like a typical disc does between verses
+        int pagePos = idx % (cdgPacketsPerSecond * 20);
+        if (pagePos == 0) {
+            p[0] = cdgCommand;
+            p[1] = 1; // memory preset
+            p[4] = static_cast<char>(m_rng.bounded(16));
+            continue;
+        }
+        if (pagePos == 1) {
+            setPalette(idx, 30); // low colors
+            continue;
+        }
+        if (pagePos == 2) {
+            setPalette(idx, 31); // high colors
+            continue;
+        }
+        // About a third of the packets in real discs are empty
+        auto roll = m_rng.bounded(100);
+        if (roll < 33)
+            continue;
+        p[0] = cdgCommand;
+        if (roll < 97) {
+            p[1] = (roll < 85) ? 6 : 38; // tile block, tile block xor
+            p[4] = static_cast<char>(m_rng.bounded(16));
+            p[5] = static_cast<char>(m_rng.bounded(16));
+            p[6] = static_cast<char>(m_rng.bounded(18));
+            p[7] = static_cast<char>(m_rng.bounded(50));
+            for (int r = 0; r < 12; r++)
+                p[8 + r] = static_cast<char>(m_rng.bounded(0x40));
+        } else if (roll < 99) {
+            p[1] = 24; // scroll copy
+            p[4] = static_cast<char>(m_rng.bounded(16));
+            p[5] = static_cast<char>(0x10 | m_rng.bounded(6));
+            p[6] = static_cast<char>(0x10 | m_rng.bounded(12));
+        } else {
+            p[1] = 2; // border preset
+            p[4] = static_cast<char>(m_rng.bounded(16));
+        }
+    }
+    return data;
+}
+
+QByteArray SyntheticLibrary::wavData(int seconds)
+{
+    constexpr quint32 sampleRate{8000};
+    const quint32 dataSize = sampleRate * seconds;
+    QByteArray wav;
+    wav.reserve(44 + static_cast<int>(dataSize));
+    auto appendLE32 = [&wav](quint32 value) {
+        std::array<uchar, 4> bytes{};
+        qToLittleEndian(value, bytes.data());
+        wav.append(reinterpret_cast<const char *>(bytes.data()), 4);
+    };
+    auto appendLE16 = [&wav](quint16 value) {
+        std::array<uchar, 2> bytes{};
+        qToLittleEndian(value, bytes.data());
+        wav.append(reinterpret_cast<const char *>(bytes.data()), 2);
+    };
+    wav.append("RIFF");
+    appendLE32(36 + dataSize);
+    wav.append("WAVEfmt ");
+    appendLE32(16);
+    appendLE16(1);           // PCM
+    appendLE16(1);           // mono
+    appendLE32(sampleRate);
+    appendLE32(sampleRate);  // byte rate
+    appendLE16(1);           // block align
+    appendLE16(8);           // bits per sample
+    wav.append("data");
+    appendLE32(dataSize);
+    wav.append(QByteArray(static_cast<int>(dataSize), static_cast<char>(0x80)));
+    return wav;
+}
+
+QString SyntheticLibrary::artistName(int index) const
+{
+    const int wordCount = m_words.size();
+    return m_words.at(index % wordCount) + ' ' + m_words.at(((index / wordCount) * 7 + index * 3 + 1) % wordCount);
+}
+
+QString SyntheticLibrary::songTitle(int index) const
+{
+    const int wordCount = m_words.size();
+    QString title = m_words.at((index * 13 + 5) % wordCount) + ' ' + m_words.at((index / wordCount + index * 17) % wordCount);
+    if (index % 3 == 0)
+        title.append(' ' + m_words.at((index / (wordCount * wordCount) + index) % wordCount));
+    return title;
+}
+
+QString SyntheticLibrary::songId(int index)
+{
+    return QString("SYN%1-%2").arg(index / 20 + 1, 5, 10, QChar('0')).arg(index % 20 + 1, 2, 10, QChar('0'));
+}
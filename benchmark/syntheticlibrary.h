@@ -0,0 +1,46 @@
+#ifndef SYNTHETICLIBRARY_H
+#define SYNTHETICLIBRARY_H
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+
+// Deterministic generator for the data sets used by openkj-bench.
+// Everything is derived from the seed so two runs with the same seed (and the same build) operate on the same data.
+// All database writes go to the default QSqlDatabase connection, which must already be open.
+class SyntheticLibrary
+{
+public:
+    explicit SyntheticLibrary(quint32 seed);
+
+    // Creates the same tables and columns MainWindow::dbInit ends up with at user_version 110.
+    // Keep this in step with the migrations there, the models and DbUpdater query columns that only newer schemas have.
+    static bool createSchema();
+
+    // Adds songCount rows to dbsongs, around a third of them with play history.  Paths don't exist on disk.
+    // Returns false if any insert failed.
+    bool populateCatalog(int songCount);
+    // Adds singerCount rotation singers with queueSize unplayed songs each, picked from the current catalog
+    void populateRotation(int singerCount, int queueSize);
+    // Adds singerCount history singers with songsPerSinger history entries each
+    void populateHistory(int singerCount, int songsPerSinger);
+    // Writes fileCount zip files holding a synthetic cdg and a silent wav, named "SongID - Artist - Title.zip"
+    QStringList writeKaraokeZips(const QString &dirPath, int fileCount, int songSeconds);
+
+    // Valid CDG subcode stream of the given length with memory presets, palette loads, tile draws and scrolls
+    QByteArray cdgData(int seconds);
+    // 8kHz mono 8-bit PCM wav of silence
+    static QByteArray wavData(int seconds);
+
+    [[nodiscard]] QString artistName(int index) const;
+    [[nodiscard]] QString songTitle(int index) const;
+    [[nodiscard]] static QString songId(int index);
+
+private:
+    QRandomGenerator m_rng;
+    int m_catalogSize{0};
+    QStringList m_words;
+};
+
+#endif // SYNTHETICLIBRARY_H
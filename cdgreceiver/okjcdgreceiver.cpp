@@ -0,0 +1,84 @@
+// Reference display client for OpenKJ's CDG mirroring.
+//
+// Listens for the CDG packet stream that OpenKJ sends out when "Mirror CDG graphics to network displays" is turned
+// on, decodes it the same way OpenKJ does and keeps the current frame up to date.  It's headless on purpose: it
+// reports sync state and packet statistics on stderr and can write the frame out as a PNG, which is enough to check
+// a network setup and to serve as a starting point for a real display client.
+//
+// Run it on the OpenKJ machine against 127.0.0.1 (with OpenKJ's mirror address set to 127.0.0.1 as well) to try it
+// out without any network in between.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QTextStream>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "src/cdg/cdgmirror.h"
+
+int main(int argc, char *argv[])
+{
+    // CdgPacketReceiver grabs the "logger" logger on construction
+    auto stderrSink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("logger", stderrSink);
+    logger->set_level(spdlog::level::info);
+    spdlog::register_logger(logger);
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("openkj-cdg-receiver");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("OpenKJ CDG mirror receiver");
+    parser.addHelpOption();
+    QCommandLineOption addressOption({"a", "address"}, "Multicast group or local address to listen on.", "address", "239.255.42.99");
+    QCommandLineOption portOption({"p", "port"}, "UDP port to listen on.", "port", QString::number(cdgmirror::defaultPort));
+    QCommandLineOption snapshotOption({"s", "snapshot"}, "Write the current frame to this PNG file once a second while it changes.", "file");
+    QCommandLineOption statsOption("stats", "Print receive statistics once a second.");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Log stream and sync changes.");
+    parser.addOptions({addressOption, portOption, snapshotOption, statsOption, verboseOption});
+    parser.process(app);
+
+    if (parser.isSet(verboseOption))
+        logger->set_level(spdlog::level::debug);
+    QHostAddress address(parser.value(addressOption));
+    bool portOk{false};
+    auto port = parser.value(portOption).toUShort(&portOk);
+    if (address.isNull() || !portOk || port == 0) {
+        QTextStream(stderr) << "Invalid address or port\n";
+        return 1;
+    }
+
+    CdgPacketReceiver receiver;
+    if (!receiver.listen(address, port))
+        return 1;
+
+    bool frameDirty{false};
+    QObject::connect(&receiver, &CdgPacketReceiver::frameChanged, [&frameDirty] () { frameDirty = true; });
+    QObject::connect(&receiver, &CdgPacketReceiver::streamEnded, [] () {
+        QTextStream(stderr) << "Stream ended\n";
+    });
+
+    QTimer reportTimer;
+    QObject::connect(&reportTimer, &QTimer::timeout, [&] () {
+        if (frameDirty && parser.isSet(snapshotOption)) {
+            frameDirty = false;
+            if (!receiver.currentImage().save(parser.value(snapshotOption), "PNG"))
+                QTextStream(stderr) << "Unable to write " << parser.value(snapshotOption) << "\n";
+        }
+        if (parser.isSet(statsOption)) {
+            const auto &stats = receiver.stats();
+            QTextStream(stderr) << (receiver.isSynced() ? "synced" : "waiting for keyframe")
+                                << "  datagrams: " << stats.datagrams
+                                << "  packets: " << stats.packetsApplied
+                                << "  keyframes: " << stats.keyframesApplied
+                                << "  gaps: " << stats.gaps
+                                << "  reordered: " << stats.reordered
+                                << "  bad: " << stats.badDatagrams << "\n";
+        }
+    });
+    reportTimer.start(1000);
+
+    return QCoreApplication::exec();
+}
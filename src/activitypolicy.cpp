@@ -0,0 +1,69 @@
+#include "activitypolicy.h"
+
+#include <algorithm>
+
+ActivityPolicy &ActivityPolicy::instance()
+{
+    static ActivityPolicy policy;
+    return policy;
+}
+
+ActivityPolicy::ActivityPolicy()
+{
+    m_logger = spdlog::get("logger");
+    m_lastInput.start();
+    m_idleCheckTimer.setSingleShot(true);
+    connect(&m_idleCheckTimer, &QTimer::timeout, this, &ActivityPolicy::checkIdle);
+    scheduleIdleCheck();
+}
+
+void ActivityPolicy::userActivity()
+{
+    m_lastInput.restart();
+    if (m_idle)
+    {
+        setIdle(false);
+        scheduleIdleCheck();
+    }
+}
+
+void ActivityPolicy::setPlaybackActive(const QObject *source, bool active)
+{
+    if (active)
+    {
+        m_activePlayback.insert(source);
+        m_idleCheckTimer.stop();
+        setIdle(false);
+        return;
+    }
+    if (m_activePlayback.remove(source) && m_activePlayback.isEmpty())
+        scheduleIdleCheck();
+}
+
+void ActivityPolicy::scheduleIdleCheck()
+{
+    // The check runs once, when the idle period would end, rather than polling.  Input in the meantime only moves
+    // m_lastInput and the check reschedules itself for the remainder.
+    if (m_idle || !m_activePlayback.isEmpty() || m_idleCheckTimer.isActive())
+        return;
+    m_idleCheckTimer.start(static_cast<int>(std::max(m_idleAfterMs - m_lastInput.elapsed(), static_cast<qint64>(0))));
+}
+
+void ActivityPolicy::checkIdle()
+{
+    if (!m_activePlayback.isEmpty())
+        return;
+    if (m_lastInput.elapsed() >= m_idleAfterMs)
+        setIdle(true);
+    else
+        scheduleIdleCheck();
+}
+
+void ActivityPolicy::setIdle(bool idle)
+{
+    if (m_idle == idle)
+        return;
+    m_idle = idle;
+    m_logger->debug("{} Application is now {}", m_loggingPrefix, idle ? "idle, backing off timers" : "active, restoring timers");
+    emit idleChanged(idle);
+}
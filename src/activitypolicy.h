@@ -0,0 +1,46 @@
+#ifndef ACTIVITYPOLICY_H
+#define ACTIVITYPOLICY_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Decides when the application is idle: nothing is playing and there has been no keyboard or mouse input for a
+// while.  Timers that only matter while someone is watching or listening use idleChanged() to back off or stop,
+// and get their full rate back as soon as playback starts or the user touches the mouse or keyboard.
+// Only meant to be used from the GUI thread.
+class ActivityPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    static ActivityPolicy &instance();
+    [[nodiscard]] bool isIdle() const { return m_idle; }
+    // Called for every input event, keep it cheap
+    void userActivity();
+    void setPlaybackActive(const QObject *source, bool active);
+
+signals:
+    void idleChanged(bool idle);
+
+private:
+    ActivityPolicy();
+    std::string m_loggingPrefix{"[ActivityPolicy]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    QElapsedTimer m_lastInput;
+    QTimer m_idleCheckTimer;
+    QSet<const QObject*> m_activePlayback;
+    bool m_idle{false};
+    const int m_idleAfterMs{60000};
+
+    void scheduleIdleCheck();
+    void checkIdle();
+    void setIdle(bool idle);
+};
+
+#endif // ACTIVITYPOLICY_H
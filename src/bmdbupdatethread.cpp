@@ -81,6 +81,7 @@ void BmDbUpdateThread::run()
     database.open();
     qInfo() << database.lastError();
     TagReader reader;
+    reader.setReadMode(TagReader::ReadMode::EstimatedDuration);
     emit progressChanged(0, 0);
     emit progressMessage("Getting list of files in " + m_path);
     emit stateChanged("Finding media files...");
@@ -126,6 +127,7 @@ void BmDbUpdateThread::run()
 void BmDbUpdateThread::startUnthreaded()
 {
     TagReader reader;
+    reader.setReadMode(TagReader::ReadMode::EstimatedDuration);
     emit progressChanged(0, 0);
     emit progressMessage("Getting list of files in " + m_path);
     emit stateChanged("Finding media files...");
@@ -64,6 +64,12 @@ int CdgAppSrc::positionOfFinalFrameMS()
     return m_cdgFileReader ? m_cdgFileReader->positionOfFinalFrameMS() : -1;
 }
 
+QByteArray CdgAppSrc::packetData()
+{
+    QMutexLocker locker(&m_cdgFileReaderLock);
+    return m_cdgFileReader ? m_cdgFileReader->packetData() : QByteArray();
+}
+
 void CdgAppSrc::cb_need_data(GstAppSrc *appsrc, [[maybe_unused]]guint unused_size, gpointer user_data)
 {
     auto instance = reinterpret_cast<CdgAppSrc *>(user_data);
@@ -40,6 +40,11 @@ public:
      */
     int positionOfFinalFrameMS();
 
+    /**
+     * The raw subcode packets of the loaded file, empty if nothing is loaded.
+     */
+    QByteArray packetData();
+
 signals:
 
 };
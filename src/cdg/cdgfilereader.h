@@ -45,6 +45,11 @@ public:
      */
     int positionOfFinalFrameMS();
 
+    /**
+     * The raw subcode packets of the whole file.
+     */
+    [[nodiscard]] const QByteArray &packetData() const { return m_cdgData; }
+
 #ifdef QT_DEBUG
     [[maybe_unused]] void saveNextImgToFile();
     [[maybe_unused]] void saveCurrentImgToFile();
@@ -14,7 +14,9 @@ public:
 
     void copyCroppedImagedata(uchar *destbuffer);
 
-    QImage getImage() { return m_image; }
+    QImage getImage() const { return m_image; }
+    [[nodiscard]] int horizontalOffset() const { return m_curHOffset; }
+    [[nodiscard]] int verticalOffset() const { return m_curVOffset; }
 
 private:
 
@@ -0,0 +1,420 @@
+#include "cdgmirror.h"
+
+#include <QDataStream>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace cdgmirror {
+
+QByteArray encodeHeader(const Header &header)
+{
+    QByteArray bytes;
+    bytes.reserve(headerSize);
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream << magic << version << header.type << header.flags << quint8(0) << header.streamId << header.sequence
+           << header.positionMs << header.firstPacket << header.part << header.parts;
+    return bytes;
+}
+
+bool decodeHeader(const QByteArray &datagram, Header &header)
+{
+    if (datagram.size() < headerSize || (datagram.size() - headerSize) % packetSize != 0)
+        return false;
+    QDataStream stream(datagram);
+    stream.setByteOrder(QDataStream::BigEndian);
+    quint32 datagramMagic{0};
+    quint8 datagramVersion{0};
+    quint8 reserved{0};
+    stream >> datagramMagic >> datagramVersion >> header.type >> header.flags >> reserved >> header.streamId
+           >> header.sequence >> header.positionMs >> header.firstPacket >> header.part >> header.parts;
+    return datagramMagic == magic && datagramVersion == version && header.type <= End && header.part < header.parts;
+}
+
+namespace {
+cdg::CDG_SubCode makePacket(const cdg::CdgCommand instruction)
+{
+    cdg::CDG_SubCode packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.command = static_cast<cdg::CdgCommand>(0x09);
+    packet.instruction = instruction;
+    return packet;
+}
+
+void appendPacket(QByteArray &packets, const cdg::CDG_SubCode &packet)
+{
+    packets.append(reinterpret_cast<const char*>(&packet), packetSize);
+}
+}
+
+QByteArray keyframePackets(const CdgImageFrame &frame)
+{
+    constexpr int tileWidth{6};
+    constexpr int tileHeight{12};
+    const auto image = frame.getImage();
+    QByteArray packets;
+
+    auto preset = makePacket(cdg::CmdMemoryPreset);
+    appendPacket(packets, preset);
+
+    // Colors are 4 bits per channel, packed as 00RRRRGG 00GGBBBB
+    for (int table = 0; table < 2; table++)
+    {
+        auto colors = makePacket(table == 0 ? cdg::CmdColorsLow : cdg::CmdColorsHigh);
+        for (int i = 0; i < 8; i++)
+        {
+            QColor color(image.color(table * 8 + i));
+            int red = color.red() / 17;
+            int green = color.green() / 17;
+            int blue = color.blue() / 17;
+            colors.data[i * 2] = static_cast<char>((red << 2) | (green >> 2));
+            colors.data[i * 2 + 1] = static_cast<char>(((green & 0x03) << 4) | blue);
+        }
+        appendPacket(packets, colors);
+    }
+
+    // A tile block only carries two colors, so each tile is drawn one bit plane of the color index at a time.  The
+    // first plane that has any pixels set overwrites the tile, the rest are XORed on top of it.  Blank tiles are
+    // already taken care of by the memory preset.
+    for (int row = 0; row < cdg::FRAME_DIM_FULL.height() / tileHeight; row++)
+    {
+        for (int column = 0; column < cdg::FRAME_DIM_FULL.width() / tileWidth; column++)
+        {
+            bool firstPlane{true};
+            for (int plane = 0; plane < 4; plane++)
+            {
+                auto tile = makePacket(cdg::CmdTileBlock);
+                bool planeUsed{false};
+                for (int y = 0; y < tileHeight; y++)
+                {
+                    auto line = image.constScanLine(row * tileHeight + y) + column * tileWidth;
+                    char bits{0};
+                    for (int x = 0; x < tileWidth; x++)
+                    {
+                        if ((line[x] >> plane) & 0x01)
+                            bits |= static_cast<char>(0x20 >> x);
+                    }
+                    tile.data[4 + y] = bits;
+                    planeUsed |= bits != 0;
+                }
+                if (!planeUsed)
+                    continue;
+                if (!firstPlane)
+                    tile.instruction = cdg::CmdTileBlockXOR;
+                tile.data[1] = static_cast<char>(1 << plane);
+                tile.data[2] = static_cast<char>(row);
+                tile.data[3] = static_cast<char>(column);
+                appendPacket(packets, tile);
+                firstPlane = false;
+            }
+        }
+    }
+
+    // A scroll preset with no scroll commands just sets the display offsets
+    auto scroll = makePacket(cdg::CmdScrollPreset);
+    scroll.data[1] = static_cast<char>(frame.horizontalOffset() & 0x07);
+    scroll.data[2] = static_cast<char>(frame.verticalOffset() & 0x0F);
+    appendPacket(packets, scroll);
+    return packets;
+}
+
+}
+
+CdgPacketPublisher::CdgPacketPublisher(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+}
+
+bool CdgPacketPublisher::setDestination(const QHostAddress &address, quint16 port)
+{
+    m_enabled = false;
+    if (address.isNull() || port == 0)
+    {
+        m_logger->warn("{} Invalid mirror destination, CDG mirroring disabled", m_loggingPrefix);
+        return false;
+    }
+    m_address = address;
+    m_port = port;
+    if (address.isMulticast())
+        m_socket.setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+    m_enabled = true;
+    m_logger->info("{} Mirroring CDG packets to {}:{}", m_loggingPrefix, address.toString().toStdString(), port);
+    return true;
+}
+
+void CdgPacketPublisher::startStream(const QByteArray &packetData)
+{
+    m_packetData = packetData;
+    m_frame = CdgImageFrame();
+    m_framePacket = 0;
+    m_nextPacket = 0;
+    m_sequence = 0;
+    m_streamId = QRandomGenerator::global()->generate();
+    m_lastKeyframe.invalidate();
+    m_logger->debug("{} Starting stream {} with {} packets", m_loggingPrefix, m_streamId, packetCount());
+}
+
+void CdgPacketPublisher::publish(const qint64 positionMs, const bool playing)
+{
+    if (!m_enabled || m_packetData.isEmpty())
+        return;
+    auto positionPacket = std::min(cdgmirror::packetIndexAt(positionMs), packetCount());
+    // The reported position wobbles a little, only a real jump counts as a seek.  Going forward, anything past
+    // what's already gone out means receivers are missing packets and need a keyframe anyway.
+    bool seekedBack = positionPacket + cdgmirror::packetsPerSecond / 2 < m_framePacket;
+    bool seekedForward = positionPacket > m_nextPacket;
+    if (seekedBack)
+    {
+        m_frame = CdgImageFrame();
+        m_framePacket = 0;
+    }
+    advanceFrameTo(positionPacket);
+    if (!m_lastKeyframe.isValid() || seekedBack || seekedForward)
+    {
+        m_nextPacket = m_framePacket;
+        sendKeyframe(positionMs, playing, true);
+    }
+    else if (m_lastKeyframe.hasExpired(m_keyframeIntervalMs))
+        sendKeyframe(positionMs, playing, false);
+
+    cdgmirror::Header header;
+    header.type = cdgmirror::Packets;
+    header.flags = playing ? cdgmirror::FlagPlaying : 0;
+    header.positionMs = static_cast<quint32>(positionMs);
+    auto lastPacket = std::min(cdgmirror::packetIndexAt(positionMs + m_leadMs), packetCount());
+    do
+    {
+        auto count = std::clamp<qint64>(lastPacket - m_nextPacket, 0, cdgmirror::maxPacketsPerDatagram);
+        header.firstPacket = static_cast<quint32>(m_nextPacket);
+        send(header, m_packetData.mid(static_cast<int>(m_nextPacket * cdgmirror::packetSize), static_cast<int>(count * cdgmirror::packetSize)));
+        m_nextPacket += count;
+    } while (m_nextPacket < lastPacket);
+}
+
+void CdgPacketPublisher::endStream()
+{
+    if (m_packetData.isEmpty())
+        return;
+    if (m_enabled)
+    {
+        cdgmirror::Header header;
+        header.type = cdgmirror::End;
+        header.firstPacket = static_cast<quint32>(m_nextPacket);
+        send(header, QByteArray());
+    }
+    m_logger->debug("{} Ended stream {}", m_loggingPrefix, m_streamId);
+    m_packetData.clear();
+}
+
+void CdgPacketPublisher::advanceFrameTo(const qint64 packetIndex)
+{
+    cdg::CDG_SubCode subCode;
+    for (; m_framePacket < packetIndex; m_framePacket++)
+    {
+        memcpy(&subCode, m_packetData.constData() + m_framePacket * cdgmirror::packetSize, cdgmirror::packetSize);
+        m_frame.applySubCode(subCode);
+    }
+}
+
+void CdgPacketPublisher::sendKeyframe(const qint64 positionMs, const bool playing, const bool resync)
+{
+    m_lastKeyframe.start();
+    auto packets = cdgmirror::keyframePackets(m_frame);
+    cdgmirror::Header header;
+    header.type = cdgmirror::Keyframe;
+    header.flags = (playing ? cdgmirror::FlagPlaying : 0) | (resync ? cdgmirror::FlagResync : 0);
+    header.positionMs = static_cast<quint32>(positionMs);
+    header.firstPacket = static_cast<quint32>(m_framePacket);
+    constexpr int chunkSize{cdgmirror::maxPacketsPerDatagram * cdgmirror::packetSize};
+    header.parts = static_cast<quint16>((packets.size() + chunkSize - 1) / chunkSize);
+    for (header.part = 0; header.part < header.parts; header.part++)
+        send(header, packets.mid(header.part * chunkSize, chunkSize));
+    m_logger->trace("{} Sent {}keyframe at packet {} in {} datagrams", m_loggingPrefix, resync ? "resync " : "",
+                    m_framePacket, header.parts);
+}
+
+void CdgPacketPublisher::send(cdgmirror::Header header, const QByteArray &payload)
+{
+    header.streamId = m_streamId;
+    header.sequence = m_sequence++;
+    auto datagram = cdgmirror::encodeHeader(header) + payload;
+    if (m_socket.writeDatagram(datagram, m_address, m_port) < 0)
+        m_logger->trace("{} Unable to send datagram: {}", m_loggingPrefix, m_socket.errorString().toStdString());
+}
+
+CdgPacketReceiver::CdgPacketReceiver(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+    connect(&m_socket, &QUdpSocket::readyRead, this, &CdgPacketReceiver::readDatagrams);
+    connect(&m_applyTimer, &QTimer::timeout, this, &CdgPacketReceiver::applyDuePackets);
+    m_applyTimer.setTimerType(Qt::PreciseTimer);
+}
+
+bool CdgPacketReceiver::listen(const QHostAddress &address, quint16 port)
+{
+    bool multicast = address.isMulticast();
+    auto bindAddress = multicast ? QHostAddress(QHostAddress::AnyIPv4) : address;
+    if (!m_socket.bind(bindAddress, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+    {
+        m_logger->error("{} Unable to listen on {}:{}: {}", m_loggingPrefix, address.toString().toStdString(), port, m_socket.errorString().toStdString());
+        return false;
+    }
+    if (multicast && !m_socket.joinMulticastGroup(address))
+    {
+        m_logger->error("{} Unable to join multicast group {}: {}", m_loggingPrefix, address.toString().toStdString(), m_socket.errorString().toStdString());
+        return false;
+    }
+    m_logger->info("{} Listening for CDG packets on {}:{}", m_loggingPrefix, address.toString().toStdString(), port);
+    m_applyTimer.start(10);
+    return true;
+}
+
+QImage CdgPacketReceiver::currentImage()
+{
+    std::array<uchar, cdg::CDG_IMAGE_SIZE> data{0};
+    m_frame.copyCroppedImagedata(data.data());
+    QImage image(data.data(), cdg::FRAME_DIM_CROPPED.width(), cdg::FRAME_DIM_CROPPED.height(),
+                 cdg::FRAME_DIM_CROPPED.width(), QImage::Format_Indexed8);
+    image.setColorTable(m_frame.getImage().colorTable());
+    return image.copy();
+}
+
+void CdgPacketReceiver::readDatagrams()
+{
+    while (m_socket.hasPendingDatagrams())
+        handleDatagram(m_socket.receiveDatagram().data());
+    applyDuePackets();
+}
+
+void CdgPacketReceiver::handleDatagram(const QByteArray &datagram)
+{
+    cdgmirror::Header header;
+    if (!cdgmirror::decodeHeader(datagram, header))
+    {
+        m_stats.badDatagrams++;
+        return;
+    }
+    m_stats.datagrams++;
+    if (header.streamId != m_streamId)
+    {
+        if (header.type == cdgmirror::End)
+            return;
+        m_logger->debug("{} New stream {}", m_loggingPrefix, header.streamId);
+        resetStream(header.streamId);
+    }
+    if (header.type == cdgmirror::End)
+    {
+        m_logger->debug("{} Stream {} ended", m_loggingPrefix, header.streamId);
+        resetStream(0);
+        emit frameChanged();
+        emit streamEnded();
+        return;
+    }
+    // Datagrams can arrive out of order, only the newest one moves the clock
+    if (m_sinceSenderPosition.isValid() && header.sequence < m_lastSequence)
+        m_stats.reordered++;
+    else
+    {
+        m_lastSequence = header.sequence;
+        m_senderPositionMs = header.positionMs;
+        m_senderPlaying = header.flags & cdgmirror::FlagPlaying;
+        m_sinceSenderPosition.start();
+    }
+
+    auto payload = datagram.constData() + cdgmirror::headerSize;
+    int count = (datagram.size() - cdgmirror::headerSize) / cdgmirror::packetSize;
+    if (header.type == cdgmirror::Keyframe)
+    {
+        // Only needed to get in sync, or to follow the sender through a seek
+        if (m_synced && !(header.flags & cdgmirror::FlagResync))
+            return;
+        if (m_keyframe.firstPacket != header.firstPacket || m_keyframe.parts != header.parts)
+        {
+            m_keyframe.firstPacket = header.firstPacket;
+            m_keyframe.parts = header.parts;
+            m_keyframe.received.clear();
+        }
+        m_keyframe.received.insert(header.part, QByteArray(payload, count * cdgmirror::packetSize));
+        if (m_keyframe.received.size() == m_keyframe.parts)
+            applyKeyframe();
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        qint64 index = header.firstPacket + i;
+        if (m_synced && index < m_nextPacket)
+            continue;
+        cdg::CDG_SubCode subCode;
+        memcpy(&subCode, payload + i * cdgmirror::packetSize, cdgmirror::packetSize);
+        m_pending[index] = subCode;
+    }
+}
+
+void CdgPacketReceiver::applyKeyframe()
+{
+    m_frame = CdgImageFrame();
+    cdg::CDG_SubCode subCode;
+    for (quint16 part = 0; part < m_keyframe.parts; part++)
+    {
+        const auto &packets = m_keyframe.received[part];
+        for (int offset = 0; offset + cdgmirror::packetSize <= packets.size(); offset += cdgmirror::packetSize)
+        {
+            memcpy(&subCode, packets.constData() + offset, cdgmirror::packetSize);
+            m_frame.applySubCode(subCode);
+        }
+    }
+    m_nextPacket = m_keyframe.firstPacket;
+    m_pending.erase(m_pending.begin(), m_pending.lower_bound(m_nextPacket));
+    m_keyframe = KeyframeParts();
+    m_synced = true;
+    m_stats.keyframesApplied++;
+    m_logger->debug("{} Synced at packet {}", m_loggingPrefix, m_nextPacket);
+    emit frameChanged();
+}
+
+void CdgPacketReceiver::applyDuePackets()
+{
+    if (!m_synced || !m_sinceSenderPosition.isValid())
+        return;
+    auto clockMs = m_senderPositionMs + (m_senderPlaying ? m_sinceSenderPosition.elapsed() : 0);
+    auto duePacket = cdgmirror::packetIndexAt(clockMs);
+    bool changed{false};
+    while (!m_pending.empty() && m_pending.begin()->first < duePacket)
+    {
+        auto it = m_pending.begin();
+        if (it->first < m_nextPacket)
+        {
+            m_pending.erase(it);
+            continue;
+        }
+        if (it->first > m_nextPacket)
+        {
+            // A packet that's due never arrived, the frame can't be trusted until the next keyframe
+            m_logger->debug("{} Lost packets {} to {}, waiting for a keyframe", m_loggingPrefix, m_nextPacket, it->first - 1);
+            m_stats.gaps++;
+            m_synced = false;
+            break;
+        }
+        changed |= m_frame.applySubCode(it->second);
+        m_stats.packetsApplied++;
+        m_nextPacket++;
+        m_pending.erase(it);
+    }
+    if (changed)
+        emit frameChanged();
+}
+
+void CdgPacketReceiver::resetStream(const quint32 streamId)
+{
+    m_streamId = streamId;
+    m_synced = false;
+    m_nextPacket = 0;
+    m_lastSequence = 0;
+    m_pending.clear();
+    m_keyframe = KeyframeParts();
+    m_frame = CdgImageFrame();
+    m_sinceSenderPosition.invalidate();
+}
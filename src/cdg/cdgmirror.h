@@ -0,0 +1,159 @@
+#ifndef CDGMIRROR_H
+#define CDGMIRROR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QTimer>
+#include <QUdpSocket>
+#include <map>
+#include <spdlog/logger.h>
+#include "cdgimageframe.h"
+
+// Mirrors the raw CDG packet stream of the playing song to other displays over UDP (unicast, loopback or multicast).
+// The stream is only ~7.2 KB/s, a receiver decodes it with CdgImageFrame for next to no CPU.
+//
+// Every datagram starts with a fixed header in network byte order:
+//   quint32 magic 'OKJC', quint8 version, quint8 type, quint8 flags, quint8 reserved,
+//   quint32 stream id, quint32 sequence, quint32 sender playback position (ms), quint32 first packet index,
+//   quint16 part, quint16 part count
+// followed by raw 24 byte CDG packets.
+//  - Packets datagrams carry consecutive packets starting at the first packet index, sent a little ahead of
+//    playback.  Receivers apply each packet once their estimate of the sender's playback position reaches it.
+//  - Keyframe datagrams carry packets that rebuild the screen as of the first packet index on a blank frame.
+//    They're sent on every seek and every few seconds so late joiners and receivers that lost packets can sync.
+//  - End datagrams mean the song stopped.
+// Every tick sends a datagram even when there are no new packets, the position and playing flag keep receivers'
+// clocks in step.
+namespace cdgmirror {
+constexpr quint32 magic{0x4F4B4A43};
+constexpr quint8 version{1};
+constexpr int headerSize{28};
+constexpr int packetSize{sizeof(cdg::CDG_SubCode)};
+constexpr int packetsPerSecond{300};
+constexpr int maxPacketsPerDatagram{48};
+constexpr quint16 defaultPort{5007};
+
+enum DatagramType : quint8 {
+    Packets = 0,
+    Keyframe,
+    End
+};
+
+enum Flags : quint8 {
+    FlagPlaying = 0x01,
+    // Keyframe sent for a new stream or a seek, receivers apply it even when they're in sync
+    FlagResync = 0x02
+};
+
+struct Header {
+    quint8 type{Packets};
+    quint8 flags{0};
+    quint32 streamId{0};
+    quint32 sequence{0};
+    quint32 positionMs{0};
+    quint32 firstPacket{0};
+    quint16 part{0};
+    quint16 parts{1};
+};
+
+QByteArray encodeHeader(const Header &header);
+bool decodeHeader(const QByteArray &datagram, Header &header);
+inline qint64 packetPositionMs(qint64 packetIndex) { return packetIndex * 1000 / packetsPerSecond; }
+inline qint64 packetIndexAt(qint64 positionMs) { return positionMs * packetsPerSecond / 1000; }
+// Packets that draw the frame's current state (palette, every non-blank tile and scroll offsets) onto a blank frame
+QByteArray keyframePackets(const CdgImageFrame &frame);
+}
+
+class CdgPacketPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CdgPacketPublisher(QObject *parent = nullptr);
+    bool setDestination(const QHostAddress &address, quint16 port);
+    void startStream(const QByteArray &packetData);
+    // Called from the playback position timer, sends whatever has come due since the last call
+    void publish(qint64 positionMs, bool playing);
+    void endStream();
+
+private:
+    std::string m_loggingPrefix{"[CdgMirror]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    QUdpSocket m_socket;
+    QHostAddress m_address;
+    quint16 m_port{cdgmirror::defaultPort};
+    bool m_enabled{false};
+    QByteArray m_packetData;
+    CdgImageFrame m_frame;
+    quint32 m_streamId{0};
+    quint32 m_sequence{0};
+    qint64 m_nextPacket{0};
+    QElapsedTimer m_lastKeyframe;
+    qint64 m_framePacket{0};
+    // Packets go out this far ahead of playback, a bit more than the backend's 250 ms position timer
+    const qint64 m_leadMs{400};
+    const qint64 m_keyframeIntervalMs{5000};
+
+    [[nodiscard]] qint64 packetCount() const { return m_packetData.size() / cdgmirror::packetSize; }
+    void advanceFrameTo(qint64 packetIndex);
+    void sendKeyframe(qint64 positionMs, bool playing, bool resync);
+    void send(cdgmirror::Header header, const QByteArray &payload);
+};
+
+class CdgPacketReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats {
+        quint64 datagrams{0};
+        quint64 packetsApplied{0};
+        quint64 keyframesApplied{0};
+        quint64 gaps{0};
+        quint64 reordered{0};
+        quint64 badDatagrams{0};
+    };
+
+    explicit CdgPacketReceiver(QObject *parent = nullptr);
+    // Joins the multicast group when address is one, otherwise just binds the port
+    bool listen(const QHostAddress &address, quint16 port);
+    [[nodiscard]] bool isSynced() const { return m_synced; }
+    [[nodiscard]] const Stats &stats() const { return m_stats; }
+    // The visible 288x192 area with the current palette
+    [[nodiscard]] QImage currentImage();
+
+signals:
+    void frameChanged();
+    void streamEnded();
+
+private:
+    struct KeyframeParts {
+        quint32 firstPacket{0};
+        quint16 parts{0};
+        QHash<quint16, QByteArray> received;
+    };
+    std::string m_loggingPrefix{"[CdgMirrorReceiver]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    QUdpSocket m_socket;
+    QTimer m_applyTimer;
+    CdgImageFrame m_frame;
+    std::map<qint64, cdg::CDG_SubCode> m_pending;
+    KeyframeParts m_keyframe;
+    Stats m_stats;
+    quint32 m_streamId{0};
+    quint32 m_lastSequence{0};
+    bool m_synced{false};
+    qint64 m_nextPacket{0};
+    bool m_senderPlaying{false};
+    qint64 m_senderPositionMs{0};
+    QElapsedTimer m_sinceSenderPosition;
+
+    void readDatagrams();
+    void handleDatagram(const QByteArray &datagram);
+    void applyKeyframe();
+    void applyDuePackets();
+    void resetStream(quint32 streamId);
+};
+
+#endif // CDGMIRROR_H
@@ -0,0 +1,248 @@
+#include "dbexportthread.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+
+namespace {
+// Keeps file writes large without holding a whole export in memory
+constexpr int writeBufferSize{1024 * 1024};
+}
+
+DbExportThread::DbExportThread(ExportType type, const QString &savePath, QObject *parent) :
+        QThread(parent), m_type(type), m_savePath(savePath)
+{
+    m_logger = spdlog::get("logger");
+    m_dbFilePath = QSqlDatabase::database().databaseName();
+}
+
+DbExportThread::~DbExportThread()
+{
+    requestInterruption();
+    wait();
+}
+
+void DbExportThread::setHistorySingerIds(const std::vector<int> &historySingerIds)
+{
+    m_historySingerIds = historySingerIds;
+}
+
+void DbExportThread::run()
+{
+    QString connectionName = QString("dbexport-%1").arg(reinterpret_cast<quintptr>(this));
+    QString errorText;
+    bool success{false};
+    {
+        auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(m_dbFilePath);
+        if (!database.open()) {
+            errorText = database.lastError().text();
+            m_logger->error("{} Unable to open database for export: {}", m_loggingPrefix, errorText);
+        } else {
+            m_outFile.setFileName(m_savePath);
+            // The CSV keeps platform line endings like the old export did, the JSON was always written as is
+            QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
+            if (m_type == SongDbCsv)
+                mode |= QIODevice::Text;
+            if (!m_outFile.open(mode)) {
+                errorText = m_outFile.errorString();
+                m_logger->error("{} Unable to open {} for writing: {}", m_loggingPrefix, m_savePath, errorText);
+            } else {
+                m_logger->info("{} Starting export to {}", m_loggingPrefix, m_savePath);
+                m_writeBuffer.reserve(writeBufferSize);
+                if (m_type == SongDbCsv)
+                    success = exportSongDbCsv(connectionName, errorText);
+                else
+                    success = exportRegularSingersJson(connectionName, errorText);
+                m_outFile.close();
+                if (!success)
+                    m_outFile.remove();
+            }
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    bool canceled = isInterruptionRequested();
+    if (canceled)
+        m_logger->info("{} Export canceled, partial file removed", m_loggingPrefix);
+    else if (success)
+        m_logger->info("{} Export complete", m_loggingPrefix);
+    emit exportFinished(success, canceled, errorText);
+}
+
+bool DbExportThread::exportSongDbCsv(const QString &connectionName, QString &errorText)
+{
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    int total{0};
+    if (query.exec("SELECT COUNT(*) FROM dbsongs") && query.first())
+        total = query.value(0).toInt();
+    emit progressChanged(0, total);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT artist, title, discid, path FROM dbsongs ORDER BY artist, title, filename")) {
+        errorText = query.lastError().text();
+        m_logger->error("{} DB error: {}", m_loggingPrefix, errorText);
+        return false;
+    }
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    int rows{0};
+    while (query.next()) {
+        if (isInterruptionRequested())
+            return false;
+        QByteArray line;
+        line.append(csvField(query.value(0).toString())).append(',');
+        line.append(csvField(query.value(1).toString())).append(',');
+        line.append(csvField(query.value(2).toString())).append(',');
+        line.append(csvField(query.value(3).toString())).append('\n');
+        if (!bufferedWrite(line)) {
+            errorText = m_outFile.errorString();
+            return false;
+        }
+        rows++;
+        if (progressTimer.elapsed() > 200) {
+            emit progressChanged(rows, total);
+            progressTimer.restart();
+        }
+    }
+    emit progressChanged(total, total);
+    if (!bufferedWrite({}, true)) {
+        errorText = m_outFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DbExportThread::exportRegularSingersJson(const QString &connectionName, QString &errorText)
+{
+    QString singerFilter;
+    if (!m_historySingerIds.empty()) {
+        QStringList ids;
+        for (auto id : m_historySingerIds)
+            ids.append(QString::number(id));
+        singerFilter = "WHERE historySingers.id IN (" + ids.join(',') + ") ";
+    }
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    int total{0};
+    if (query.exec("SELECT COUNT(*) FROM historySingers LEFT JOIN historySongs ON historySongs.historySinger = historySingers.id " + singerFilter)
+            && query.first())
+        total = query.value(0).toInt();
+    emit progressChanged(0, total);
+    query.setForwardOnly(true);
+    // One ordered pass over all the singers and their songs, a singer with no history still gets a single row
+    if (!query.exec("SELECT historySingers.id, historySingers.name, historySongs.id, historySongs.filepath, "
+                    "historySongs.artist, historySongs.title, historySongs.songid, historySongs.keychange, "
+                    "historySongs.plays, historySongs.lastplay FROM historySingers "
+                    "LEFT JOIN historySongs ON historySongs.historySinger = historySingers.id " + singerFilter +
+                    "ORDER BY historySingers.name, historySingers.id, historySongs.id")) {
+        errorText = query.lastError().text();
+        m_logger->error("{} DB error: {}", m_loggingPrefix, errorText);
+        return false;
+    }
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    int rows{0};
+    int curSingerId{-1};
+    bool firstSong{true};
+    if (!bufferedWrite("[")) {
+        errorText = m_outFile.errorString();
+        return false;
+    }
+    while (query.next()) {
+        if (isInterruptionRequested())
+            return false;
+        QByteArray out;
+        int singerId = query.value(0).toInt();
+        if (singerId != curSingerId) {
+            if (curSingerId != -1)
+                out.append("\n            ]\n        },");
+            out.append("\n    {\n        \"name\": ").append(jsonString(query.value(1).toString()));
+            out.append(",\n        \"songs\": [");
+            curSingerId = singerId;
+            firstSong = true;
+        }
+        if (!query.value(2).isNull()) {
+            // Same keys, in the same order, that QJsonObject used to write
+            if (!firstSong)
+                out.append(',');
+            out.append("\n            {\n                \"artist\": ").append(jsonString(query.value(4).toString()));
+            out.append(",\n                \"filepath\": ").append(jsonString(query.value(3).toString()));
+            out.append(",\n                \"keychange\": ").append(QByteArray::number(query.value(7).toInt()));
+            out.append(",\n                \"lastplay\": ").append(jsonString(query.value(9).toDateTime().toString()));
+            out.append(",\n                \"plays\": ").append(QByteArray::number(query.value(8).toUInt()));
+            out.append(",\n                \"songid\": ").append(jsonString(query.value(6).toString()));
+            out.append(",\n                \"title\": ").append(jsonString(query.value(5).toString()));
+            out.append("\n            }");
+            firstSong = false;
+        }
+        if (!bufferedWrite(out)) {
+            errorText = m_outFile.errorString();
+            return false;
+        }
+        rows++;
+        if (progressTimer.elapsed() > 200) {
+            emit progressChanged(rows, total);
+            progressTimer.restart();
+        }
+    }
+    QByteArray tail = (curSingerId != -1) ? "\n            ]\n        }\n]\n" : "\n]\n";
+    emit progressChanged(total, total);
+    if (!bufferedWrite(tail, true)) {
+        errorText = m_outFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DbExportThread::bufferedWrite(const QByteArray &data, bool flush)
+{
+    m_writeBuffer.append(data);
+    if (!flush && m_writeBuffer.size() < writeBufferSize)
+        return true;
+    bool ok = (m_outFile.write(m_writeBuffer) == m_writeBuffer.size());
+    m_writeBuffer.clear();
+    if (!ok)
+        m_logger->error("{} Error writing export file: {}", m_loggingPrefix, m_outFile.errorString());
+    return ok;
+}
+
+QByteArray DbExportThread::csvField(const QString &value)
+{
+    QString escaped = value;
+    escaped.replace('"', "\"\"");
+    return '"' + escaped.toLocal8Bit() + '"';
+}
+
+QByteArray DbExportThread::jsonString(const QString &value)
+{
+    QString escaped;
+    escaped.reserve(value.size() + 2);
+    escaped.append('"');
+    for (const auto &ch : value) {
+        switch (ch.unicode()) {
+            case '"':
+                escaped.append("\\\"");
+                break;
+            case '\\':
+                escaped.append("\\\\");
+                break;
+            case '\n':
+                escaped.append("\\n");
+                break;
+            case '\r':
+                escaped.append("\\r");
+                break;
+            case '\t':
+                escaped.append("\\t");
+                break;
+            default:
+                if (ch.unicode() < 0x20)
+                    escaped.append(QString("\\u%1").arg(ch.unicode(), 4, 16, QChar('0')));
+                else
+                    escaped.append(ch);
+        }
+    }
+    escaped.append('"');
+    return escaped.toUtf8();
+}
@@ -0,0 +1,53 @@
+#ifndef DBEXPORTTHREAD_H
+#define DBEXPORTTHREAD_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Runs the song db csv export and the regular singers json export off the GUI thread.
+// Each run opens its own connection to the database file since QSqlDatabase connections can't cross threads.
+class DbExportThread : public QThread
+{
+    Q_OBJECT
+public:
+    enum ExportType {
+        SongDbCsv,
+        RegularSingersJson
+    };
+    explicit DbExportThread(ExportType type, const QString &savePath, QObject *parent = nullptr);
+    // Cancels a running export and waits for it, the owning window may be destroyed before the export finishes
+    ~DbExportThread() override;
+    // Limits the regular singers export to the given singers, all singers are exported if this is never called
+    void setHistorySingerIds(const std::vector<int> &historySingerIds);
+    void run() override;
+
+signals:
+    void progressChanged(int progress, int max);
+    void exportFinished(bool success, bool canceled, const QString &errorText);
+
+private:
+    std::string m_loggingPrefix{"[DbExportThread]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    ExportType m_type;
+    QString m_savePath;
+    QString m_dbFilePath;
+    std::vector<int> m_historySingerIds;
+    QFile m_outFile;
+    QByteArray m_writeBuffer;
+
+    bool exportSongDbCsv(const QString &connectionName, QString &errorText);
+    bool exportRegularSingersJson(const QString &connectionName, QString &errorText);
+    bool bufferedWrite(const QByteArray &data, bool flush = false);
+    static QByteArray csvField(const QString &value);
+    static QByteArray jsonString(const QString &value);
+};
+
+#endif // DBEXPORTTHREAD_H
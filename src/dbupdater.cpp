@@ -21,14 +21,25 @@
 #define SQL(...) #__VA_ARGS__
 #include "dbupdater.h"
 #include <array>
+#include <mutex>
 #include <QSqlQuery>
 #include <QFileInfo>
 #include <QDir>
 #include <QDirIterator>
 #include <QStandardPaths>
 #include <QApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include "mzarchive.h"
 #include "karaokefileinfo.h"
+#include "karaokefilepatternresolver.h"
+#include "okjutil.h"
+
+namespace {
+// Shared by full scans and pattern re-application, both rewrite dbsongs rows under the same source paths
+std::mutex scannerMutex;
+}
 
 DbUpdater::DbUpdater(QObject *parent) :
         QObject(parent) {
@@ -43,14 +54,15 @@ bool DbUpdater::process(const QList<QString> &paths, ProcessingOptions options)
     // Even though the program is primarily single threaded, excessive use of
     // QApplication::processEvents can cause reentrant calls.
 
-    static std::mutex mutex;
-    if (!mutex.try_lock()) {
+    if (!scannerMutex.try_lock()) {
         m_errors.append("Scanner already running");
         return false;
     }
-    const std::lock_guard<std::mutex> locker(mutex, std::adopt_lock);
+    const std::lock_guard<std::mutex> locker(scannerMutex, std::adopt_lock);
 
     m_missingFilesSongIds.clear();
+    m_companionAudio.clear();
+    m_companionAudioUpdates.clear();
     setPaths(paths);
 
     emit stateChanged("Scanning disk for files...");
@@ -99,6 +111,11 @@ bool DbUpdater::process(const QList<QString> &paths, ProcessingOptions options)
                 // will be properly added (upserted) to the database.
                 newFilesOnDisk.append(diskEnumerator.CurrentFile);
             }
+            else if (comp_result == 0) {
+                auto audioPath = m_companionAudio.value(diskEnumerator.CurrentFile);
+                if (audioPath != dbEnumerator.CurrentRecord.audioPath)
+                    m_companionAudioUpdates.append({dbEnumerator.CurrentRecord.id, audioPath});
+            }
         }
 
         if (comp_result <= 0) {
@@ -122,6 +139,7 @@ bool DbUpdater::process(const QList<QString> &paths, ProcessingOptions options)
     }
 
     addFilesToDatabase(newFilesOnDisk);
+    updateCompanionAudio();
 
     if (options.testFlag(PrepareForRemovalOfMissing)) {
         m_missingFilesSongIds.reserve(filesMissingOnDisk.size());
@@ -146,16 +164,20 @@ void DbUpdater::addFilesToDatabase(const QList<QString> &files)
     query.exec("PRAGMA temp_store=2");
     query.exec("BEGIN TRANSACTION");
     query.prepare(SQL(
-            INSERT INTO dbSongs (discid, artist, title, path, filename, duration, searchstring)
-            VALUES(:discid, :artist, :title, :path, :filename, :duration, :searchstring)
+            INSERT INTO dbSongs (discid, artist, title, path, filename, duration, searchstring, audiopath)
+            VALUES(:discid, :artist, :title, :path, :filename, :duration, :searchstring, :audiopath)
             ON CONFLICT(path) DO UPDATE SET
                 discid = :discid,
                 artist = :artist,
                 title = :title,
                 filename = :filename,
                 duration = :duration,
-                searchstring = :searchstring
+                searchstring = :searchstring,
+                audiopath = :audiopath
            ));
+    // Used to tell inserts from upserts of existing rows so the song model can be updated in place
+    QSqlQuery existingQuery;
+    existingQuery.prepare("SELECT songid FROM dbSongs WHERE path = :path");
 
     MzArchive archive;
     KaraokeFileInfo parser(this);
@@ -197,7 +219,23 @@ void DbUpdater::addFilesToDatabase(const QList<QString> &files)
         // searchString contains the metadata plus the basename to work around people's libraries that are
         // misnamed and don't import properly or who use media tags and have bad tags.
         query.bindValue(":searchstring", fileInfo.completeBaseName() + " " + parser.getArtist() + " " + parser.getTitle() + " " + parser.getSongId());
-        query.exec();
+        QString audioPath;
+        if (filePath.endsWith(".cdg", Qt::CaseInsensitive)) {
+            // Files added outside of a directory scan don't have a companion from the disk listing yet
+            audioPath = m_companionAudio.value(filePath);
+            if (audioPath.isEmpty())
+                audioPath = findMatchingAudioFile(filePath);
+        }
+        query.bindValue(":audiopath", audioPath);
+        existingQuery.bindValue(":path", filePath);
+        existingQuery.exec();
+        int existingId = existingQuery.first() ? existingQuery.value(0).toInt() : -1;
+        if (query.exec()) {
+            if (existingId > -1)
+                m_updatedSongIds.append(existingId);
+            else
+                m_addedSongIds.append(query.lastInsertId().toInt());
+        }
         if (shouldUpdateGui()) {
             emit progressChanged(loops, files.length());
             //emit stateChanged(QString("Importing new files into the karaoke database... %1 of %2").arg(loops).arg(files.length()));
@@ -213,6 +251,107 @@ void DbUpdater::addFilesToDatabase(const QList<QString> &files)
     }
 }
 
+void DbUpdater::updateCompanionAudio()
+{
+    if (m_companionAudioUpdates.empty())
+        return;
+    QSqlQuery query;
+    query.exec("BEGIN TRANSACTION");
+    query.prepare("UPDATE dbsongs SET audiopath = :audiopath WHERE songid = :id");
+    for (const auto &[songId, audioPath] : m_companionAudioUpdates) {
+        query.bindValue(":audiopath", audioPath);
+        query.bindValue(":id", songId);
+        if (query.exec() && !m_updatedSongIds.contains(songId))
+            m_updatedSongIds.append(songId);
+    }
+    query.exec("COMMIT");
+    m_companionAudioUpdates.clear();
+}
+
+int DbUpdater::reapplyNamingPatterns(const QList<QString> &paths)
+{
+    if (!scannerMutex.try_lock()) {
+        m_errors.append("Scanner already running");
+        return -1;
+    }
+    const std::lock_guard<std::mutex> locker(scannerMutex, std::adopt_lock);
+
+    setPaths(paths);
+    emit stateChanged("Reading songs from database...");
+    QStringList sql_path_filter;
+    for (int i = 0; i < m_paths.size(); i++)
+        sql_path_filter.append(QString("path LIKE :pathfilter%1").arg(i));
+    QSqlQuery query;
+    query.prepare("SELECT songid, path, artist, title, discid FROM dbsongs WHERE discid != '!!DROPPED!!' AND (" + sql_path_filter.join(" OR ") + ")");
+    for (int i = 0; i < m_paths.size(); i++)
+        query.bindValue(QString(":pathfilter%1").arg(i), m_paths[i] + "%");
+    query.exec();
+    QVector<SongNaming> songs;
+    while (query.next()) {
+        songs.append(SongNaming {
+            .id =     query.value(0).toInt(),
+            .path =   query.value(1).toString(),
+            .artist = query.value(2).toString(),
+            .title =  query.value(3).toString(),
+            .discId = query.value(4).toString()
+        });
+    }
+
+    // The resolver loads the source dir patterns on first use, do that here on the thread that owns the db
+    // connection so the workers only ever read from it
+    auto patternResolver = std::make_shared<KaraokeFilePatternResolver>();
+    patternResolver->getPattern(QString());
+
+    // Only the stored path is parsed, files are only opened for directories using the media tags pattern
+    emit stateChanged(QString("Re-applying naming patterns to %1 songs...").arg(songs.size()));
+    QFutureWatcher<SongNaming> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcher<SongNaming>::progressValueChanged, this, [this, &watcher] (int progress) {
+        emit progressChanged(progress, watcher.progressMaximum());
+    });
+    connect(&watcher, &QFutureWatcher<SongNaming>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::mapped(songs, [patternResolver] (const SongNaming &song) {
+        KaraokeFileInfo parser(nullptr, patternResolver);
+        parser.setFile(song.path);
+        auto baseName = QFileInfo(song.path).completeBaseName();
+        SongNaming derived {
+            .id =     song.id,
+            .path =   song.path,
+            .artist = parser.getArtist(),
+            .title =  parser.parsedSuccessfully() ? parser.getTitle() : baseName,
+            .discId = parser.getSongId()
+        };
+        derived.searchString = baseName + " " + parser.getArtist() + " " + parser.getTitle() + " " + parser.getSongId();
+        derived.changed = derived.artist != song.artist || derived.title != song.title || derived.discId != song.discId;
+        return derived;
+    }));
+    if (!watcher.isFinished())
+        loop.exec();
+
+    emit stateChanged("Updating changed songs in database...");
+    int changed{0};
+    query.exec("BEGIN TRANSACTION");
+    query.prepare("UPDATE dbsongs SET artist = :artist, title = :title, discid = :discid, searchstring = :searchstring WHERE songid = :id");
+    for (const auto &song : watcher.future().results()) {
+        if (!song.changed)
+            continue;
+        query.bindValue(":artist", song.artist);
+        query.bindValue(":title", song.title);
+        query.bindValue(":discid", song.discId);
+        query.bindValue(":searchstring", song.searchString);
+        query.bindValue(":id", song.id);
+        if (!query.exec()) {
+            m_errors.append("Unable to update naming for: " + song.path);
+            continue;
+        }
+        m_updatedSongIds.append(song.id);
+        changed++;
+    }
+    query.exec("COMMIT");
+    emit progressMessage(QString("Naming patterns re-applied, %1 of %2 songs changed").arg(changed).arg(songs.size()));
+    return changed;
+}
+
 int DbUpdater::missingFilesCount()
 {
     return m_missingFilesSongIds.length();
@@ -231,7 +370,8 @@ void DbUpdater::removeMissingFilesFromDatabase()
 
     foreach(const int id, m_missingFilesSongIds) {
         query.bindValue(":id", id);
-        query.exec();
+        if (query.exec())
+            m_removedSongIds.append(id);
     }
 
     query.exec("DELETE FROM queueSongs WHERE [song] NOT IN (SELECT [songid] FROM dbSongs)");
@@ -248,10 +388,11 @@ void DbUpdater::DiskEnumerator::findKaraokeFilesOnDisk() {
 
     // cdg and zip files
     QStringList karaoke_files;
-    // audio files to match with cdg files
-    QStringList audio_files;
+    // audio files to match with cdg files, when several share a base name the most common format wins
+    QHash<QString, QString> audio_files;
+    QHash<QString, int> audio_file_ranks;
+    static const QStringList audioPreference{"mp3", "wav", "ogg", "mov", "flac"};
     karaoke_files.reserve(200000);
-    audio_files.reserve(200000);
 
     foreach(auto path, m_parent.m_paths ) {
         emit m_parent.stateChanged("Finding karaoke files in " + path);
@@ -271,7 +412,12 @@ void DbUpdater::DiskEnumerator::findKaraokeFilesOnDisk() {
                 }
                 else if (std::binary_search(m_parent.audio_file_extensions.begin(), m_parent.audio_file_extensions.end(), ext)) {
                     const QString filePath = iterator.filePath();
-                    audio_files.append(filePath.left(filePath.lastIndexOf('.')));
+                    const QString base = filePath.left(filePath.lastIndexOf('.')).toLower();
+                    const int rank = audioPreference.indexOf(iterator.fileInfo().suffix().toLower());
+                    if (!audio_files.contains(base) || rank < audio_file_ranks.value(base)) {
+                        audio_files.insert(base, filePath);
+                        audio_file_ranks.insert(base, rank);
+                    }
                 }
             }
             if (m_parent.shouldUpdateGui()) {
@@ -288,12 +434,11 @@ void DbUpdater::DiskEnumerator::findKaraokeFilesOnDisk() {
     QApplication::processEvents();
 
     karaoke_files.sort();
-    audio_files.sort();
 
     emit m_parent.stateChanged("Done searching for files.");
 
     m_karaokeFilesOnDisk = karaoke_files;
-    m_audioFilesOnDisk = audio_files;
+    m_audioFilesByBase = audio_files;
 }
 
 void DbUpdater::DiskEnumerator::readNextDiskFile()
@@ -306,26 +451,11 @@ void DbUpdater::DiskEnumerator::readNextDiskFile()
         if (CurrentFile != nullptr && CurrentFile.endsWith(".cdg", Qt::CaseInsensitive)) {
 
             // File type is "cdg" and is only valid if there is an audio file with the same filename.
-            // Look for an entry with the same filename in the list of audio files.
-            invalid_file_found = true;
-            const QStringRef disk_path_without_ext = QStringRef(&CurrentFile, 0, CurrentFile.length() - 4);
-
-            while (m_i_aud < m_audioFilesOnDisk.size()) {
-                int comp_result_audio = disk_path_without_ext.compare(m_audioFilesOnDisk.at(m_i_aud));
-                if (comp_result_audio == 0) {
-                    // match found!
-                    invalid_file_found = false;
-                    m_i_aud++;
-                    break;
-                }
-                if (comp_result_audio < 0) {
-                    // no match found...
-                    break;
-                }
-
-                // keep looking - advance to the next audio file in the list
-                m_i_aud++;
-            }
+            // The match ignores case and is remembered so playback doesn't have to probe for it again.
+            const QString audioPath = m_audioFilesByBase.value(CurrentFile.left(CurrentFile.length() - 4).toLower());
+            invalid_file_found = audioPath.isEmpty();
+            if (!invalid_file_found)
+                m_parent.m_companionAudio.insert(CurrentFile, audioPath);
         }
         else {
             invalid_file_found = false;
@@ -338,7 +468,7 @@ void DbUpdater::DiskEnumerator::readNextDiskFile()
 void DbUpdater::DbEnumerator::prepareQuery(bool limitToPaths)
 {
     if (!limitToPaths) {
-        m_dbSongs.prepare("SELECT songid, path, CASE discid WHEN '!!DROPPED!!' THEN 1 ELSE 0 END FROM dbsongs ORDER BY path");
+        m_dbSongs.prepare("SELECT songid, path, CASE discid WHEN '!!DROPPED!!' THEN 1 ELSE 0 END, audiopath FROM dbsongs ORDER BY path");
     }
     else {
         QStringList sql_path_filter;
@@ -346,7 +476,7 @@ void DbUpdater::DbEnumerator::prepareQuery(bool limitToPaths)
             sql_path_filter.append(QString("path LIKE :pathfilter%1").arg(i));
         }
 
-        m_dbSongs.prepare("SELECT songid, path, CASE discid WHEN '!!DROPPED!!' THEN 1 ELSE 0 END FROM dbsongs WHERE " + sql_path_filter.join(" OR ") + " ORDER BY path");
+        m_dbSongs.prepare("SELECT songid, path, CASE discid WHEN '!!DROPPED!!' THEN 1 ELSE 0 END, audiopath FROM dbsongs WHERE " + sql_path_filter.join(" OR ") + " ORDER BY path");
         for(int i = 0; i < m_parent.m_paths.size(); i++) {
             auto key = QString(":pathfilter%1").arg(i);
             m_dbSongs.bindValue(key, m_parent.m_paths[i] + "%");
@@ -370,7 +500,8 @@ void DbUpdater::DbEnumerator::readNextRecord()
         CurrentRecord = DbSongRecord {
             .id =        m_dbSongs.value(0).toInt(),
             .isDropped = m_dbSongs.value(2).toBool(),
-            .path =      m_dbSongs.value(1).toString()
+            .path =      m_dbSongs.value(1).toString(),
+            .audioPath = m_dbSongs.value(3).toString()
         };
     }
 }
@@ -434,7 +565,7 @@ void DbUpdater::fixMissingFiles(QVector<DbSongRecord> &filesMissingOnDisk, QStri
     QVector<DbSongRecord> filesMissingOnDisk_still;
     QSqlQuery query;
     query.exec("BEGIN TRANSACTION");
-    query.prepare("UPDATE dbsongs SET path = :newpath WHERE songid = :id");
+    query.prepare("UPDATE dbsongs SET path = :newpath, audiopath = :audiopath WHERE songid = :id");
 
     foreach(auto missingFile, filesMissingOnDisk) {
 
@@ -448,6 +579,7 @@ void DbUpdater::fixMissingFiles(QVector<DbSongRecord> &filesMissingOnDisk, QStri
         auto const lb = std::lower_bound(filesOnDiskFilenamesOnlySorted.begin(), filesOnDiskFilenamesOnlySorted.end(), filenameWithoutPath, caseInsensitiveSort);
         if (lb->compare(filenameWithoutPath, Qt::CaseInsensitive) == 0) {
             query.bindValue(":newpath", *lb->string());
+            query.bindValue(":audiopath", m_companionAudio.value(*lb->string()));
             query.bindValue(":id", missingFile.id);
 
             if (query.exec()) {
@@ -457,6 +589,7 @@ void DbUpdater::fixMissingFiles(QVector<DbSongRecord> &filesMissingOnDisk, QStri
                 qInfo() << "  new: " << lb->string();
 
                 newFilesOnDisk.removeOne(*lb->string());
+                m_updatedSongIds.append(missingFile.id);
                 matchFound = true;
             }
             else {
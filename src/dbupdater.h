@@ -39,6 +39,17 @@ private:
        int id{-1};
        bool isDropped{false};
        QString path;
+       QString audioPath;
+    };
+
+    struct SongNaming {
+        int id{-1};
+        QString path;
+        QString artist;
+        QString title;
+        QString discId;
+        QString searchString;
+        bool changed{false};
     };
 
     // file extension list must be sorted and in lower case:
@@ -67,9 +78,9 @@ private:
     private:
         DbUpdater& m_parent;
         QStringList m_karaokeFilesOnDisk;
-        QStringList m_audioFilesOnDisk;
+        // Lower cased path without extension -> audio file path, used to pair loose cdg files with their audio
+        QHash<QString, QString> m_audioFilesByBase;
         int m_i_kar{-1};
-        int m_i_aud{0};
 
     public:
         bool IsValid{false};
@@ -77,7 +88,7 @@ private:
         explicit DiskEnumerator(DbUpdater& parent) : m_parent(parent) { reset(); }
         void findKaraokeFilesOnDisk();
         void readNextDiskFile();
-        void reset() { m_i_kar = -1; m_i_aud = 0; IsValid = false; }
+        void reset() { m_i_kar = -1; IsValid = false; }
         int count() { return m_karaokeFilesOnDisk.length(); }
     };
 
@@ -101,11 +112,18 @@ private:
     QStringList m_paths;
     QStringList m_errors;
     QVector<int> m_missingFilesSongIds;
+    QVector<int> m_addedSongIds;
+    QVector<int> m_updatedSongIds;
+    QVector<int> m_removedSongIds;
+    // cdg path -> companion audio path for every loose cdg found on disk during the current scan
+    QHash<QString, QString> m_companionAudio;
+    QVector<QPair<int, QString>> m_companionAudioUpdates;
     QElapsedTimer m_guiUpdateTimer;
 
     void setPaths(const QList<QString> &paths);
     void fixMissingFiles(QVector<DbSongRecord> &filesMissingOnDisk, QStringList &newFilesOnDisk);
     bool shouldUpdateGui();
+    void updateCompanionAudio();
 
 public:
 
@@ -123,8 +141,14 @@ public:
     QStringList getErrors();
     bool process(const QList<QString> &paths, ProcessingOptions options);
     void addFilesToDatabase(const QList<QString> &files);
+    // Re-derives artist/title/songid for songs already in the db under the given paths using their source dir's
+    // current naming pattern. Returns the number of songs changed, or -1 if a scan is already running.
+    int reapplyNamingPatterns(const QList<QString> &paths);
     int missingFilesCount();
     void removeMissingFilesFromDatabase();
+    [[nodiscard]] QVector<int> addedSongIds() const { return m_addedSongIds; }
+    [[nodiscard]] QVector<int> updatedSongIds() const { return m_updatedSongIds; }
+    [[nodiscard]] QVector<int> removedSongIds() const { return m_removedSongIds; }
 
 signals:
     void errorsGenerated(QStringList);
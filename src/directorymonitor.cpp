@@ -1,13 +1,22 @@
 #include "directorymonitor.h"
 #include "dbupdater.h"
+#include "activitypolicy.h"
 #include <QFutureWatcher>
 #include <QtConcurrent>
 
 DirectoryMonitor::DirectoryMonitor(QObject *parent, QStringList pathsToWatch) : QObject(parent)
 {
-    m_scanTimer.setInterval(5000);
+    m_scanTimer.setInterval(m_scanDelayMs);
     m_scanTimer.setSingleShot(true);
     connect(&m_scanTimer, &QTimer::timeout, this, &DirectoryMonitor::scanPaths);
+    // Nobody is waiting on new songs while the app is idle, so changes get a longer window to settle and a large copy
+    // ends up as one scan instead of one every few seconds.  setInterval() restarts a pending scan with the new delay,
+    // so one that's waiting gets pulled back in as soon as there's activity.
+    connect(&ActivityPolicy::instance(), &ActivityPolicy::idleChanged, this, [this] (bool idle) {
+        m_scanTimer.setInterval(idle ? m_idleScanDelayMs : m_scanDelayMs);
+    });
+    if (ActivityPolicy::instance().isIdle())
+        m_scanTimer.setInterval(m_idleScanDelayMs);
 
     connect(&m_pathsEnumeratedWatcher, &QFutureWatcher<int>::finished, this, &DirectoryMonitor::directoriesEnumerated);
     auto future = QtConcurrent::run(this, &DirectoryMonitor::enumeratePathsAsync, pathsToWatch);
@@ -59,7 +68,7 @@ void DirectoryMonitor::scanPaths()
     // Fix moved files to detect files moved between folders (in that case, both folders will be in m_pathsWithChangedFiles).
     DbUpdater dbUpdater(this);
     if (dbUpdater.process(paths, DbUpdater::ProcessingOption::FixMovedFiles)) {
-        emit databaseUpdateComplete();
+        emit databaseSongsChanged(dbUpdater.addedSongIds(), dbUpdater.updatedSongIds(), {});
     }
     else {
         // scanning failed - perhaps another scan was running?
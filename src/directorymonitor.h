@@ -7,6 +7,7 @@
 #include <QSet>
 #include <QStringList>
 #include <QTimer>
+#include <QVector>
 
 class DirectoryMonitor : public QObject
 {
@@ -22,6 +23,8 @@ private:
 
     QSet<QString> m_pathsWithChangedFiles;
     QTimer m_scanTimer;
+    const int m_scanDelayMs{5000};
+    const int m_idleScanDelayMs{30000};
 
     QStringList enumeratePathsAsync(QStringList paths);
     void directoriesEnumerated();
@@ -29,7 +32,7 @@ private:
     void scanPaths();
 
 signals:
-    void databaseUpdateComplete();
+    void databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds, const QVector<int> &removedIds);
 
 };
 
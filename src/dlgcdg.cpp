@@ -26,6 +26,7 @@
 #include <QDir>
 #include <QImageReader>
 #include <QScreen>
+#include "activitypolicy.h"
 
 
 VideoDisplay *DlgCdg::getVideoDisplay()
@@ -83,7 +84,10 @@ DlgCdg::DlgCdg(MediaBackend &KaraokeBackend, MediaBackend &BreakBackend, QWidget
     connect(&m_timerButtonShow, &QTimer::timeout, [&] () { ui->fsToggleWidget->hide(); });
     m_timerButtonShow.setInterval(1000);
     m_timerAlertCountdown.setInterval(1000);
-    m_timer1s.start(1000);
+    m_timer1s.setInterval(1000);
+    if (!ActivityPolicy::instance().isIdle())
+        m_timer1s.start();
+    connect(&ActivityPolicy::instance(), &ActivityPolicy::idleChanged, this, &DlgCdg::activityIdleChanged);
     if (m_settings.bgMode() == Settings::BG_MODE_SLIDESHOW)
         m_timerSlideShow.start(static_cast<int>(m_settings.slideShowInterval() * 1000));
     ui->videoDisplayBm->hide();
@@ -91,6 +95,11 @@ DlgCdg::DlgCdg(MediaBackend &KaraokeBackend, MediaBackend &BreakBackend, QWidget
         hide();
     else
         show();
+    if (!isVisible() && m_timerSlideShow.isActive())
+    {
+        m_timerSlideShow.stop();
+        m_slideShowSuspended = true;
+    }
 }
 
 DlgCdg::~DlgCdg() = default;
@@ -241,14 +250,19 @@ void DlgCdg::applyBackgroundImageMode()
     }
     else if (m_settings.bgMode() == Settings::BgMode::BG_MODE_SLIDESHOW && QDir(m_settings.bgSlideShowDir()).exists())
     {
-        m_timerSlideShow.start();
+        // No point flipping slides nobody can see, showEvent() picks the slideshow back up
+        m_slideShowSuspended = !isVisible();
+        if (!m_slideShowSuspended)
+            m_timerSlideShow.start();
         slideShowMoveNext();
+        return;
     }
     else
     {
         m_timerSlideShow.stop();
         ui->videoDisplayKar->useDefaultBackground();
     }
+    m_slideShowSuspended = false;
 }
 
 void DlgCdg::timerSlideShowTimeout()
@@ -372,6 +386,11 @@ void DlgCdg::showEvent(QShowEvent *event)
     }
     else
         ui->btnToggleFullscreen->setText("Make Fullscreen");
+    if (m_slideShowSuspended)
+    {
+        m_slideShowSuspended = false;
+        m_timerSlideShow.start();
+    }
     QDialog::showEvent(event);
     emit visibilityChanged(true);
 }
@@ -379,9 +398,31 @@ void DlgCdg::showEvent(QShowEvent *event)
 void DlgCdg::hideEvent(QHideEvent *event)
 {
     m_settings.saveWindowState(this);
+    if (m_timerSlideShow.isActive())
+    {
+        m_timerSlideShow.stop();
+        m_slideShowSuspended = true;
+    }
     QWidget::hideEvent(event);
 }
 
+void DlgCdg::activityIdleChanged(bool idle)
+{
+    // The remaining time display only changes while the karaoke backend is playing, which it never is while idle.
+    // One last update hides it before the timer stops.
+    if (idle)
+    {
+        timer1sTimeout();
+        m_timer1s.stop();
+        return;
+    }
+    if (!m_timer1s.isActive())
+    {
+        m_timer1s.start();
+        timer1sTimeout();
+    }
+}
+
 void DlgCdg::setSlideshowInterval(int secs) {
     m_timerSlideShow.setInterval(secs * 1000);
 }
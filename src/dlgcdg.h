@@ -80,6 +80,7 @@ private:
     QTimer m_timerAlertCountdown;
     QTimer m_timerButtonShow;
     QTimer m_timerSlideShow;
+    bool m_slideShowSuspended{false};
     MediaBackend &m_kmb;
     MediaBackend &m_bmb;
     std::unique_ptr<TransparentWidget> m_tWidget;
@@ -118,6 +119,7 @@ public slots:
     void alertBgColorChanged(const QColor &color);
     void alertTxtColorChanged(const QColor &color);
     void setSlideshowInterval(int secs);
+    void activityIdleChanged(bool idle);
 
 protected:
     void closeEvent(QCloseEvent *event) override;
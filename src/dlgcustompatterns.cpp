@@ -96,6 +96,7 @@ void DlgCustomPatterns::btnApplyChangesClicked() {
                    "\", artistcapturegrp = " + acg + ", titlecapturegrp = " + tcg + ", discidcapturegrp = " + dcg +
                    " WHERE name = \"" + name + "\"");
         m_patternsModel.loadFromDB();
+        emit customPatternChanged(name);
     }
 }
 
@@ -16,6 +16,9 @@ public:
     explicit DlgCustomPatterns(QWidget *parent = nullptr);
     ~DlgCustomPatterns() override;
 
+signals:
+    void customPatternChanged(const QString &name);
+
 private slots:
     void evaluateRegEx();
     void btnCloseClicked();
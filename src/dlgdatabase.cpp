@@ -26,7 +26,13 @@
 #include <QSqlQuery>
 #include <QMessageBox>
 #include "dbupdater.h"
+#include "dbexportthread.h"
+#include "zipoptimizer.h"
 #include <QStandardPaths>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 DlgDatabase::DlgDatabase(TableModelKaraokeSongs &dbModel, QWidget *parent) :
     QDialog(parent),
@@ -43,10 +49,11 @@ DlgDatabase::DlgDatabase(TableModelKaraokeSongs &dbModel, QWidget *parent) :
     updateButtonsState();
     customPatternsDlg = new DlgCustomPatterns(this);
     dbUpdateDlg = new DlgDbUpdate(this);
+    connect(customPatternsDlg, &DlgCustomPatterns::customPatternChanged, this, &DlgDatabase::customPatternChanged);
 
     if (m_settings.dbDirectoryWatchEnabled()) {
         m_directoryMonitor = new DirectoryMonitor(this, sourcedirmodel->getSourceDirs());
-        connect(m_directoryMonitor, &DirectoryMonitor::databaseUpdateComplete, this, &DlgDatabase::databaseUpdateComplete);
+        connect(m_directoryMonitor, &DirectoryMonitor::databaseSongsChanged, this, &DlgDatabase::databaseSongsChanged);
     }
 }
 
@@ -62,8 +69,7 @@ void DlgDatabase::singleSongAdd(const QString& path)
     qInfo() << "singleSongAdd(" << path << ") called";
     DbUpdater updater;
     updater.addFilesToDatabase(QStringList() << path);
-    emit databaseUpdateComplete();
-    //emit databaseSongAdded();
+    emit databaseSongsChanged(updater.addedSongIds(), updater.updatedSongIds(), {});
 }
 
 void DlgDatabase::on_buttonNew_clicked()
@@ -85,45 +91,54 @@ void DlgDatabase::on_buttonNew_clicked()
 #endif
     if (fileName != "")
     {
-        bool okPressed = false;
-        QStringList items;
-        QSqlQuery query;
-        query.exec("SELECT * FROM custompatterns ORDER BY name");
-        while (query.next())
-        {
-            QString name = query.value("name").toString();
-            items << QString(tr("Custom: ") + name);
-        }
-
-
-        items << tr("SongID - Artist - Title") << tr("SongID - Title - Artist") << tr("Artist - Title - SongID") << tr("Title - Artist - SongID") << tr("Artist - Title") << tr("Title - Artist") << tr("SongID_Title_Artist") << tr("Media Tags");
-        QString selected = QInputDialog::getItem(this,"Select a file naming pattern","Pattern",items,0,false,&okPressed);
-        if (okPressed)
-        {
-            int pattern = 0;
-            int customPattern = -1;
-            if (selected == tr("SongID - Artist - Title")) pattern = SourceDir::SAT;
-            if (selected == tr("SongID - Title - Artist")) pattern = SourceDir::STA;
-            if (selected == tr("Artist - Title - SongID")) pattern = SourceDir::ATS;
-            if (selected == tr("Title - Artist - SongID")) pattern = SourceDir::TAS;
-            if (selected == tr("Artist - Title")) pattern = SourceDir::AT;
-            if (selected == tr("Title - Artist")) pattern = SourceDir::TA;
-            if (selected == tr("Media Tags")) pattern = SourceDir::METADATA;
-            if (selected == tr("SongID_Title_Artist")) pattern = SourceDir::S_T_A;
-            if (selected.contains(tr("Custom")))
-            {
-                pattern = SourceDir::CUSTOM;
-                QString name = selected.split(": ").at(1);
-                query.exec("SELECT patternid FROM custompatterns WHERE name == \"" + name + "\"");
-                if (query.first())
-                    customPattern = query.value(0).toInt();
-            }
+        int pattern = 0;
+        int customPattern = -1;
+        if (selectNamingPattern(pattern, customPattern))
             sourcedirmodel->addSourceDir(fileName, pattern, customPattern);
-        }
     }
     updateButtonsState();
 }
 
+bool DlgDatabase::selectNamingPattern(int &pattern, int &customPattern, const QString &currentPattern)
+{
+    bool okPressed = false;
+    QStringList items;
+    QSqlQuery query;
+    query.exec("SELECT * FROM custompatterns ORDER BY name");
+    while (query.next())
+    {
+        QString name = query.value("name").toString();
+        items << QString(tr("Custom: ") + name);
+    }
+
+    items << tr("SongID - Artist - Title") << tr("SongID - Title - Artist") << tr("Artist - Title - SongID") << tr("Title - Artist - SongID") << tr("Artist - Title") << tr("Title - Artist") << tr("SongID_Title_Artist") << tr("Media Tags");
+    int current = items.indexOf(currentPattern);
+    if (current < 0)
+        current = 0;
+    QString selected = QInputDialog::getItem(this,"Select a file naming pattern","Pattern",items,current,false,&okPressed);
+    if (!okPressed)
+        return false;
+    pattern = 0;
+    customPattern = -1;
+    if (selected == tr("SongID - Artist - Title")) pattern = SourceDir::SAT;
+    if (selected == tr("SongID - Title - Artist")) pattern = SourceDir::STA;
+    if (selected == tr("Artist - Title - SongID")) pattern = SourceDir::ATS;
+    if (selected == tr("Title - Artist - SongID")) pattern = SourceDir::TAS;
+    if (selected == tr("Artist - Title")) pattern = SourceDir::AT;
+    if (selected == tr("Title - Artist")) pattern = SourceDir::TA;
+    if (selected == tr("Media Tags")) pattern = SourceDir::METADATA;
+    if (selected == tr("SongID_Title_Artist")) pattern = SourceDir::S_T_A;
+    if (selected.contains(tr("Custom")))
+    {
+        pattern = SourceDir::CUSTOM;
+        QString name = selected.split(": ").at(1);
+        query.exec("SELECT patternid FROM custompatterns WHERE name == \"" + name + "\"");
+        if (query.first())
+            customPattern = query.value(0).toInt();
+    }
+    return true;
+}
+
 void DlgDatabase::on_buttonClose_clicked()
 {
     m_settings.saveColumnWidths(ui->tableViewFolders);
@@ -182,7 +197,7 @@ void DlgDatabase::scan(bool scanAllPaths)
 
     updater.process(paths, processingOptions);
 
-    emit databaseUpdateComplete();
+    emit databaseSongsChanged(updater.addedSongIds(), updater.updatedSongIds(), {});
     showDbUpdateErrors(updater.getErrors());
 
     if (updater.missingFilesCount() > 0) {
@@ -201,12 +216,71 @@ void DlgDatabase::scan(bool scanAllPaths)
         msgBox.exec();
         if (msgBox.clickedButton() == yesButton) {
             updater.removeMissingFilesFromDatabase();
+            emit databaseSongsChanged({}, {}, updater.removedSongIds());
         }
     }
 
     dbUpdateDlg->hide();
     QMessageBox::information(this, tr("Update Complete"), tr("Database update complete."));
-    emit databaseUpdateComplete();
+}
+
+void DlgDatabase::on_btnChangePattern_clicked()
+{
+    int index = ui->tableViewFolders->currentIndex().row();
+    if (index < 0)
+        return;
+    auto currentPattern = sourcedirmodel->data(sourcedirmodel->index(index, TableModelKaraokeSourceDirs::PATTERN), Qt::DisplayRole).toString();
+    int pattern = 0;
+    int customPattern = -1;
+    if (!selectNamingPattern(pattern, customPattern, currentPattern))
+        return;
+    sourcedirmodel->setSourceDirPattern(index, pattern, customPattern);
+    reapplyNamingPatterns({sourcedirmodel->getDirByIndex(index).getPath()});
+}
+
+void DlgDatabase::customPatternChanged(const QString &name)
+{
+    QStringList paths;
+    QSqlQuery query;
+    query.prepare("SELECT sourceDirs.path FROM sourceDirs JOIN custompatterns ON sourceDirs.custompattern == custompatterns.patternid "
+                  "WHERE sourceDirs.pattern == :pattern AND custompatterns.name == :name");
+    query.bindValue(":pattern", SourceDir::CUSTOM);
+    query.bindValue(":name", name);
+    query.exec();
+    while (query.next())
+        paths.append(query.value(0).toString());
+    if (paths.isEmpty())
+        return;
+
+    QMessageBox msgBox;
+    msgBox.setText(tr("Re-apply pattern to existing songs?"));
+    msgBox.setInformativeText(tr("The pattern \"%1\" is used by %2 source folder(s). Do you want to update the artist, title and song id of the songs already in the database to match the changed pattern?").arg(name).arg(paths.size()));
+    msgBox.setDetailedText(paths.join("\n"));
+    msgBox.setIcon(QMessageBox::Question);
+    msgBox.addButton(QMessageBox::No);
+    QPushButton *yesButton = msgBox.addButton(QMessageBox::Yes);
+    msgBox.exec();
+    if (msgBox.clickedButton() == yesButton)
+        reapplyNamingPatterns(paths);
+}
+
+void DlgDatabase::reapplyNamingPatterns(const QStringList &paths)
+{
+    dbUpdateDlg->reset();
+    DbUpdater updater;
+    connect(&updater, &DbUpdater::progressMessage, dbUpdateDlg, &DlgDbUpdate::addLogMsg);
+    connect(&updater, &DbUpdater::stateChanged, dbUpdateDlg, &DlgDbUpdate::changeStatusTxt);
+    connect(&updater, &DbUpdater::progressChanged, dbUpdateDlg, &DlgDbUpdate::changeProgress);
+    dbUpdateDlg->show();
+    QApplication::processEvents();
+
+    int changed = updater.reapplyNamingPatterns(paths);
+
+    emit databaseSongsChanged({}, updater.updatedSongIds(), {});
+    showDbUpdateErrors(updater.getErrors());
+    dbUpdateDlg->hide();
+    if (changed >= 0)
+        QMessageBox::information(this, tr("Naming Pattern Applied"), tr("%1 song(s) in the database were updated.").arg(changed));
 }
 
 void DlgDatabase::on_btnClearDatabase_clicked()
@@ -262,25 +336,101 @@ void DlgDatabase::on_btnExport_clicked()
 #endif
     if (saveFilePath != "")
     {
-        QFile csvFile(saveFilePath);
-        if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
-        {
-            QMessageBox::warning(this, tr("Error saving file"), tr("Unable to open selected file for writing.  Please verify that you have the proper permissions to write to that location."),QMessageBox::Close);
-            return;
-        }
-        QSqlQuery query;
-        query.exec("SELECT * from dbsongs ORDER BY artist,title,filename");
-        while (query.next())
-        {
-            QString artist = query.value("artist").toString();
-            QString title = query.value("title").toString();
-            QString songId = query.value("discid").toString();
-            QString filepath = query.value("path").toString();
-            QString data = "\"" + artist + "\",\"" + title + "\",\"" + songId + "\",\"" + filepath + "\"" + "\n";
-            csvFile.write(data.toLocal8Bit().data());
-        }
-        csvFile.close();
+        auto exportThread = new DbExportThread(DbExportThread::SongDbCsv, saveFilePath, this);
+        auto progressDialog = new QProgressDialog(tr("Exporting song database..."), tr("Cancel"), 0, 0, this);
+        progressDialog->setWindowModality(Qt::NonModal);
+        progressDialog->setMinimumDuration(0);
+        connect(exportThread, &DbExportThread::progressChanged, progressDialog, [progressDialog] (int progress, int max) {
+            progressDialog->setMaximum(max);
+            progressDialog->setValue(progress);
+        });
+        connect(progressDialog, &QProgressDialog::canceled, exportThread, &QThread::requestInterruption);
+        connect(exportThread, &DbExportThread::exportFinished, this, [this, progressDialog] (bool success, bool canceled, const QString &errorText) {
+            progressDialog->close();
+            progressDialog->deleteLater();
+            if (success)
+                QMessageBox::information(this, tr("Export complete"), tr("Song database export complete."));
+            else if (!canceled)
+                QMessageBox::warning(this, tr("Error saving file"), tr("Unable to export the song database.  Please verify that you have the proper permissions to write to that location.") + "\n\n" + errorText, QMessageBox::Close);
+        });
+        connect(exportThread, &QThread::finished, exportThread, &QObject::deleteLater);
+        progressDialog->show();
+        exportThread->start(QThread::LowPriority);
+    }
+}
+
+void DlgDatabase::on_btnOptimizeZips_clicked()
+{
+    QMessageBox msgBox;
+    msgBox.setText(tr("Optimize karaoke zip files?"));
+    msgBox.setInformativeText(tr("Rewrites every zip file in the database so it holds only the CDG and audio files, "
+                                 "stored uncompressed with the CDG first.  This makes starting playback faster.\n\n"
+                                 "Each file is checked before it is replaced and is never left half written, but this "
+                                 "reads and rewrites your whole library and is best done when you're not running a show.  "
+                                 "A dry run reports what would change without touching any files."));
+    msgBox.setIcon(QMessageBox::Question);
+    QPushButton *dryRunButton = msgBox.addButton(tr("Dry Run"), QMessageBox::ActionRole);
+    QPushButton *optimizeButton = msgBox.addButton(tr("Optimize"), QMessageBox::AcceptRole);
+    msgBox.addButton(QMessageBox::Cancel);
+    msgBox.exec();
+    if (msgBox.clickedButton() == dryRunButton)
+        optimizeZips(true);
+    else if (msgBox.clickedButton() == optimizeButton)
+        optimizeZips(false);
+}
+
+void DlgDatabase::optimizeZips(bool dryRun)
+{
+    QStringList paths;
+    QSqlQuery query;
+    query.exec("SELECT path FROM dbsongs WHERE path LIKE '%.zip' AND discid != '!!DROPPED!!' ORDER BY path");
+    while (query.next())
+        paths.append(query.value(0).toString());
+    if (paths.isEmpty())
+        return;
+
+    dbUpdateDlg->reset();
+    ZipOptimizer optimizer;
+    connect(&optimizer, &ZipOptimizer::progressMessage, dbUpdateDlg, &DlgDbUpdate::addLogMsg);
+    connect(&optimizer, &ZipOptimizer::stateChanged, dbUpdateDlg, &DlgDbUpdate::changeStatusTxt);
+    connect(&optimizer, &ZipOptimizer::progressChanged, dbUpdateDlg, &DlgDbUpdate::changeProgress);
+    auto cancelConnection = connect(dbUpdateDlg, &QDialog::rejected, this, [&optimizer] () { optimizer.cancel(); });
+    dbUpdateDlg->show();
+
+    QFutureWatcher<ZipOptimizer::Report> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcher<ZipOptimizer::Report>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::run(&optimizer, &ZipOptimizer::run, paths, dryRun));
+    loop.exec();
+    disconnect(cancelConnection);
+    auto report = watcher.result();
+    dbUpdateDlg->hide();
+
+    QString summary = tr("%1 of %2 zip files %3, %4 were already optimized.\n"
+                         "Library size: %5 MB before, %6 MB after.\n"
+                         "Time taken: %7 seconds.")
+            .arg(report.optimized).arg(report.scanned)
+            .arg(report.dryRun ? tr("would be optimized") : tr("were optimized"))
+            .arg(report.alreadyOptimized)
+            .arg(report.bytesBefore / 1048576).arg(report.bytesAfter / 1048576)
+            .arg(report.elapsedMs / 1000);
+    if (report.cancelled)
+        summary += "\n\n" + tr("Stopped before all files were checked, running it again picks up where it left off.");
+    QMessageBox resultBox;
+    resultBox.setText(report.dryRun ? tr("Dry run complete") : tr("Optimization complete"));
+    resultBox.setInformativeText(summary);
+    if (!report.errors.isEmpty())
+        resultBox.setDetailedText(tr("Files that couldn't be optimized:") + "\n" + report.errors.join("\n"));
+    QPushButton *optimizeButton{nullptr};
+    if (report.dryRun && report.optimized > 0 && !report.cancelled)
+    {
+        resultBox.setInformativeText(summary + "\n\n" + tr("Optimize these files now?"));
+        optimizeButton = resultBox.addButton(tr("Optimize"), QMessageBox::AcceptRole);
+        resultBox.addButton(QMessageBox::Close);
     }
+    resultBox.exec();
+    if (optimizeButton && resultBox.clickedButton() == optimizeButton)
+        optimizeZips(false);
 }
 
 void DlgDatabase::on_foldersSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
@@ -292,6 +442,7 @@ void DlgDatabase::updateButtonsState()
 {
     bool hasSelectedRow = ui->tableViewFolders->selectionModel()->selectedRows().count() > 0;
     ui->buttonUpdate->setEnabled(hasSelectedRow);
+    ui->btnChangePattern->setEnabled(hasSelectedRow);
     ui->buttonDelete->setEnabled(hasSelectedRow);
 
     auto model = ui->tableViewFolders->model();
@@ -51,6 +51,9 @@ private:
 
     void scan(bool scanAllPaths);
     void updateButtonsState();
+    bool selectNamingPattern(int &pattern, int &customPattern, const QString &currentPattern = QString());
+    void reapplyNamingPatterns(const QStringList &paths);
+    void optimizeZips(bool dryRun);
 
 public:
     explicit DlgDatabase(TableModelKaraokeSongs &dbModel, QWidget *parent = nullptr);
@@ -58,9 +61,8 @@ public:
 
 signals:
     void databaseAboutToUpdate();
-    void databaseUpdateComplete();
     void databaseCleared();
-    void databaseSongAdded();
+    void databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds, const QVector<int> &removedIds);
 
 public slots:
     void singleSongAdd(const QString &path);
@@ -74,7 +76,10 @@ private slots:
     void on_btnClearDatabase_clicked();
     static void showDbUpdateErrors(const QStringList& errors);
     void on_btnCustomPatterns_clicked();
+    void on_btnChangePattern_clicked();
+    void customPatternChanged(const QString &name);
     void on_btnExport_clicked();
+    void on_btnOptimizeZips_clicked();
     void on_foldersSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
 };
 
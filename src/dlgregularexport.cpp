@@ -27,9 +27,8 @@
 #include <QXmlStreamWriter>
 #include <QSqlQuery>
 #include <QApplication>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QJsonDocument>
+#include <QProgressDialog>
+#include "dbexportthread.h"
 
 DlgRegularExport::DlgRegularExport(TableModelKaraokeSongs &karaokeSongsModel, QWidget *parent) :
         m_karaokeSongsModel(karaokeSongsModel),
@@ -73,14 +72,7 @@ void DlgRegularExport::on_pushButtonExport_clicked()
 #endif
     if (saveFilePath != "")
     {
-        QMessageBox *msgBox = new QMessageBox(this);
-        msgBox->setStandardButtons(QFlags<QMessageBox::StandardButton>());
-        msgBox->setText(tr("Exporting regular singers, please wait..."));
-        msgBox->show();
         exportSingers(historySingerIds, saveFilePath);
-        msgBox->close();
-        delete msgBox;
-        QMessageBox::information(this, tr("Export complete"), tr("Regular singer export complete."));
         ui->tableViewRegulars->clearSelection();
     }
 }
@@ -102,14 +94,8 @@ void DlgRegularExport::on_pushButtonExportAll_clicked()
 #endif
         if (saveFilePath != "")
         {
-            QMessageBox *msgBox = new QMessageBox(this);
-            msgBox->setStandardButtons(QFlags<QMessageBox::StandardButton>());
-            msgBox->setText(tr("Exporting regular singers, please wait..."));
-            msgBox->show();
-            exportSingers(singerIds, saveFilePath);
-            msgBox->close();
-            delete msgBox;
-            QMessageBox::information(this, tr("Export complete"), tr("Regular singer export complete."));
+            // An empty id list exports every singer
+            exportSingers({}, saveFilePath);
             ui->tableViewRegulars->clearSelection();
         }
     }
@@ -117,32 +103,29 @@ void DlgRegularExport::on_pushButtonExportAll_clicked()
 
 void DlgRegularExport::exportSingers(const std::vector<int> &historySingerIds, const QString &savePath)
 {
-    QFile outfile(savePath);
-    QJsonArray jArr;
-    std::for_each(historySingerIds.begin(), historySingerIds.end(), [&] (auto singerId) {
-         QJsonObject jSinger;
-         auto singer = m_historySingersModel.getSinger(singerId);
-         jSinger.insert("name", singer.name);
-         auto songs = m_historySongsModel.getSingerSongs(singer.historySingerId);
-         QJsonArray jSongs;
-         std::for_each(songs.begin(), songs.end(), [&jSongs] (okj::HistorySong song) {
-            QJsonObject jSong;
-            jSong.insert("filepath", song.filePath);
-            jSong.insert("artist", song.artist);
-            jSong.insert("title", song.title);
-            jSong.insert("songid", song.songid);
-            jSong.insert("keychange", song.keyChange);
-            jSong.insert("plays", song.plays);
-            jSong.insert("lastplay", song.lastPlayed.toString());
-            jSongs.append(jSong);
-         });
-         jSinger.insert("songs", jSongs);
-         jArr.append(jSinger);
+    // This dialog deletes itself when closed, so the export is owned by our parent and can outlive it
+    QWidget *owner = parentWidget();
+    auto exportThread = new DbExportThread(DbExportThread::RegularSingersJson, savePath, owner);
+    exportThread->setHistorySingerIds(historySingerIds);
+    auto progressDialog = new QProgressDialog(tr("Exporting regular singers..."), tr("Cancel"), 0, 0, owner);
+    progressDialog->setWindowModality(Qt::NonModal);
+    progressDialog->setMinimumDuration(0);
+    connect(exportThread, &DbExportThread::progressChanged, progressDialog, [progressDialog] (int progress, int max) {
+        progressDialog->setMaximum(max);
+        progressDialog->setValue(progress);
     });
-    outfile.open(QFile::WriteOnly);
-    QJsonDocument jDoc(jArr);
-    outfile.write(jDoc.toJson(QJsonDocument::Indented));
-    outfile.close();
+    connect(progressDialog, &QProgressDialog::canceled, exportThread, &QThread::requestInterruption);
+    connect(exportThread, &DbExportThread::exportFinished, progressDialog, [owner, progressDialog] (bool success, bool canceled, const QString &errorText) {
+        progressDialog->close();
+        progressDialog->deleteLater();
+        if (success)
+            QMessageBox::information(owner, tr("Export complete"), tr("Regular singer export complete."));
+        else if (!canceled)
+            QMessageBox::warning(owner, tr("Export failed"), tr("Unable to export regular singers.") + "\n\n" + errorText, QMessageBox::Close);
+    });
+    connect(exportThread, &QThread::finished, exportThread, &QObject::deleteLater);
+    progressDialog->show();
+    exportThread->start(QThread::LowPriority);
 }
 
 
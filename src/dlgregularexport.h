@@ -23,7 +23,6 @@
 
 #include <QDialog>
 #include "models/tablemodelhistorysingers.h"
-#include "models/tablemodelhistorysongs.h"
 #include "models/tablemodelkaraokesongs.h"
 
 namespace Ui {
@@ -38,7 +37,6 @@ private:
     Ui::DlgRegularExport *ui;
     TableModelKaraokeSongs &m_karaokeSongsModel;
     TableModelHistorySingers m_historySingersModel;
-    TableModelHistorySongs m_historySongsModel{m_karaokeSongsModel};
     void exportSingers(const std::vector<int> &historySingerIds, const QString &savePath);
 
 public:
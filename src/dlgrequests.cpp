@@ -67,7 +67,7 @@ DlgRequests::DlgRequests(TableModelRotation &rotationModel, OKJSongbookAPI &song
     curRequestId = -1;
     ui->setupUi(this);
     requestsModel = new TableModelRequests(songbookApi, this);
-    dbModel.loadData();
+    dbModel.loadDataAsync();
     ui->tableViewRequests->setModel(requestsModel);
     ui->tableViewRequests->viewport()->installEventFilter(new TableViewToolTipFilter(ui->tableViewRequests));
     connect(requestsModel, &TableModelRequests::layoutChanged, this, &DlgRequests::requestsModified);
@@ -128,13 +128,9 @@ void DlgRequests::databaseAboutToUpdate() {
 
 }
 
-void DlgRequests::databaseUpdateComplete() {
-    dbModel.loadData();
-    autoSizeViews();
-}
-
-void DlgRequests::databaseSongAdded() {
-    dbModel.loadData();
+void DlgRequests::databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds,
+                                       const QVector<int> &removedIds) {
+    dbModel.applySongChanges(addedIds, updatedIds, removedIds);
 }
 
 void DlgRequests::rotationChanged() {
@@ -428,6 +424,10 @@ void DlgRequests::on_pushButtonUpdateDb_clicked() {
         songbookApi.updateSongDb();
         if (songbookApi.updateWasCancelled())
             qInfo() << "Songbook DB update cancelled by user";
+        else if (!songbookApi.updateWasSuccessful()) {
+            QMessageBox::warning(this, tr("Remote database update failed"),
+                                 tr("Some songs could not be uploaded to the request server. Please check your connection and try again."));
+        }
         else {
             QMessageBox msgBox;
             msgBox.setText(tr("Remote database update completed!"));
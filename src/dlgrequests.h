@@ -63,8 +63,7 @@ signals:
 
 public slots:
     void databaseAboutToUpdate();
-    void databaseUpdateComplete();
-    void databaseSongAdded();
+    void databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds, const QVector<int> &removedIds);
     void rotationChanged();
     void updateIcons();
 
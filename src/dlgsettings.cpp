@@ -33,6 +33,7 @@
 #include <QNetworkReply>
 #include <QAuthenticator>
 #include <QKeySequenceEdit>
+#include <QHostAddress>
 #include "audiorecorder.h"
 #include <QScreen>
 #include <spdlog/sinks/basic_file_sink.h>
@@ -152,6 +153,9 @@ DlgSettings::DlgSettings(MediaBackend &AudioBackend, MediaBackend &BmAudioBacken
     ui->lineEditUrl->setText(m_settings.requestServerUrl());
     ui->lineEditApiKey->setText(m_settings.requestServerApiKey());
     ui->checkBoxIgnoreCertErrors->setChecked(m_settings.requestServerIgnoreCertErrors());
+    ui->groupBoxCdgMirror->setChecked(m_settings.cdgMirrorEnabled());
+    ui->lineEditCdgMirrorAddress->setText(m_settings.cdgMirrorAddress());
+    ui->spinBoxCdgMirrorPort->setValue(m_settings.cdgMirrorPort());
     if ((m_settings.bgMode() == m_settings.BG_MODE_IMAGE) || (m_settings.bgSlideShowDir() == ""))
         ui->rbBgImage->setChecked(true);
     else
@@ -160,6 +164,7 @@ DlgSettings::DlgSettings(MediaBackend &AudioBackend, MediaBackend &BmAudioBacken
     ui->lineEditSlideshowDir->setText(m_settings.bgSlideShowDir());
     ui->checkBoxFader->setChecked(m_settings.audioUseFader());
     ui->checkBoxDownmix->setChecked(m_settings.audioDownmix());
+    ui->comboBoxDspQualityFloor->setCurrentIndex(m_settings.dspQualityFloor());
     ui->checkBoxSilenceDetection->setChecked(m_settings.audioDetectSilence());
     ui->checkBoxFaderBm->setChecked(m_settings.audioUseFaderBm());
     ui->checkBoxDownmixBm->setChecked(m_settings.audioDownmixBm());
@@ -522,6 +527,26 @@ void DlgSettings::on_groupBoxRequestServer_toggled(bool arg1) {
     emit requestServerEnableChanged(arg1);
 }
 
+void DlgSettings::on_groupBoxCdgMirror_toggled(bool arg1) {
+    if (!m_pageSetupDone)
+        return;
+    m_settings.setCdgMirrorEnabled(arg1);
+}
+
+void DlgSettings::on_lineEditCdgMirrorAddress_editingFinished() {
+    if (QHostAddress(ui->lineEditCdgMirrorAddress->text().trimmed()).isNull()) {
+        ui->lineEditCdgMirrorAddress->setText(m_settings.cdgMirrorAddress());
+        return;
+    }
+    m_settings.setCdgMirrorAddress(ui->lineEditCdgMirrorAddress->text().trimmed());
+}
+
+void DlgSettings::on_spinBoxCdgMirrorPort_valueChanged(int arg1) {
+    if (!m_pageSetupDone)
+        return;
+    m_settings.setCdgMirrorPort(arg1);
+}
+
 void DlgSettings::on_pushButtonBrowse_clicked() {
 #ifdef Q_OS_LINUX
     QString imageFile = QFileDialog::getOpenFileName(this, QString("Select image file"),
@@ -965,6 +990,14 @@ void DlgSettings::on_comboBoxKAudioDevices_currentIndexChanged(int index) {
     kAudioBackend.setAudioOutputDevice(device);
 }
 
+void DlgSettings::on_comboBoxDspQualityFloor_currentIndexChanged(int index) {
+    if (!m_pageSetupDone)
+        return;
+    m_settings.setDspQualityFloor(index);
+    kAudioBackend.setDspQualityFloor(index);
+    bmAudioBackend.setDspQualityFloor(index);
+}
+
 void DlgSettings::on_comboBoxBAudioDevices_currentIndexChanged(int index) {
     if (!m_pageSetupDone)
         return;
@@ -120,6 +120,9 @@ private slots:
     void on_lineEditUrl_editingFinished();
     void on_checkBoxIgnoreCertErrors_toggled(bool checked);
     void on_groupBoxRequestServer_toggled(bool arg1);
+    void on_groupBoxCdgMirror_toggled(bool arg1);
+    void on_lineEditCdgMirrorAddress_editingFinished();
+    void on_spinBoxCdgMirrorPort_valueChanged(int arg1);
     void on_pushButtonBrowse_clicked();
     void on_checkBoxFader_toggled(bool checked);
     void on_checkBoxFaderBm_toggled(bool checked);
@@ -168,6 +171,7 @@ private slots:
     void on_cbxPreviewEnabled_toggled(bool checked);
     void on_comboBoxKAudioDevices_currentIndexChanged(int index);
     void on_comboBoxBAudioDevices_currentIndexChanged(int index);
+    void on_comboBoxDspQualityFloor_currentIndexChanged(int index);
     void on_checkBoxEnforceAspectRatio_clicked(bool checked);
     void on_pushButtonApplyTickerMsg_clicked();
     void on_pushButtonResetDurationPos_clicked();
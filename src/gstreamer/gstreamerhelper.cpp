@@ -1,4 +1,5 @@
 #include "gstreamerhelper.h"
+#include <gst/audio/gstaudiobasesink.h>
 
 #include <vector>
 
@@ -111,3 +112,38 @@ void optimize_scaleTempo_for_rate(GstElement *scaleTempo, double playBackRate)
 
     g_object_set(scaleTempo, "search", seekMS, "stride", strideMS, nullptr);
 }
+
+GstElement* gsthlp_find_audio_base_sink(GstElement *element)
+{
+    if (GST_IS_AUDIO_BASE_SINK(element))
+        return GST_ELEMENT(gst_object_ref(element));
+    if (!GST_IS_BIN(element))
+        return nullptr;
+    GstElement *result = nullptr;
+    auto it = gst_bin_iterate_recurse(GST_BIN(element));
+    GValue item = G_VALUE_INIT;
+    bool done = false;
+    while (!done)
+    {
+        switch (gst_iterator_next(it, &item))
+        {
+            case GST_ITERATOR_OK:
+                if (GST_IS_AUDIO_BASE_SINK(g_value_get_object(&item)))
+                {
+                    result = GST_ELEMENT(gst_object_ref(g_value_get_object(&item)));
+                    done = true;
+                }
+                g_value_reset(&item);
+                break;
+            case GST_ITERATOR_RESYNC:
+                gst_iterator_resync(it);
+                break;
+            default:
+                done = true;
+                break;
+        }
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return result;
+}
@@ -24,4 +24,8 @@ void set_sink_ts_offset(GstBin *bin, gint64 offset);
 
 void optimize_scaleTempo_for_rate(GstElement *scaleTempo, double playBackRate);
 
+// The GstAudioBaseSink doing the actual output, element itself or the one inside a bin like autoaudiosink.
+// Returns a new reference, or nullptr if there isn't one (yet, autoaudiosink only creates it on going to READY).
+GstElement* gsthlp_find_audio_base_sink(GstElement *element);
+
 #endif // GSTREAMERHELPER_H
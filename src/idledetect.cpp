@@ -1,4 +1,5 @@
 #include "idledetect.h"
+#include "activitypolicy.h"
 
 IdleDetect::IdleDetect(QObject *parent) : QObject(parent)
 {
@@ -14,6 +15,7 @@ bool IdleDetect::eventFilter(QObject *obj, QEvent *ev)
 {
     if(ev->type() == QEvent::KeyPress || ev->type() == QEvent::MouseMove)
     {
+        ActivityPolicy::instance().userActivity();
         idleMins = 0;
         if (idle)
         {
@@ -0,0 +1,317 @@
+#include "integritychecker.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QVariant>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include "mzarchive.h"
+#include "okjutil.h"
+#include "tagreader.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+// Only the audio stream is exposed, don't spend time plugging video decoders for music videos
+gboolean audioOnlyAutoplugContinue([[maybe_unused]] GstElement *bin, [[maybe_unused]] GstPad *pad, GstCaps *caps, [[maybe_unused]] gpointer userData)
+{
+    auto structure = gst_caps_get_structure(caps, 0);
+    return structure && !g_str_has_prefix(gst_structure_get_name(structure), "video/") && !g_str_has_prefix(gst_structure_get_name(structure), "image/");
+}
+}
+
+QString IntegrityCheckWorker::checkCdgData(const QByteArray &data)
+{
+    constexpr int packetSize{24};
+    constexpr char cdgCommand{0x09};
+    if (data.isEmpty())
+        return "Zero byte CDG file";
+    if (data.size() < packetSize)
+        return "CDG data is shorter than one packet";
+    int graphicsPackets{0};
+    for (int offset = 0; offset + packetSize <= data.size(); offset += packetSize)
+    {
+        if ((data.at(offset) & 0x3F) == cdgCommand)
+            graphicsPackets++;
+    }
+    if (graphicsPackets == 0)
+        return "CDG data contains no graphics packets";
+    return {};
+}
+
+QString IntegrityCheckWorker::checkAudio(const QString &path)
+{
+    if (QFileInfo(path).size() == 0)
+        return "Zero byte audio file";
+    TagReader reader;
+    reader.setMedia(path);
+    if (reader.getDuration() == 0)
+        return "Unable to read audio duration, file is likely corrupt";
+    return checkAudioDecodes(path);
+}
+
+QString IntegrityCheckWorker::checkAudioDecodes(const QString &path)
+{
+    // Pulling a handful of decoded buffers is enough to prove a decoder plugs and the stream starts cleanly
+    constexpr int samplesWanted{16};
+    GError *error{nullptr};
+    auto pipeline = gst_parse_launch("uridecodebin name=decoder caps=audio/x-raw ! appsink name=sink sync=false max-buffers=4", &error);
+    if (error)
+    {
+        QString message = QString("Unable to build decode pipeline: %1").arg(error->message);
+        g_clear_error(&error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return message;
+    }
+    if (!pipeline)
+        return "Unable to build decode pipeline";
+    auto decoder = gst_bin_get_by_name(GST_BIN(pipeline), "decoder");
+    auto uri = gst_filename_to_uri(path.toLocal8Bit(), nullptr);
+    g_object_set(decoder, "uri", uri, nullptr);
+    g_free(uri);
+    g_signal_connect(decoder, "autoplug-continue", G_CALLBACK(audioOnlyAutoplugContinue), nullptr);
+    gst_object_unref(decoder);
+    auto sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    auto bus = gst_element_get_bus(pipeline);
+
+    QString result;
+    int samples{0};
+    QElapsedTimer stallTimer;
+    stallTimer.start();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    while (samples < samplesWanted && !QThread::currentThread()->isInterruptionRequested())
+    {
+        if (auto message = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR))
+        {
+            GError *err{nullptr};
+            gchar *debug{nullptr};
+            gst_message_parse_error(message, &err, &debug);
+            result = QString("Unable to decode audio: %1").arg(err->message);
+            g_clear_error(&err);
+            g_free(debug);
+            gst_message_unref(message);
+            break;
+        }
+        if (auto sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 250 * GST_MSECOND))
+        {
+            gst_sample_unref(sample);
+            samples++;
+            stallTimer.restart();
+            continue;
+        }
+        // Very short files can legitimately hit the end before the wanted sample count
+        if (gst_app_sink_is_eos(GST_APP_SINK(sink)))
+        {
+            if (samples == 0)
+                result = "Audio stream contains no decodable data";
+            break;
+        }
+        if (stallTimer.elapsed() > 10000)
+        {
+            result = "Audio decoding stalled";
+            break;
+        }
+    }
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+    return result;
+}
+
+QString IntegrityCheckWorker::checkZip(const QString &path, qint64 &bytesRead)
+{
+    QFile zipFile(path);
+    if (!zipFile.open(QIODevice::ReadOnly))
+        return "Unable to open zip file";
+    QByteArray zipData = zipFile.readAll();
+    zipFile.close();
+    bytesRead += zipData.size();
+
+    mz_zip_archive archive;
+    memset(&archive, 0, sizeof(archive));
+    if (!mz_zip_reader_init_mem(&archive, zipData.data(), zipData.size(), 0))
+        return "Unable to read zip directory";
+
+    // Only the members MzArchive would actually play matter, stray copies and __MACOSX metadata are never read
+    auto members = MzArchive::findKaraokeMembers(&archive);
+    int cdgIndex = members.cdgIndex;
+    int audioIndex = members.audioIndex;
+    QString audioExt = members.audioExtension;
+    QString error;
+    for (const auto &[index, fStat] : {std::pair{cdgIndex, members.cdgStat}, std::pair{audioIndex, members.audioStat}})
+    {
+        if (index < 0 || !fStat.m_is_supported)
+            continue;
+        // Decompresses the member and compares against the stored CRC32
+        if (!mz_zip_validate_file(&archive, index, 0))
+        {
+            error = QString("Zip member %1 failed validation: %2").arg(fStat.m_filename, mz_zip_get_error_string(mz_zip_get_last_error(&archive)));
+            break;
+        }
+    }
+
+    if (error.isEmpty() && cdgIndex < 0)
+        error = "CDG not found in zip file";
+    if (error.isEmpty() && audioIndex < 0)
+        error = "Audio file not found in zip file";
+    if (error.isEmpty())
+    {
+        size_t cdgSize{0};
+        if (auto cdgData = mz_zip_reader_extract_to_heap(&archive, cdgIndex, &cdgSize, 0))
+        {
+            error = checkCdgData(QByteArray(static_cast<const char*>(cdgData), static_cast<int>(cdgSize)));
+            mz_free(cdgData);
+        }
+        // Members using compression methods miniz doesn't support are left to the infozip fallback at play time
+    }
+    if (error.isEmpty())
+    {
+        QTemporaryDir tmpDir;
+        QString audioPath = tmpDir.path() + QDir::separator() + "verify" + audioExt;
+        if (mz_zip_reader_extract_to_file(&archive, audioIndex, audioPath.toLocal8Bit(), 0))
+            error = checkAudio(audioPath);
+    }
+    mz_zip_reader_end(&archive);
+    return error;
+}
+
+QString IntegrityCheckWorker::checkCdg(const QString &path, qint64 &bytesRead)
+{
+    QFile cdgFile(path);
+    if (!cdgFile.open(QIODevice::ReadOnly))
+        return "CDG file missing";
+    auto cdgData = cdgFile.readAll();
+    bytesRead += cdgData.size();
+    if (auto error = checkCdgData(cdgData); !error.isEmpty())
+        return error;
+    auto audioPath = findMatchingAudioFile(path);
+    if (audioPath.isEmpty())
+        return "Audio file missing";
+    bytesRead += QFileInfo(audioPath).size();
+    return checkAudio(audioPath);
+}
+
+bool IntegrityCheckWorker::waitForBudgetAndResume(qint64 bytesRead, qint64 elapsedMs)
+{
+    qint64 budgetMs = bytesRead * 1000 / std::max(m_bytesPerSecond.load(), static_cast<qint64>(1));
+    qint64 sleepMs = std::max(budgetMs - elapsedMs, static_cast<qint64>(0));
+    while (sleepMs > 0 || m_paused)
+    {
+        if (QThread::currentThread()->isInterruptionRequested())
+            return false;
+        auto slice = std::min(sleepMs, static_cast<qint64>(250));
+        QThread::msleep(slice > 0 ? slice : 250);
+        sleepMs -= slice;
+    }
+    return !QThread::currentThread()->isInterruptionRequested();
+}
+
+void IntegrityCheckWorker::checkFiles(const QStringList &files)
+{
+    if (files.isEmpty())
+        return;
+    std::string m_loggingPrefix{"[IntegrityCheckThread]"};
+    auto logger = spdlog::get("logger");
+    logger->info("{} Starting verification of {} files", m_loggingPrefix, files.size());
+    int checked{0};
+    int failed{0};
+    for (const auto &path : files)
+    {
+        if (!waitForBudgetAndResume(0, 0))
+            break;
+        QElapsedTimer fileTimer;
+        fileTimer.start();
+        qint64 bytesRead{0};
+        QString error;
+        if (!QFile::exists(path))
+            error = "File missing";
+        else if (path.endsWith(".zip", Qt::CaseInsensitive))
+            error = checkZip(path, bytesRead);
+        else if (path.endsWith(".cdg", Qt::CaseInsensitive))
+            error = checkCdg(path, bytesRead);
+        else
+        {
+            bytesRead = QFileInfo(path).size();
+            error = checkAudio(path);
+        }
+        checked++;
+        if (!error.isEmpty())
+        {
+            failed++;
+            logger->warn("{} {} failed verification: {}", m_loggingPrefix, path, error);
+        }
+        emit fileChecked(path, error.isEmpty(), error);
+        if (!waitForBudgetAndResume(bytesRead, fileTimer.elapsed()))
+        {
+            logger->info("{} Verification interrupt requested", m_loggingPrefix);
+            break;
+        }
+    }
+    logger->info("{} Verification complete, checked: {} failed: {}", m_loggingPrefix, checked, failed);
+    emit checkFinished(checked, failed);
+}
+
+IntegrityCheckController::IntegrityCheckController(QObject *parent) : QObject(parent) {
+    m_logger = spdlog::get("logger");
+    m_worker = new IntegrityCheckWorker;
+    workerThread.setObjectName("IntegrityCheck");
+    m_worker->moveToThread(&workerThread);
+    connect(&workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &IntegrityCheckController::operate, m_worker, &IntegrityCheckWorker::checkFiles);
+    connect(m_worker, &IntegrityCheckWorker::fileChecked, this, &IntegrityCheckController::recordResult);
+    workerThread.start();
+    workerThread.setPriority(QThread::IdlePriority);
+}
+
+IntegrityCheckController::~IntegrityCheckController() {
+    workerThread.requestInterruption();
+    workerThread.quit();
+    workerThread.wait();
+}
+
+void IntegrityCheckController::checkFiles()
+{
+    m_logger->info("{} Finding songs due for verification", m_loggingPrefix);
+    QStringList files;
+    QSqlQuery query;
+    query.prepare("SELECT dbsongs.path FROM dbsongs LEFT JOIN fileIntegrity ON fileIntegrity.path = dbsongs.path "
+                  "WHERE fileIntegrity.checked IS NULL OR fileIntegrity.checked < :cutoff "
+                  "ORDER BY fileIntegrity.checked, dbsongs.path");
+    query.bindValue(":cutoff", QDateTime::currentDateTime().addDays(-m_recheckDays));
+    query.exec();
+    while (query.next())
+        files.append(query.value(0).toString());
+    m_logger->info("{} Done, found {} songs due for verification", m_loggingPrefix, files.size());
+    emit operate(files);
+}
+
+void IntegrityCheckController::stopWork()
+{
+    workerThread.requestInterruption();
+}
+
+void IntegrityCheckController::setPlaybackActive(bool active)
+{
+    m_logger->debug("{} {} verification", m_loggingPrefix, active ? "Playback active, pausing" : "Playback stopped, resuming");
+    m_worker->setPaused(active);
+}
+
+void IntegrityCheckController::recordResult(const QString &path, bool ok, const QString &error)
+{
+    QSqlQuery query;
+    query.prepare("INSERT OR REPLACE INTO fileIntegrity (path, checked, ok, error) VALUES(:path, :checked, :ok, :error)");
+    query.bindValue(":path", path);
+    query.bindValue(":checked", QDateTime::currentDateTime());
+    query.bindValue(":ok", ok);
+    query.bindValue(":error", error);
+    query.exec();
+    emit fileChecked(path, ok, error);
+}
@@ -0,0 +1,68 @@
+#ifndef INTEGRITYCHECKER_H
+#define INTEGRITYCHECKER_H
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Reads every file in the list end to end looking for problems that would otherwise only show up at play time:
+// zip CRC errors in the members that get played, missing or empty cdg/audio members, cdg data with no graphics
+// packets and audio that TagLib can't parse or GStreamer can't decode.
+// Runs at idle priority, keeps its reads under an I/O budget and sits idle while paused.
+class IntegrityCheckWorker : public QObject
+{
+    Q_OBJECT
+public:
+    void setPaused(bool paused) { m_paused = paused; }
+    void setBytesPerSecond(qint64 bytesPerSecond) { m_bytesPerSecond = bytesPerSecond; }
+    // Returns an empty string if the cdg data looks playable, otherwise a description of the problem
+    static QString checkCdgData(const QByteArray &data);
+
+public slots:
+    void checkFiles(const QStringList &files);
+
+signals:
+    void fileChecked(const QString &path, bool ok, const QString &error);
+    void checkFinished(int checked, int failed);
+
+private:
+    std::atomic<bool> m_paused{false};
+    std::atomic<qint64> m_bytesPerSecond{8 * 1024 * 1024};
+    QString checkZip(const QString &path, qint64 &bytesRead);
+    QString checkCdg(const QString &path, qint64 &bytesRead);
+    static QString checkAudio(const QString &path);
+    static QString checkAudioDecodes(const QString &path);
+    // Returns false if interruption was requested while waiting
+    bool waitForBudgetAndResume(qint64 bytesRead, qint64 elapsedMs);
+};
+
+class IntegrityCheckController : public QObject
+{
+    Q_OBJECT
+    QThread workerThread;
+    IntegrityCheckWorker *m_worker{nullptr};
+    std::string m_loggingPrefix{"[IntegrityCheck]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    const int m_recheckDays{30};
+
+public:
+    explicit IntegrityCheckController(QObject *parent = nullptr);
+    ~IntegrityCheckController() override;
+    void checkFiles();
+    void stopWork();
+    void setPlaybackActive(bool active);
+
+public slots:
+    void recordResult(const QString &path, bool ok, const QString &error);
+
+signals:
+    void operate(const QStringList &list);
+    void fileChecked(const QString &path, bool ok, const QString &error);
+};
+
+#endif // INTEGRITYCHECKER_H
@@ -31,6 +31,8 @@ void KaraokeFileInfo::readTags()
             mediaFile = baseFn + "MP3";
         else if (QFile::exists(baseFn + "mP3"))
             mediaFile = baseFn + "mP3";
+        // cdg duration comes from the cdg file size
+        tagReader->setReadMode(TagReader::ReadMode::TagsOnly);
         tagReader->setMedia(mediaFile);
         tagArtist = tagReader->getArtist();
         tagTitle = tagReader->getTitle();
@@ -49,6 +51,7 @@ void KaraokeFileInfo::readTags()
         archive.checkAudio();
         QString audioFile = "temp" + archive.audioExtension();
         archive.extractAudio(dir.path(), audioFile);
+        tagReader->setReadMode(TagReader::ReadMode::TagsOnly);
         tagReader->setMedia(dir.path() + QDir::separator() + audioFile);
         tagArtist = tagReader->getArtist();
         tagTitle = tagReader->getTitle();
@@ -63,6 +66,7 @@ void KaraokeFileInfo::readTags()
     else
     {
         m_logger->info("{} readTags called on non zip or cdg file '{}'.  Trying taglib.", m_loggingPrefix, m_filename);
+        tagReader->setReadMode(TagReader::ReadMode::EstimatedDuration);
         tagReader->setMedia(m_filename);
         tagArtist = tagReader->getArtist();
         tagTitle = tagReader->getTitle();
@@ -138,6 +142,7 @@ const int& KaraokeFileInfo::getDuration()
     {
         //TODO: make sure tags are not read twice (here and if reading metadata tags)!
         TagReader reader;
+        reader.setReadMode(TagReader::ReadMode::EstimatedDuration);
         reader.setMedia(m_filename);
         try
         {
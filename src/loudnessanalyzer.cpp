@@ -0,0 +1,355 @@
+#include "loudnessanalyzer.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVariant>
+#include <QtConcurrent>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <algorithm>
+#include <cmath>
+#include "mzarchive.h"
+#include "okjutil.h"
+
+namespace {
+constexpr double pi{3.14159265358979323846};
+
+// caps only decides which decoded streams get exposed, without this decodebin would still plug and run a video
+// decoder for music videos just to throw the frames away
+gboolean audioOnlyAutoplugContinue([[maybe_unused]] GstElement *bin, [[maybe_unused]] GstPad *pad, GstCaps *caps, [[maybe_unused]] gpointer userData)
+{
+    auto structure = gst_caps_get_structure(caps, 0);
+    return structure && !g_str_has_prefix(gst_structure_get_name(structure), "video/") && !g_str_has_prefix(gst_structure_get_name(structure), "image/");
+}
+}
+
+double LoudnessMeter::Biquad::process(double in)
+{
+    double out = b0 * in + z1;
+    z1 = b1 * in - a1 * out + z2;
+    z2 = b2 * in - a2 * out;
+    return out;
+}
+
+LoudnessMeter::LoudnessMeter(int channels) : m_channels(std::clamp(channels, 1, maxChannels))
+{
+    // BS.1770 K-weighting for 48 kHz: a high shelf modelling the head followed by the RLB high pass
+    m_kWeighting.resize(m_channels, {
+            Biquad{1.53512485958697, -2.69169618940638, 1.19839281085285, -1.69065929318241, 0.73248077421585},
+            Biquad{1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621}
+    });
+    m_peakHistory.resize(m_channels);
+    for (auto &history : m_peakHistory)
+        history.fill(0.0);
+    // Hann windowed sinc, phase 0 passes the original samples through and phases 1-3 fill in between them
+    constexpr int taps = oversampling * tapsPerPhase;
+    constexpr double center = taps / 2.0;
+    for (int n = 0; n < taps; n++)
+    {
+        double x = (n - center) / oversampling;
+        double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+        double window = 0.5 * (1.0 + std::cos(pi * (n - center) / center));
+        m_interpolator.at(n) = sinc * window;
+    }
+}
+
+void LoudnessMeter::addFrames(const float *samples, size_t frames)
+{
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        for (int channel = 0; channel < m_channels; channel++)
+        {
+            double sample = samples[frame * m_channels + channel];
+            auto &history = m_peakHistory[channel];
+            history[m_historyPos] = sample;
+            for (int phase = 0; phase < oversampling; phase++)
+            {
+                double interpolated{0.0};
+                for (int tap = 0; tap < tapsPerPhase; tap++)
+                    interpolated += history[(m_historyPos - tap + tapsPerPhase) % tapsPerPhase] * m_interpolator[tap * oversampling + phase];
+                m_peak = std::max(m_peak, std::abs(interpolated));
+            }
+            auto &filters = m_kWeighting[channel];
+            double weighted = filters[1].process(filters[0].process(sample));
+            m_subBlockSum += weighted * weighted;
+        }
+        m_historyPos = (m_historyPos + 1) % tapsPerPhase;
+        if (++m_subBlockFrames < subBlockFrames)
+            continue;
+        // Blocks are 400 ms and start every 100 ms, so each one is the mean of the last four 100 ms sub blocks
+        m_subBlocks[m_subBlockCount++ % m_subBlocks.size()] = m_subBlockSum / subBlockFrames;
+        if (m_subBlockCount >= static_cast<int>(m_subBlocks.size()))
+        {
+            double sum{0.0};
+            for (auto subBlock : m_subBlocks)
+                sum += subBlock;
+            m_blockPowers.push_back(sum / static_cast<double>(m_subBlocks.size()));
+        }
+        m_subBlockSum = 0.0;
+        m_subBlockFrames = 0;
+    }
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    auto toLufs = [] (double power) { return -0.691 + 10.0 * std::log10(power); };
+    auto gatedMean = [this] (double threshold) {
+        double sum{0.0};
+        size_t count{0};
+        for (auto power : m_blockPowers)
+        {
+            if (power > threshold)
+            {
+                sum += power;
+                count++;
+            }
+        }
+        return count == 0 ? 0.0 : sum / static_cast<double>(count);
+    };
+    double absoluteGate = std::pow(10.0, (-70.0 + 0.691) / 10.0);
+    double ungated = gatedMean(absoluteGate);
+    if (ungated <= 0.0)
+        return -HUGE_VAL;
+    double relativeGate = std::pow(10.0, (toLufs(ungated) - 10.0 + 0.691) / 10.0);
+    return toLufs(gatedMean(std::max(absoluteGate, relativeGate)));
+}
+
+double LoudnessMeter::truePeak() const
+{
+    if (m_peak <= 0.0)
+        return -HUGE_VAL;
+    return 20.0 * std::log10(m_peak);
+}
+
+
+LoudnessAnalysisController::LoudnessAnalysisController(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+    connect(this, &LoudnessAnalysisController::songAnalyzed, this, &LoudnessAnalysisController::recordResult, Qt::QueuedConnection);
+    connect(this, &LoudnessAnalysisController::songSkipped, this, &LoudnessAnalysisController::recordSkipped, Qt::QueuedConnection);
+}
+
+LoudnessAnalysisController::~LoudnessAnalysisController()
+{
+    stopWork();
+    m_pool.waitForDone();
+}
+
+void LoudnessAnalysisController::analyzeSongs()
+{
+    if (m_stopping)
+        return;
+    m_logger->info("{} Finding songs without loudness data", m_loggingPrefix);
+    int queued{0};
+    auto queue = [&] (const QString &path, const QString &audioPath, Library library) {
+        if (m_queued.contains(path) || m_skipped.contains(path))
+            return;
+        m_queued.insert(path);
+        QtConcurrent::run(&m_pool, this, &LoudnessAnalysisController::analyzeSong, path, audioPath, library);
+        queued++;
+    };
+    QSqlQuery query;
+    query.exec("SELECT path, audiopath FROM dbsongs WHERE loudness IS NULL AND discid != '!!DROPPED!!' AND discid != '!!BAD!!' ORDER BY artist, title");
+    while (query.next())
+    {
+        auto path = query.value(0).toString();
+        auto audioPath = path;
+        if (path.endsWith(".cdg", Qt::CaseInsensitive))
+            audioPath = query.value(1).isNull() ? findMatchingAudioFile(path) : query.value(1).toString();
+        queue(path, audioPath, Karaoke);
+    }
+    query.exec("SELECT path FROM bmsongs WHERE loudness IS NULL ORDER BY artist, title");
+    while (query.next())
+        queue(query.value(0).toString(), query.value(0).toString(), BreakMusic);
+    m_logger->info("{} Done, queued {} songs for loudness analysis on {} threads", m_loggingPrefix, queued, m_pool.maxThreadCount());
+}
+
+void LoudnessAnalysisController::stopWork()
+{
+    m_stopping = true;
+    m_pool.clear();
+}
+
+void LoudnessAnalysisController::setPlaybackActive(bool active)
+{
+    m_logger->debug("{} {} analysis", m_loggingPrefix, active ? "Playback active, pausing" : "Playback stopped, resuming");
+    m_paused = active;
+}
+
+double LoudnessAnalysisController::playbackGain(const QString &path, Library library)
+{
+    QSqlQuery query;
+    query.prepare(QString("SELECT loudness, truepeak FROM %1 WHERE path = :path").arg(library == Karaoke ? "dbsongs" : "bmsongs"));
+    query.bindValue(":path", path);
+    if (!query.exec() || !query.first() || query.value(0).isNull())
+        return 0.0;
+    double loudness = query.value(0).toDouble();
+    if (loudness < -70.0)
+        return 0.0;
+    // Quiet songs with loud transients only get brought up as far as 1 dB under full scale
+    double gain = std::min(referenceLufs - loudness, -1.0 - query.value(1).toDouble());
+    return std::clamp(gain, -24.0, 12.0);
+}
+
+void LoudnessAnalysisController::recordResult(const QString &path, int library, double loudness, double truePeak)
+{
+    m_queued.remove(path);
+    QSqlQuery query;
+    query.prepare(QString("UPDATE %1 SET loudness = :loudness, truepeak = :truepeak WHERE path = :path").arg(library == Karaoke ? "dbsongs" : "bmsongs"));
+    query.bindValue(":loudness", loudness);
+    query.bindValue(":truepeak", truePeak);
+    query.bindValue(":path", path);
+    query.exec();
+    if (++m_analyzed % 100 == 0 || m_queued.isEmpty())
+        m_logger->info("{} Analyzed {} songs, {} remaining", m_loggingPrefix, m_analyzed, m_queued.size());
+}
+
+void LoudnessAnalysisController::recordSkipped(const QString &path)
+{
+    // Not retried again this session, it stays NULL in the db so the next run tries it again
+    m_queued.remove(path);
+    m_skipped.insert(path);
+}
+
+void LoudnessAnalysisController::analyzeSong(const QString &path, const QString &audioPath, Library library)
+{
+    if (!waitWhilePaused())
+        return;
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+    QElapsedTimer timer;
+    timer.start();
+    QTemporaryDir tmpDir;
+    QString measurePath = audioPath;
+    if (path.endsWith(".zip", Qt::CaseInsensitive))
+    {
+        MzArchive archive(path);
+        measurePath.clear();
+        if (archive.checkAudio() && archive.extractAudio(tmpDir.path(), "analysis" + archive.audioExtension()))
+            measurePath = tmpDir.path() + QDir::separator() + "analysis" + archive.audioExtension();
+    }
+    if (measurePath.isEmpty() || !QFile::exists(measurePath))
+    {
+        m_logger->warn("{} No audio found for {}, skipping", m_loggingPrefix, path);
+        emit songSkipped(path);
+        return;
+    }
+    double loudness{unmeasurable};
+    double truePeak{unmeasurable};
+    if (!measure(measurePath, loudness, truePeak))
+    {
+        if (!m_stopping)
+            emit songSkipped(path);
+        return;
+    }
+    // Decoded but silent, the unmeasurable marker keeps it from being analyzed again on every run
+    if (!std::isfinite(loudness) || !std::isfinite(truePeak))
+    {
+        loudness = unmeasurable;
+        truePeak = unmeasurable;
+    }
+    m_logger->debug("{} {}: {:.1f} LUFS, {:.1f} dBTP in {} ms", m_loggingPrefix, path, loudness, truePeak, timer.elapsed());
+    emit songAnalyzed(path, library, loudness, truePeak);
+}
+
+bool LoudnessAnalysisController::measure(const QString &audioPath, double &loudness, double &truePeak)
+{
+    // Mono is measured upmixed to stereo, the way it ends up coming out of the speakers
+    GError *error{nullptr};
+    auto pipeline = gst_parse_launch("uridecodebin name=decoder caps=audio/x-raw ! audioconvert ! audioresample ! "
+                                     "audio/x-raw,format=F32LE,layout=interleaved,rate=48000,channels=2 ! "
+                                     "appsink name=sink sync=false max-buffers=8", &error);
+    if (error)
+    {
+        m_logger->error("{} Unable to build analysis pipeline: {}", m_loggingPrefix, error->message);
+        g_clear_error(&error);
+    }
+    if (!pipeline)
+        return false;
+    auto decoder = gst_bin_get_by_name(GST_BIN(pipeline), "decoder");
+    auto uri = gst_filename_to_uri(audioPath.toLocal8Bit(), nullptr);
+    g_object_set(decoder, "uri", uri, nullptr);
+    g_free(uri);
+    g_signal_connect(decoder, "autoplug-continue", G_CALLBACK(audioOnlyAutoplugContinue), nullptr);
+    gst_object_unref(decoder);
+    auto sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    auto bus = gst_element_get_bus(pipeline);
+
+    LoudnessMeter meter(2);
+    bool ok{true};
+    QElapsedTimer stallTimer;
+    stallTimer.start();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    while (true)
+    {
+        if (m_stopping)
+        {
+            ok = false;
+            break;
+        }
+        if (m_paused)
+        {
+            // Decoding blocks on the full appsink queue until we pull again
+            if (!waitWhilePaused())
+            {
+                ok = false;
+                break;
+            }
+            stallTimer.restart();
+        }
+        if (auto message = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR))
+        {
+            GError *err{nullptr};
+            gchar *debug{nullptr};
+            gst_message_parse_error(message, &err, &debug);
+            m_logger->warn("{} Unable to decode {}: {}", m_loggingPrefix, audioPath, err->message);
+            g_clear_error(&err);
+            g_free(debug);
+            gst_message_unref(message);
+            ok = false;
+            break;
+        }
+        auto sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 250 * GST_MSECOND);
+        if (!sample)
+        {
+            if (gst_app_sink_is_eos(GST_APP_SINK(sink)))
+                break;
+            if (stallTimer.elapsed() > 30000)
+            {
+                m_logger->warn("{} Decoding {} stalled, giving up", m_loggingPrefix, audioPath);
+                ok = false;
+                break;
+            }
+            continue;
+        }
+        stallTimer.restart();
+        auto buffer = gst_sample_get_buffer(sample);
+        GstMapInfo map;
+        if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ))
+        {
+            meter.addFrames(reinterpret_cast<const float*>(map.data), map.size / (sizeof(float) * 2));
+            gst_buffer_unmap(buffer, &map);
+        }
+        gst_sample_unref(sample);
+    }
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+    if (!ok)
+        return false;
+    loudness = meter.integratedLoudness();
+    truePeak = meter.truePeak();
+    return true;
+}
+
+bool LoudnessAnalysisController::waitWhilePaused()
+{
+    while (m_paused && !m_stopping)
+        QThread::msleep(250);
+    return !m_stopping;
+}
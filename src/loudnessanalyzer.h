@@ -0,0 +1,103 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// EBU R128 / ITU-R BS.1770 integrated loudness and true peak of 48 kHz interleaved float audio.
+// Loudness is K-weighted, measured over 400 ms blocks with 75% overlap and gated at -70 LUFS absolute and
+// -10 LU relative.  True peak comes from 4x oversampling through a windowed sinc interpolator.
+class LoudnessMeter
+{
+public:
+    static constexpr int sampleRate{48000};
+    static constexpr int maxChannels{2};
+    explicit LoudnessMeter(int channels);
+    void addFrames(const float *samples, size_t frames);
+    // LUFS, or -HUGE_VAL if nothing louder than the absolute gate was seen
+    [[nodiscard]] double integratedLoudness() const;
+    // dBTP
+    [[nodiscard]] double truePeak() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+        double z1{0.0};
+        double z2{0.0};
+        double process(double in);
+    };
+    static constexpr int oversampling{4};
+    static constexpr int tapsPerPhase{12};
+    static constexpr int subBlockFrames{sampleRate / 10};
+    int m_channels;
+    std::vector<std::array<Biquad, 2>> m_kWeighting;
+    std::vector<std::array<double, tapsPerPhase>> m_peakHistory;
+    std::array<double, oversampling * tapsPerPhase> m_interpolator{};
+    int m_historyPos{0};
+    double m_peak{0.0};
+    double m_subBlockSum{0.0};
+    int m_subBlockFrames{0};
+    std::array<double, 4> m_subBlocks{};
+    int m_subBlockCount{0};
+    std::vector<double> m_blockPowers;
+};
+
+// Measures the loudness of every karaoke and break music song that hasn't been measured yet and stores it with the
+// song, so playback can level songs through rgvolume without analyzing anything in real time.
+// Songs are analyzed in parallel on idle priority threads and each result is saved as soon as it's ready, an
+// interrupted run picks up with whatever is left next time.  Analysis sits idle while playback is active.
+class LoudnessAnalysisController : public QObject
+{
+    Q_OBJECT
+public:
+    enum Library {
+        Karaoke=0,
+        BreakMusic
+    };
+    // Level songs are normalized to, the same reference ReplayGain 2.0 tags use so tagged and analyzed songs match
+    static constexpr double referenceLufs{-18.0};
+    static constexpr double unmeasurable{-999.0};
+
+    explicit LoudnessAnalysisController(QObject *parent = nullptr);
+    ~LoudnessAnalysisController() override;
+    void analyzeSongs();
+    void stopWork();
+    void setPlaybackActive(bool active);
+    // Gain in dB to bring the song to the reference level, 0 if it hasn't been measured
+    static double playbackGain(const QString &path, Library library);
+
+private slots:
+    void recordResult(const QString &path, int library, double loudness, double truePeak);
+    void recordSkipped(const QString &path);
+
+signals:
+    void songAnalyzed(const QString &path, int library, double loudness, double truePeak);
+    // Missing or undecodable audio, nothing is stored so the song is retried on the next run
+    void songSkipped(const QString &path);
+
+private:
+    std::string m_loggingPrefix{"[LoudnessAnalysis]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    QThreadPool m_pool;
+    QSet<QString> m_queued;
+    QSet<QString> m_skipped;
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_stopping{false};
+    int m_analyzed{0};
+
+    void analyzeSong(const QString &path, const QString &audioPath, Library library);
+    bool measure(const QString &audioPath, double &loudness, double &truePeak);
+    // Returns false if the analysis should be abandoned
+    bool waitWhilePaused();
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -42,6 +42,8 @@
 #include <taglib.h>
 #include <miniz/miniz.h>
 #include "okjtypes.h"
+#include "sqlquerystats.h"
+#include <QtConcurrent>
 
 #ifdef _MSC_VER
 #define NOMINMAX
@@ -223,6 +225,7 @@ void MainWindow::setupShortcuts() {
         m_karaokeSongsModel.updateSongHistory(m_karaokeSongsModel.getIdForPath(nextSongPath));
         play(nextSongPath);
         m_mediaBackendKar.setPitchShift(nextSinger.nextSongKeyChg());
+        recordSongStarted(nextSinger.id, nextSinger.nextSongQueueId(), nextSongPath, nextSinger.nextSongKeyChg());
         m_qModel.setPlayed(nextSinger.nextSongQueueId());
         m_rotModel.setCurrentSinger(nextSinger.id);
         m_rotDelegate.setCurrentSinger(nextSinger.id);
@@ -248,10 +251,7 @@ void MainWindow::setupShortcuts() {
     connect(&m_scutBFfwd, &QShortcut::activated, [&]() {
         auto mediaState = m_mediaBackendBm.state();
         if (mediaState == MediaBackend::PlayingState || mediaState == MediaBackend::PausedState) {
-            auto curPos = m_mediaBackendBm.position();
-            auto duration = m_mediaBackendBm.duration();
-            if (curPos + 5000 < duration)
-                m_mediaBackendBm.setPosition(curPos + 5000);
+            m_mediaBackendBm.seekRelative(5000);
         }
     });
 
@@ -281,11 +281,7 @@ void MainWindow::setupShortcuts() {
     connect(&m_scutBRwnd, &QShortcut::activated, [&]() {
         auto mediaState = m_mediaBackendBm.state();
         if (mediaState == MediaBackend::PlayingState || mediaState == MediaBackend::PausedState) {
-            auto curPos = m_mediaBackendBm.position();
-            if (curPos - 5000 > 0)
-                m_mediaBackendBm.setPosition(curPos - 5000);
-            else
-                m_mediaBackendBm.setPosition(0);
+            m_mediaBackendBm.seekRelative(-5000);
         }
     });
 
@@ -331,10 +327,8 @@ void MainWindow::setupShortcuts() {
     m_scutKFfwd.setContext(Qt::ApplicationShortcut);
     connect(&m_scutKFfwd, &QShortcut::activated, [&]() {
         if (auto state = m_mediaBackendKar.state(); state == MediaBackend::PlayingState ||
-                                                    state == MediaBackend::PausedState) {
-            if (auto curPos = m_mediaBackendKar.position(); curPos + 5000 < m_mediaBackendKar.duration())
-                m_mediaBackendKar.setPosition(curPos + 5000);
-        }
+                                                    state == MediaBackend::PausedState)
+            m_mediaBackendKar.seekRelative(5000);
     });
 
     m_scutKPause.setKey(m_settings.loadShortcutKeySequence("kPause"));
@@ -353,13 +347,8 @@ void MainWindow::setupShortcuts() {
     m_scutKRwnd.setContext(Qt::ApplicationShortcut);
     connect(&m_scutKRwnd, &QShortcut::activated, [&]() {
         if (auto state = m_mediaBackendKar.state(); state == MediaBackend::PlayingState ||
-                                                    state == MediaBackend::PausedState) {
-
-            if (auto curPos = m_mediaBackendKar.position(); curPos - 5000 > 0)
-                m_mediaBackendKar.setPosition(curPos - 5000);
-            else
-                m_mediaBackendKar.setPosition(0);
-        }
+                                                    state == MediaBackend::PausedState)
+            m_mediaBackendKar.seekRelative(-5000);
     });
 
     m_scutKStop.setKey(m_settings.loadShortcutKeySequence("kStop"));
@@ -576,6 +565,7 @@ MainWindow::MainWindow(QWidget *parent) :
         ui(new Ui::MainWindow),
         rng(std::mt19937_64(std::chrono::system_clock::now().time_since_epoch().count())){
     m_logger = spdlog::get("logger");
+    m_startupTimer.start();
 #ifdef _MSC_VER
     timeBeginPeriod(1);
 #endif
@@ -586,6 +576,8 @@ MainWindow::MainWindow(QWidget *parent) :
     setMouseTracking(true);
     m_songShop = std::make_unique<SongShop>(this);
     m_lazyDurationUpdater = std::make_unique<LazyDurationUpdateController>(this);
+    m_integrityChecker = std::make_unique<IntegrityCheckController>(this);
+    m_loudnessAnalyzer = std::make_unique<LoudnessAnalysisController>(this);
     ui->tableViewBmPlaylist->setMouseTracking(true);
     m_historyTabWidget = ui->tabWidgetQueue->widget(1);
     ui->actionShow_Debug_Log->setChecked(m_settings.logShow());
@@ -598,14 +590,24 @@ MainWindow::MainWindow(QWidget *parent) :
     if (!okjDataDir.exists()) {
         okjDataDir.mkpath(okjDataDir.absolutePath());
     }
+    SqlQueryStats::instance().setSlowThresholdMs(m_settings.sqlSlowQueryThresholdMs());
+    SqlQueryStats::instance().setEnabled(m_settings.sqlQueryStatsEnabled());
     dbInit(okjDataDir);
+    logStartupPhase("Database init");
+    auto interruptedSong = m_runState.takeInterruptedSong();
+    // The catalog and break music tables are the slow part of startup on big libraries and nothing needs them
+    // before the window shows, so they load on worker threads while the rest of the setup runs
+    connect(&m_karaokeSongsModel, &TableModelKaraokeSongs::dataLoaded, this, &MainWindow::autosizeViews);
+    connect(&m_tableModelBreakSongs, &TableModelBreakSongs::databaseLoaded, this, &MainWindow::autosizeBmViews);
+    m_karaokeSongsModel.loadDataAsync();
+    m_tableModelBreakSongs.loadDatabaseAsync();
     ui->videoPreviewBm->hide();
     ui->pushButtonKeyDn->setEnabled(false);
     ui->pushButtonKeyUp->setEnabled(false);
     ui->pushButtonTempoDn->setEnabled(false);
     ui->pushButtonTempoUp->setEnabled(false);
-    m_karaokeSongsModel.loadData();
     m_rotModel.loadData();
+    logStartupPhase("Rotation load");
     ui->comboBoxHistoryDblClick->addItems(QStringList{"Adds to queue", "Plays song"});
     ui->tabWidgetQueue->setCurrentIndex(0);
     ui->tableViewHistory->setModel(&m_historySongsModel);
@@ -649,8 +651,7 @@ MainWindow::MainWindow(QWidget *parent) :
     dlgKeyChange = std::make_unique<DlgKeyChange>(&m_qModel, this);
     requestsDialog = std::make_unique<DlgRequests>(m_rotModel, m_songbookApi);
     requestsDialog->setModal(false);
-    dlgSongShop = std::make_unique<DlgSongShop>(m_songShop);
-    dlgSongShop->setModal(false);
+    logStartupPhase("Dialog setup");
     ui->tableViewDB->setModel(&m_karaokeSongsModel);
     ui->tableViewDB->viewport()->installEventFilter(new TableViewToolTipFilter(ui->tableViewDB));
     if (!MediaBackend::canPitchShift()) {
@@ -681,7 +682,6 @@ MainWindow::MainWindow(QWidget *parent) :
     m_tableModelPlaylists = std::make_unique<QSqlTableModel>(this, m_database);
     m_tableModelPlaylists->setTable("bmplaylists");
     m_tableModelPlaylists->sort(2, Qt::AscendingOrder);
-    bmDbDialog = std::make_unique<BmDbDialog>(this);
     ui->comboBoxBmPlaylists->setModel(m_tableModelPlaylists.get());
     ui->comboBoxBmPlaylists->setModelColumn(1);
     if (m_tableModelPlaylists->rowCount() == 0) {
@@ -689,7 +689,6 @@ MainWindow::MainWindow(QWidget *parent) :
         ui->comboBoxBmPlaylists->setCurrentIndex(0);
     }
     ui->tableViewBmDb->setModel(&m_tableModelBreakSongs);
-    m_tableModelBreakSongs.loadDatabase();
     ui->tableViewBmDb->viewport()->installEventFilter(new TableViewToolTipFilter(ui->tableViewBmDb));
     ui->tableViewBmPlaylist->setModel(&m_tableModelPlaylistSongs);
     ui->tableViewBmPlaylist->viewport()->installEventFilter(new TableViewToolTipFilter(ui->tableViewBmPlaylist));
@@ -699,7 +698,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_updateChecker = std::make_unique<UpdateChecker>(this);
     m_updateChecker->checkForUpdates();
     m_timerButtonFlash.start(1000);
-    m_logger->info("{} Initial UI setup complete", m_loggingPrefix);
+    logStartupPhase("Initial UI setup");
     QApplication::processEvents();
     appFontChanged(m_settings.applicationFont());
     QTimer::singleShot(500, [&]() {
@@ -708,9 +707,14 @@ MainWindow::MainWindow(QWidget *parent) :
     });
     m_dlgRegularSingers.regularsChanged();
     m_dlgRegularSingers.setModal(false);
-    updateRotationDuration();
+    // Only the status bar needs this, it can wait until the window is up
+    QTimer::singleShot(0, this, &MainWindow::updateRotationDuration);
+    // Getting the interrupted song going again comes before anything that reads the library in the background
     if (m_settings.dbLazyLoadDurations())
-        m_lazyDurationUpdater->getDurations();
+        QTimer::singleShot(interruptedSong ? 30000 : 0, this, [&] () { m_lazyDurationUpdater->getDurations(); });
+    // File verification reads the whole library, give startup and the first songs of the night a head start
+    QTimer::singleShot(120000, this, [&] () { m_integrityChecker->checkFiles(); });
+    QTimer::singleShot(60000, this, [&] () { m_loudnessAnalyzer->analyzeSongs(); });
     ui->labelVolume->setPixmap(QIcon::fromTheme("player-volume").pixmap(QSize(22, 22)));
     ui->labelVolumeBm->setPixmap(QIcon::fromTheme("player-volume").pixmap(QSize(22, 22)));
     updateIcons();
@@ -725,6 +729,37 @@ MainWindow::MainWindow(QWidget *parent) :
     setupShortcuts();
     setupConnections();
     m_timerSlowUiUpdate.start(10000);
+    logStartupPhase("Settings and connections");
+    if (interruptedSong)
+        QTimer::singleShot(0, this, [this, state = *interruptedSong] () { resumeInterruptedSong(state); });
+    m_logger->info("{} Main window constructed in {} ms{}", m_loggingPrefix, m_startupTimer.elapsed(),
+                   m_karaokeSongsModel.isLoading() ? ", karaoke catalog still loading in the background" : "");
+}
+
+void MainWindow::logStartupPhase(const std::string &phase) {
+    auto now = m_startupTimer.elapsed();
+    m_logger->info("{} Startup phase '{}' took {} ms", m_loggingPrefix, phase, now - m_startupPhaseStartMs);
+    m_startupPhaseStartMs = now;
+}
+
+DlgSongShop *MainWindow::songShopDialog() {
+    // Most hosts never open the shop, so it isn't built until someone does
+    if (!dlgSongShop) {
+        dlgSongShop = std::make_unique<DlgSongShop>(m_songShop);
+        dlgSongShop->setModal(false);
+        m_settings.restoreWindowState(dlgSongShop.get());
+    }
+    return dlgSongShop.get();
+}
+
+BmDbDialog *MainWindow::breakMusicDbDialog() {
+    if (!bmDbDialog) {
+        bmDbDialog = std::make_unique<BmDbDialog>(this);
+        connect(bmDbDialog.get(), &BmDbDialog::bmDbUpdated, this, &MainWindow::bmDbUpdated);
+        connect(bmDbDialog.get(), &BmDbDialog::bmDbCleared, this, &MainWindow::bmDbCleared);
+        connect(bmDbDialog.get(), &BmDbDialog::bmDbAboutToUpdate, this, &MainWindow::bmDatabaseAboutToUpdate);
+    }
+    return bmDbDialog.get();
 }
 
 void MainWindow::loadSettings() {
@@ -752,7 +787,6 @@ void MainWindow::loadSettings() {
     m_settings.restoreSplitterState(ui->splitter);
     m_settings.restoreSplitterState(ui->splitter_2);
     m_settings.restoreSplitterState(ui->splitterBm);
-    m_settings.restoreWindowState(dlgSongShop.get());
     m_bmCurrentPlaylist = m_settings.bmPlaylistIndex();
     ui->comboBoxBmPlaylists->setCurrentIndex(m_settings.bmPlaylistIndex());
     ui->actionDisplay_Filenames->setChecked(m_settings.bmShowFilenames());
@@ -830,6 +864,7 @@ void MainWindow::loadSettings() {
                 if (plSong.has_value()) {
                     if (QFile::exists(plSong->get().path)) {
                         m_mediaBackendBm.setMedia(plSong->get().path);
+                        m_mediaBackendBm.setLoudnessGain(LoudnessAnalysisController::playbackGain(plSong->get().path, LoudnessAnalysisController::BreakMusic));
                         m_mediaBackendBm.play();
                         m_mediaBackendBm.setVolume(ui->sliderBmVolume->value());
                     } else {
@@ -851,19 +886,11 @@ void MainWindow::loadSettings() {
 }
 
 void MainWindow::setupConnections() {
-    connect(ui->tabWidgetQueue, &QTabWidget::currentChanged, [&] (auto tab) {
-       if (tab == 1) {
-           QApplication::processEvents();
-           ui->tableViewHistory->resizeColumnsToContents();
-       }
-    });
     connect(cdgWindow.get(), &DlgCdg::visibilityChanged, ui->btnToggleCdgWindow, &QPushButton::setChecked);
     connect(ui->comboBoxHistoryDblClick, QOverload<int>::of(&QComboBox::currentIndexChanged), &m_settings,
             &Settings::setHistoryDblClickAction);
     connect(&m_rotModel, &TableModelRotation::songDroppedOnSinger, this, &MainWindow::songDroppedOnSinger);
-    connect(dbDialog.get(), &DlgDatabase::databaseUpdateComplete, this, &MainWindow::databaseUpdated);
-    connect(dbDialog.get(), &DlgDatabase::databaseSongAdded, &m_karaokeSongsModel, &TableModelKaraokeSongs::loadData);
-    connect(dbDialog.get(), &DlgDatabase::databaseSongAdded, requestsDialog.get(), &DlgRequests::databaseSongAdded);
+    connect(dbDialog.get(), &DlgDatabase::databaseSongsChanged, this, &MainWindow::databaseSongsChanged);
     connect(dbDialog.get(), &DlgDatabase::databaseCleared, this, &MainWindow::databaseCleared);
     connect(&m_mediaBackendKar, &MediaBackend::volumeChanged, ui->sliderVolume, &QSlider::setValue);
     connect(&m_mediaBackendKar, &MediaBackend::positionChanged, this, &MainWindow::karaokeMediaBackend_positionChanged);
@@ -896,9 +923,16 @@ void MainWindow::setupConnections() {
     connect(&m_mediaBackendBm, &MediaBackend::positionChanged, this, &MainWindow::bmMediaPositionChanged);
     connect(&m_mediaBackendBm, &MediaBackend::durationChanged, this, &MainWindow::bmMediaDurationChanged);
     connect(&m_mediaBackendBm, &MediaBackend::volumeChanged, ui->sliderBmVolume, &QSlider::setValue);
-    connect(bmDbDialog.get(), &BmDbDialog::bmDbUpdated, this, &MainWindow::bmDbUpdated);
-    connect(bmDbDialog.get(), &BmDbDialog::bmDbCleared, this, &MainWindow::bmDbCleared);
-    connect(bmDbDialog.get(), &BmDbDialog::bmDbAboutToUpdate, this, &MainWindow::bmDatabaseAboutToUpdate);
+    // Background file verification must never compete with the live pipelines for disk or CPU
+    auto updateIntegrityCheckPause = [&] () {
+        auto active = [] (MediaBackend &backend) {
+            return backend.state() == MediaBackend::PlayingState || backend.state() == MediaBackend::PausedState;
+        };
+        m_integrityChecker->setPlaybackActive(active(m_mediaBackendKar) || active(m_mediaBackendBm));
+        m_loudnessAnalyzer->setPlaybackActive(active(m_mediaBackendKar) || active(m_mediaBackendBm));
+    };
+    connect(&m_mediaBackendKar, &MediaBackend::stateChanged, this, updateIntegrityCheckPause);
+    connect(&m_mediaBackendBm, &MediaBackend::stateChanged, this, updateIntegrityCheckPause);
     connect(&m_timerKaraokeAA, &QTimer::timeout, this, &MainWindow::karaokeAATimerTimeout);
     connect(ui->actionAutoplay_mode, &QAction::toggled, &m_settings, &Settings::setKaraokeAutoAdvance);
 
@@ -910,6 +944,8 @@ void MainWindow::setupConnections() {
     connect(ui->splitterBm, &QSplitter::splitterMoved, [&]() { autosizeBmViews(); });
     connect(m_updateChecker.get(), &UpdateChecker::newVersionAvailable, this, &MainWindow::newVersionAvailable);
     connect(&m_timerButtonFlash, &QTimer::timeout, this, &MainWindow::timerButtonFlashTimeout);
+    m_timerRotationChanges.setSingleShot(true);
+    connect(&m_timerRotationChanges, &QTimer::timeout, this, &MainWindow::flushRotationChanges);
 
     connect(ui->actionSong_Shop, &QAction::triggered, [&]() { show(); });
     connect(&m_qModel, &TableModelQueueSongs::filesDroppedOnSinger, this, &MainWindow::filesDroppedOnQueue);
@@ -1003,7 +1039,8 @@ void MainWindow::setupConnections() {
             &MainWindow::tableViewRotationContextMenuRequested);
     connect(ui->sliderProgress, &QSlider::sliderPressed, this, &MainWindow::sliderProgressPressed);
     connect(ui->sliderProgress, &QSlider::sliderReleased, this, &MainWindow::sliderProgressReleased);
-    connect(ui->actionManage_Break_DB, &QAction::triggered, bmDbDialog.get(), &BmDbDialog::show);
+    connect(ui->sliderProgress, &QSlider::sliderMoved, &m_mediaBackendKar, &MediaBackend::scrubTo);
+    connect(ui->actionManage_Break_DB, &QAction::triggered, [&] () { breakMusicDbDialog()->show(); });
     connect(ui->comboBoxBmPlaylists, qOverload<int>(&QComboBox::currentIndexChanged), this,
             &MainWindow::comboBoxBmPlaylistsIndexChanged);
     connect(ui->checkBoxBmBreak, &QCheckBox::toggled, this, &MainWindow::checkBoxBmBreakToggled);
@@ -1046,11 +1083,12 @@ void MainWindow::setupConnections() {
             dlgEq->raise();
     });
     connect(ui->pushButtonIncomingRequests, &QPushButton::clicked, requestsDialog.get(), &DlgRequests::show);
-    connect(ui->pushButtonShop, &QPushButton::clicked, dlgSongShop.get(), &DlgSongShop::show);
-    connect(ui->actionSong_Shop, &QAction::triggered, dlgSongShop.get(), &DlgSongShop::show);
+    connect(ui->pushButtonShop, &QPushButton::clicked, [&] () { songShopDialog()->show(); });
+    connect(ui->actionSong_Shop, &QAction::triggered, [&] () { songShopDialog()->show(); });
     connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MainWindow::tabWidgetCurrentChanged);
     connect(ui->sliderBmPosition, &QSlider::sliderPressed, this, &MainWindow::sliderBmPositionPressed);
     connect(ui->sliderBmPosition, &QSlider::sliderReleased, this, &MainWindow::sliderBmPositionReleased);
+    connect(ui->sliderBmPosition, &QSlider::sliderMoved, &m_mediaBackendBm, &MediaBackend::scrubTo);
     connect(ui->btnAddSfx, &QPushButton::clicked, this, &MainWindow::addSfxButtonPressed);
     connect(ui->btnSfxStop, &QPushButton::clicked, this, &MainWindow::stopSfxPlayback);
     connect(ui->lineEditBmSearch, &QLineEdit::textChanged, this, &MainWindow::lineEditBmSearchChanged);
@@ -1083,6 +1121,21 @@ void MainWindow::setupConnections() {
     connect(ui->actionCDG_Decode_Torture, &QAction::triggered, this, &MainWindow::actionCdgDecodeTorture);
     connect(ui->actionWrite_Gstreamer_pipeline_dot_files, &QAction::triggered, this,
             &MainWindow::writeGstPipelineDiagramToDisk);
+    ui->actionRecord_SQL_query_statistics->setChecked(m_settings.sqlQueryStatsEnabled());
+    connect(ui->actionRecord_SQL_query_statistics, &QAction::toggled, [&] (bool checked) {
+        m_settings.setSqlQueryStatsEnabled(checked);
+        if (checked)
+            SqlQueryStats::instance().reset();
+        SqlQueryStats::instance().setEnabled(checked);
+    });
+    connect(ui->actionLog_SQL_query_statistics, &QAction::triggered, [] () {
+        SqlQueryStats::instance().logSummary();
+    });
+    connect(&m_mediaBackendKar, &MediaBackend::playbackHealthRecorded, &m_playbackJournal, &PlaybackJournal::record);
+    connect(&m_mediaBackendBm, &MediaBackend::playbackHealthRecorded, &m_playbackJournal, &PlaybackJournal::record);
+    connect(ui->actionLog_playback_health_summary, &QAction::triggered, [&] () {
+        m_playbackJournal.logSummary();
+    });
     connect(ui->comboBoxSearchType, qOverload<int>(&QComboBox::currentIndexChanged), this,
             &MainWindow::comboBoxSearchTypeIndexChanged);
     connect(ui->actionDocumentation, &QAction::triggered, this, &MainWindow::actionDocumentation);
@@ -1276,6 +1329,35 @@ void MainWindow::dbInit(const QDir &okjDataDir) {
                            singersQuery.value("name").toString().toStdString());
         }
     }
+    if (schemaVersion < 107) {
+        m_logger->info("{} Updating database schema to version 107", m_loggingPrefix);
+        query.exec(
+                "CREATE TABLE playbackJournal ( id INTEGER PRIMARY KEY AUTOINCREMENT, timestamp TIMESTAMP, backend TEXT, filepath TEXT, filetype TEXT, sourcedir TEXT, prepare_ms INT, first_audio_ms INT, first_video_ms INT, audio_qos_events INT, video_frames_dropped INT, warnings INT, watchdog_trips INT, seeks INT, seek_total_ms INT, seek_max_ms INT, played_ms INT, error INT)");
+        query.exec("CREATE INDEX idx_playbackJournal_timestamp ON playbackJournal(timestamp)");
+        query.exec("PRAGMA user_version = 107");
+        m_logger->info("{} DB Schema update to v107 completed", m_loggingPrefix);
+    }
+    if (schemaVersion < 108) {
+        m_logger->info("{} Updating database schema to version 108", m_loggingPrefix);
+        query.exec("CREATE TABLE fileIntegrity ( path TEXT PRIMARY KEY, checked TIMESTAMP, ok INT, error TEXT)");
+        query.exec("PRAGMA user_version = 108");
+        m_logger->info("{} DB Schema update to v108 completed", m_loggingPrefix);
+    }
+    if (schemaVersion < 109) {
+        m_logger->info("{} Updating database schema to version 109", m_loggingPrefix);
+        query.exec("ALTER TABLE dbsongs ADD COLUMN audiopath TEXT");
+        query.exec("PRAGMA user_version = 109");
+        m_logger->info("{} DB Schema update to v109 completed", m_loggingPrefix);
+    }
+    if (schemaVersion < 110) {
+        m_logger->info("{} Updating database schema to version 110", m_loggingPrefix);
+        query.exec("ALTER TABLE dbsongs ADD COLUMN loudness REAL");
+        query.exec("ALTER TABLE dbsongs ADD COLUMN truepeak REAL");
+        query.exec("ALTER TABLE bmsongs ADD COLUMN loudness REAL");
+        query.exec("ALTER TABLE bmsongs ADD COLUMN truepeak REAL");
+        query.exec("PRAGMA user_version = 110");
+        m_logger->info("{} DB Schema update to v110 completed", m_loggingPrefix);
+    }
 }
 
 
@@ -1283,6 +1365,8 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
     m_mediaTempDir = std::make_unique<QTemporaryDir>();
     if (m_mediaBackendKar.state() != MediaBackend::PausedState) {
         m_logger->info("{} Playing file: {}", m_loggingPrefix, karaokeFilePath.toStdString());
+        QElapsedTimer prepareTimer;
+        prepareTimer.start();
         if (m_mediaBackendKar.state() == MediaBackend::PlayingState) {
             if (m_settings.karaokeAutoAdvance()) {
                 m_kAASkip = true;
@@ -1293,6 +1377,7 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
                 m_rotModel.singerMove(0, static_cast<int>(m_rotModel.singerCount() - 1));
             ui->spinBoxTempo->setValue(100);
         }
+        m_mediaBackendKar.setLoudnessGain(LoudnessAnalysisController::playbackGain(karaokeFilePath, LoudnessAnalysisController::Karaoke));
         if (karaokeFilePath.endsWith(".zip", Qt::CaseInsensitive)) {
             MzArchive archive(karaokeFilePath);
             if ((archive.checkCDG()) && (archive.checkAudio())) {
@@ -1318,6 +1403,7 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
                     if (!k2k)
                         m_mediaBackendBm.fadeOut(!m_settings.bmKCrossFade());
                     m_logger->info("{} Beginning playback of file: {}", m_loggingPrefix, audioFile.toStdString());
+                    m_mediaBackendKar.setPlaybackSource(karaokeFilePath, prepareTimer.elapsed());
                     QApplication::setOverrideCursor(Qt::WaitCursor);
                     m_mediaBackendKar.play();
                     QApplication::restoreOverrideCursor();
@@ -1330,36 +1416,39 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
                 return;
             }
         } else if (karaokeFilePath.endsWith(".cdg", Qt::CaseInsensitive)) {
-            QString cdgTmpFile = "tmp.cdg";
-            QString audTmpFile = "tmp.mp3";
-            QFile cdgFile(karaokeFilePath);
-            if (!cdgFile.exists()) {
+            QFileInfo cdgInfo(karaokeFilePath);
+            if (!cdgInfo.exists()) {
                 m_timerTest.stop();
                 QMessageBox::warning(this, tr("Bad karaoke file"), tr("CDG file missing."), QMessageBox::Ok);
                 return;
-            } else if (cdgFile.size() == 0) {
+            } else if (cdgInfo.size() == 0) {
                 m_timerTest.stop();
                 QMessageBox::warning(this, tr("Bad karaoke file"), tr("CDG file contains no data"), QMessageBox::Ok);
                 return;
             }
-            QString audioFilename = findMatchingAudioFile(karaokeFilePath);
+            QString audioFilename = m_karaokeSongsModel.findCdgAudioFile(karaokeFilePath);
             if (audioFilename == "") {
                 m_timerTest.stop();
                 QMessageBox::warning(this, tr("Bad karaoke file"), tr("Audio file missing."), QMessageBox::Ok);
                 return;
             }
-            QFile audioFile(audioFilename);
-            if (audioFile.size() == 0) {
+            if (QFileInfo(audioFilename).size() == 0) {
                 m_timerTest.stop();
                 QMessageBox::warning(this, tr("Bad karaoke file"), tr("Audio file contains no data"), QMessageBox::Ok);
                 return;
             }
-            cdgFile.copy(m_mediaTempDir->path() + QDir::separator() + cdgTmpFile);
-            QFile::copy(audioFilename, m_mediaTempDir->path() + QDir::separator() + audTmpFile);
-            m_mediaBackendKar.setMediaCdg(m_mediaTempDir->path() + QDir::separator() + cdgTmpFile,
-                                          m_mediaTempDir->path() + QDir::separator() + audTmpFile);
+            // The cdg is read into memory by the appsrc, only the audio goes through a gstreamer URI
+            QString audioPlayPath = audioFilename;
+            if (!pathIsSafeForGstreamer(audioFilename)) {
+                audioPlayPath = m_mediaTempDir->path() + QDir::separator() + "tmp." + QFileInfo(audioFilename).suffix();
+                m_logger->info("{} Playing temporary copy of audio file to avoid bad filename stuff w/ gstreamer: {}",
+                               m_loggingPrefix, audioPlayPath);
+                QFile::copy(audioFilename, audioPlayPath);
+            }
+            m_mediaBackendKar.setMediaCdg(karaokeFilePath, audioPlayPath);
             if (!k2k)
                 m_mediaBackendBm.fadeOut(!m_settings.bmKCrossFade());
+            m_mediaBackendKar.setPlaybackSource(karaokeFilePath, prepareTimer.elapsed());
             QApplication::setOverrideCursor(Qt::WaitCursor);
             m_mediaBackendKar.play();
             QApplication::restoreOverrideCursor();
@@ -1374,6 +1463,7 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
             m_mediaBackendKar.setMedia(tmpFilePath);
             if (!k2k)
                 m_mediaBackendBm.fadeOut();
+            m_mediaBackendKar.setPlaybackSource(karaokeFilePath, prepareTimer.elapsed());
             m_mediaBackendKar.play();
             m_mediaBackendKar.fadeInImmediate();
         }
@@ -1396,13 +1486,101 @@ void MainWindow::play(const QString &karaokeFilePath, const bool &k2k) {
         m_kAASkip = false;
 }
 
+void MainWindow::recordSongStarted(const int singerId, const int queueSongId, const QString &path, const int keyChange) {
+    RunStateRecorder::RunState state;
+    state.singerId = singerId;
+    state.singer = m_curSinger;
+    state.queueSongId = queueSongId;
+    state.path = path;
+    state.artist = m_curArtist;
+    state.title = m_curTitle;
+    state.keyChange = keyChange;
+    state.tempo = ui->spinBoxTempo->value();
+    m_runState.songStarted(state);
+}
+
+void MainWindow::resumeInterruptedSong(const RunStateRecorder::RunState &state) {
+    if (m_mediaBackendKar.state() != MediaBackend::StoppedState)
+        return;
+    if (!QFile::exists(state.path)) {
+        m_logger->warn("{} Not resuming interrupted song, file no longer exists: {}", m_loggingPrefix, state.path);
+        return;
+    }
+    // Back up a little so the singer can find their place again
+    auto resumeMs = std::max(state.positionMs - m_resumeLeadInMs, static_cast<qint64>(0));
+    m_logger->info("{} Previous run was interrupted during {} - {} for {}, resuming at {} ms", m_loggingPrefix,
+                   state.artist, state.title, state.singer, resumeMs);
+    m_curSinger = state.singer;
+    m_curArtist = state.artist;
+    m_curTitle = state.title;
+    ui->labelSinger->setText(m_curSinger);
+    ui->labelArtist->setText(m_curArtist);
+    ui->labelTitle->setText(m_curTitle);
+    if (m_rotModel.getSinger(state.singerId).isValid()) {
+        m_rotModel.setCurrentSinger(state.singerId);
+        m_rotDelegate.setCurrentSinger(state.singerId);
+    }
+    ui->spinBoxTempo->setValue(state.tempo);
+    play(state.path);
+    m_mediaBackendKar.setPitchShift(state.keyChange);
+    recordSongStarted(state.singerId, state.queueSongId, state.path, state.keyChange);
+    if (resumeMs == 0 && !state.paused)
+        return;
+    // Stay silent until the seek lands, the position is only seekable once the pipeline has prerolled
+    m_mediaBackendKar.fadeOutImmediate();
+    auto playing = std::make_shared<QMetaObject::Connection>();
+    auto seeked = std::make_shared<QMetaObject::Connection>();
+    auto ended = std::make_shared<QMetaObject::Connection>();
+    auto settled = std::make_shared<bool>(false);
+    // Everything below belongs to this song, nothing may still be waiting on it once it stops or a seek lands
+    auto release = [this, playing, seeked, ended, settled] () {
+        *settled = true;
+        disconnect(*playing);
+        disconnect(*seeked);
+        disconnect(*ended);
+    };
+    auto restore = [this, release, paused = state.paused] () {
+        release();
+        if (paused)
+            m_mediaBackendKar.pause();
+        else
+            m_mediaBackendKar.fadeIn(false);
+    };
+    *ended = connect(&m_mediaBackendKar, &MediaBackend::stateChanged, this, [release] (const MediaBackend::State backendState) {
+        if (backendState == MediaBackend::StoppedState || backendState == MediaBackend::EndOfMediaState)
+            release();
+    });
+    *playing = connect(&m_mediaBackendKar, &MediaBackend::stateChanged, this, [this, playing, seeked, restore, resumeMs] (const MediaBackend::State backendState) {
+        if (backendState != MediaBackend::PlayingState)
+            return;
+        disconnect(*playing);
+        *seeked = connect(&m_mediaBackendKar, &MediaBackend::seekCompleted, this, [restore] () {
+            restore();
+        });
+        if (!m_mediaBackendKar.setPosition(resumeMs)) {
+            m_logger->warn("{} Unable to seek to the resume position, continuing from the start", m_loggingPrefix);
+            restore();
+        }
+    });
+    // Never leave the song muted if the pipeline doesn't preroll or the seek never completes
+    QTimer::singleShot(m_resumeSeekTimeoutMs, this, [this, settled, restore] () {
+        if (*settled)
+            return;
+        m_logger->warn("{} Resume seek did not complete within {} ms, restoring output", m_loggingPrefix, m_resumeSeekTimeoutMs);
+        restore();
+    });
+}
+
 MainWindow::~MainWindow() {
     m_shuttingDown = true;
+    m_runState.songStopped();
     cdgWindow->stopTicker();
 #ifdef _MSC_VER
     timeEndPeriod(1);
 #endif
     m_lazyDurationUpdater->stopWork();
+    m_integrityChecker->stopWork();
+    m_loudnessAnalyzer->stopWork();
     m_settings.bmSetVolume(ui->sliderBmVolume->value());
     m_settings.setAudioVolume(ui->sliderVolume->value());
     m_logger->info("{} Saving volumes - K: {} BM {}", m_loggingPrefix, m_settings.audioVolume(), m_settings.bmVolume());
@@ -1413,10 +1591,12 @@ MainWindow::~MainWindow() {
     m_settings.saveColumnWidths(ui->tableViewDB);
     m_settings.saveColumnWidths(ui->tableViewRotation);
     m_settings.saveWindowState(requestsDialog.get());
-    m_settings.saveWindowState(dlgSongShop.get());
+    if (dlgSongShop)
+        m_settings.saveWindowState(dlgSongShop.get());
     m_settings.saveWindowState(dbDialog.get());
     m_settings.saveWindowState(this);
     m_settings.saveSplitterState(ui->splitterBm);
+    m_playbackJournal.flush();
     m_settings.saveColumnWidths(ui->tableViewBmDb);
     m_settings.saveColumnWidths(ui->tableViewBmPlaylist);
     m_settings.bmSetPlaylistIndex(ui->comboBoxBmPlaylists->currentIndex());
@@ -1429,12 +1609,23 @@ void MainWindow::search() {
     m_karaokeSongsModel.search(ui->lineEdit->text());
 }
 
-void MainWindow::databaseUpdated() {
-    m_karaokeSongsModel.loadData();
-    search();
-    autosizeViews();
-    m_settings.restoreColumnWidths(ui->tableViewDB);
-    requestsDialog->databaseUpdateComplete();
+void MainWindow::databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds,
+                                      const QVector<int> &removedIds) {
+    m_logger->info("{} Applying db changes to song models - added: {} updated: {} removed: {}", m_loggingPrefix,
+                   addedIds.size(), updatedIds.size(), removedIds.size());
+    m_karaokeSongsModel.applySongChanges(addedIds, updatedIds, removedIds);
+    requestsDialog->databaseSongsChanged(addedIds, updatedIds, removedIds);
+    if (!addedIds.isEmpty() || !updatedIds.isEmpty()) {
+        autosizeViews();
+        m_settings.restoreColumnWidths(ui->tableViewDB);
+    }
+    if (!addedIds.isEmpty()) {
+        restartLazyDurationUpdater();
+        m_loudnessAnalyzer->analyzeSongs();
+    }
+}
+
+void MainWindow::restartLazyDurationUpdater() {
     m_lazyDurationUpdater->stopWork();
     m_lazyDurationUpdater->deleteLater();
     m_lazyDurationUpdater = std::make_unique<LazyDurationUpdateController>(this);
@@ -1513,6 +1704,7 @@ void MainWindow::buttonPauseClicked() {
 }
 
 void MainWindow::tableViewDbDoubleClicked(const QModelIndex &index) {
+    SqlQueryStatsAction sqlStatsAction("Add song to queue");
     if (!index.isValid())
         return;
     auto song = qvariant_cast<std::shared_ptr<okj::KaraokeSong>>(index.data(Qt::UserRole));
@@ -1537,6 +1729,7 @@ void MainWindow::tableViewDbDoubleClicked(const QModelIndex &index) {
 }
 
 void MainWindow::tableViewRotationDoubleClicked(const QModelIndex &index) {
+    SqlQueryStatsAction sqlStatsAction("Play singer from rotation");
     if (index.column() <= 3) {
         m_k2kTransition = false;
         int singerId = index.data(Qt::UserRole).toInt();
@@ -1586,6 +1779,7 @@ void MainWindow::tableViewRotationDoubleClicked(const QModelIndex &index) {
                 m_historySongsModel.saveSong(m_curSinger, nextSongPath, m_curArtist, m_curTitle, curSongId,
                                              curKeyChange);
             m_mediaBackendKar.setPitchShift(curKeyChange);
+            recordSongStarted(singerId, singer.nextSongQueueId(), nextSongPath, curKeyChange);
             m_qModel.setPlayed(singer.nextSongQueueId());
             m_rotDelegate.setCurrentSinger(singerId);
             m_rotModel.setCurrentSinger(singerId);
@@ -1666,6 +1860,7 @@ void MainWindow::tableViewRotationClicked(const QModelIndex &index) {
 }
 
 void MainWindow::tableViewQueueDoubleClicked(const QModelIndex &index) {
+    SqlQueryStatsAction sqlStatsAction("Play song from queue");
     if (!index.isValid())
         return;
     auto song = qvariant_cast<okj::QueueSong>(index.data(Qt::UserRole));
@@ -1715,6 +1910,7 @@ void MainWindow::tableViewQueueDoubleClicked(const QModelIndex &index) {
     if (m_settings.treatAllSingersAsRegs() || singer.regular)
         m_historySongsModel.saveSong(singer.name, song.path, song.artist, song.title, song.songId, song.keyChange);
     m_mediaBackendKar.setPitchShift(song.keyChange);
+    recordSongStarted(singer.id, song.id, song.path, song.keyChange);
     m_qModel.setPlayed(song.id);
     m_rotModel.setCurrentSinger(singer.id);
     m_rotDelegate.setCurrentSinger(singer.id);
@@ -1802,6 +1998,7 @@ void MainWindow::actionSettingsTriggered() {
 }
 
 void MainWindow::songDroppedOnSinger(const int &singerId, const int &songId, const int &dropRow) {
+    SqlQueryStatsAction sqlStatsAction("Song dropped on singer");
     m_qModel.loadSinger(singerId);
     m_qModel.add(songId);
     ui->tableViewRotation->clearSelection();
@@ -1900,6 +2097,7 @@ void MainWindow::karaokeMediaBackend_positionChanged(const qint64 &position) {
         ui->labelElapsedTime->setText(MediaBackend::msToMMSS(position));
         ui->labelRemainTime->setText(MediaBackend::msToMMSS(m_mediaBackendKar.duration() - position));
         m_rotModel.setCurRemainSecs((int) (m_mediaBackendKar.duration() - position) / 1000);
+        m_runState.updatePlayback(position, ui->spinBoxKey->value(), ui->spinBoxTempo->value());
     }
 }
 
@@ -1910,6 +2108,10 @@ void MainWindow::karaokeMediaBackend_durationChanged(const qint64 &duration) {
 void MainWindow::karaokeMediaBackend_stateChanged(const MediaBackend::State &state) {
     if (m_shuttingDown)
         return;
+    if (state == MediaBackend::StoppedState)
+        m_runState.songStopped();
+    else if (state == MediaBackend::PlayingState || state == MediaBackend::PausedState)
+        m_runState.setPaused(state == MediaBackend::PausedState);
     if (state == MediaBackend::StoppedState) {
         m_logger->info("{} MainWindow - audio backend state is now STOPPED", m_loggingPrefix);
         if (ui->labelTotalTime->text() == "0:00") {
@@ -2055,15 +2257,33 @@ void MainWindow::hasActiveVideoChanged() {
 }
 
 void MainWindow::rotationDataChanged() {
+    if (m_shuttingDown)
+        return;
+    // Bulk operations (reorders, loading regulars, clearing the rotation) call this many times in a row.
+    // Only mark the rotation dirty here, the views and outputs are updated at most once per event loop
+    // turn and no more often than every m_rotationFlushMinIntervalMs.
+    if (m_timerRotationChanges.isActive())
+        return;
+    qint64 sinceLastFlush = m_lastRotationFlush.isValid() ? m_lastRotationFlush.elapsed() : m_rotationFlushMinIntervalMs;
+    m_timerRotationChanges.start(static_cast<int>(std::max<qint64>(0, m_rotationFlushMinIntervalMs - sinceLastFlush)));
+}
+
+void MainWindow::flushRotationChanges() {
     if (m_shuttingDown)
         return;
     m_logger->trace("{} [{}] Called", m_loggingPrefix, __func__);
+    SqlQueryStatsAction sqlStatsAction("Rotation changed");
+    m_lastRotationFlush.start();
     auto st = std::chrono::high_resolution_clock::now();
     if (m_settings.rotationShowNextSong())
         autosizeRotationCols();
     updateRotationDuration();
     QString sep = "•";
-    requestsDialog->rotationChanged();
+    // The requests dialog only cares about the singer names
+    if (auto singers = m_rotModel.singers(); singers != m_lastRequestsDialogSingers) {
+        m_lastRequestsDialogSingers = singers;
+        requestsDialog->rotationChanged();
+    }
     QString statusBarText = "Singers: ";
     statusBarText += QString::number(m_rotModel.singerCount());
     m_labelSingerCount.setText(statusBarText);
@@ -2299,7 +2519,7 @@ void MainWindow::editSong(const std::shared_ptr<okj::KaraokeSong>& song) {
         isCdg = true;
     QString mediaFile;
     if (isCdg)
-        mediaFile = findMatchingAudioFile(song->path);
+        mediaFile = m_karaokeSongsModel.findCdgAudioFile(song->path);
     TableModelKaraokeSourceDirs model;
     SourceDir srcDir = model.getDirByPath(song->path);
     bool allowRename = true;
@@ -2453,7 +2673,7 @@ void MainWindow::editSong(const std::shared_ptr<okj::KaraokeSong>& song) {
         }
         m_logger->info("{} New filename: {}", m_loggingPrefix, newFn.toStdString());
         query.prepare(
-                "UPDATE dbsongs SET artist = :artist, title = :title, discid = :songid, path = :path, filename = :filename, searchstring = :searchstring WHERE songid = :rowid");
+                "UPDATE dbsongs SET artist = :artist, title = :title, discid = :songid, path = :path, filename = :filename, searchstring = :searchstring, audiopath = :audiopath WHERE songid = :rowid");
         QString newArtist = dlg.artist();
         QString newTitle = dlg.title();
         QString newSongId = dlg.songId();
@@ -2466,6 +2686,7 @@ void MainWindow::editSong(const std::shared_ptr<okj::KaraokeSong>& song) {
         query.bindValue(":path", newPath);
         query.bindValue(":filename", newFn);
         query.bindValue(":searchstring", newSearchString);
+        query.bindValue(":audiopath", isCdg ? QFileInfo(newPath).absolutePath() + "/" + newMediaFn : QString());
         query.bindValue(":rowid", song->id);
         query.exec();
         if (auto error = query.lastError(); error.type() != QSqlError::NoError) {
@@ -2482,7 +2703,7 @@ void MainWindow::editSong(const std::shared_ptr<okj::KaraokeSong>& song) {
             msgBoxInfo.setInformativeText("The file has been renamed and the database has been updated successfully.");
             msgBoxInfo.setStandardButtons(QMessageBox::Ok);
             msgBoxInfo.exec();
-            m_karaokeSongsModel.loadData();
+            databaseSongsChanged({}, {song->id}, {});
             return;
         }
     } else {
@@ -2513,7 +2734,7 @@ void MainWindow::editSong(const std::shared_ptr<okj::KaraokeSong>& song) {
             msgBoxInfo.setInformativeText("The database has been updated successfully.");
             msgBoxInfo.setStandardButtons(QMessageBox::Ok);
             msgBoxInfo.exec();
-            m_karaokeSongsModel.loadData();
+            databaseSongsChanged({}, {song->id}, {});
             return;
         }
     }
@@ -2541,7 +2762,7 @@ void MainWindow::markSongBad(const std::shared_ptr<okj::KaraokeSong>& song) {
             isCdg = true;
         QString mediaFile;
         if (isCdg)
-            mediaFile = findMatchingAudioFile(song->path);
+            mediaFile = m_karaokeSongsModel.findCdgAudioFile(song->path);
         QFile file(song->path);
         auto ret = m_karaokeSongsModel.removeBadSong(song->path);
         switch (ret) {
@@ -2596,6 +2817,7 @@ void MainWindow::karaokeAATimerTimeout() {
         m_karaokeSongsModel.updateSongHistory(m_karaokeSongsModel.getIdForPath(m_kAANextSongPath));
         play(m_kAANextSongPath);
         m_mediaBackendKar.setPitchShift(singer.nextSongKeyChg());
+        recordSongStarted(m_kAANextSinger, singer.nextSongQueueId(), m_kAANextSongPath, singer.nextSongKeyChg());
         m_qModel.setPlayed(singer.nextSongQueueId());
         m_rotModel.setCurrentSinger(m_kAANextSinger);
         m_rotDelegate.setCurrentSinger(m_kAANextSinger);
@@ -2696,6 +2918,7 @@ void MainWindow::bmAddPlaylist(const QString &title) {
 
 void MainWindow::bmDbUpdated() {
     m_tableModelBreakSongs.loadDatabase();
+    m_loudnessAnalyzer->analyzeSongs();
     ui->comboBoxBmPlaylists->setCurrentIndex(0);
 }
 
@@ -2725,6 +2948,7 @@ void MainWindow::bmMediaStateChanged(const MediaBackend::State &newState) {
             auto plSong = m_tableModelPlaylistSongs.getNextPlSong();
             if (plSong.has_value()) {
                 m_mediaBackendBm.setMedia(plSong->get().path);
+                m_mediaBackendBm.setLoudnessGain(LoudnessAnalysisController::playbackGain(plSong->get().path, LoudnessAnalysisController::BreakMusic));
                 m_tableModelPlaylistSongs.setCurrentPosition(plSong->get().position);
                 m_logger->info("{} Break music auto-advancing to song: {}", m_loggingPrefix,
                                plSong->get().path.toStdString());
@@ -2846,6 +3070,7 @@ void MainWindow::tableViewBmPlaylistDoubleClicked(const QModelIndex &index) {
     if (!plSong.has_value())
         return;
     m_mediaBackendBm.setMedia(plSong->get().path);
+    m_mediaBackendBm.setLoudnessGain(LoudnessAnalysisController::playbackGain(plSong->get().path, LoudnessAnalysisController::BreakMusic));
     m_mediaBackendBm.play();
     if (m_mediaBackendKar.state() != MediaBackend::PlayingState)
         m_mediaBackendBm.fadeInImmediate();
@@ -2948,6 +3173,7 @@ void MainWindow::actionPlaylistImportTriggered() {
         QSqlQuery query;
         query.exec("BEGIN TRANSACTION");
         TagReader reader;
+        reader.setReadMode(TagReader::ReadMode::EstimatedDuration);
         for (int i = 0; i < files.size(); i++) {
             if (QFile(files.at(i)).exists()) {
                 reader.setMedia(files.at(i).toLocal8Bit());
@@ -3179,7 +3405,8 @@ void MainWindow::closeEvent(QCloseEvent *event) {
         m_settings.saveWindowState(cdgWindow.get());
     m_settings.setShowCdgWindow(cdgWindow->isVisible());
     cdgWindow->setVisible(false);
-    dlgSongShop->setVisible(false);
+    if (dlgSongShop)
+        dlgSongShop->setVisible(false);
     requestsDialog->setVisible(false);
     event->accept();
 }
@@ -3223,67 +3450,84 @@ void MainWindow::newVersionAvailable(const QString &version) {
 }
 
 void MainWindow::filesDroppedOnQueue(const QList<QUrl> &urls, const int &singerId, const int &position) {
-            foreach (QUrl url, urls) {
-            QString file = url.toLocalFile();
-            if (QFile(file).exists()) {
-                if (file.endsWith(".zip", Qt::CaseInsensitive)) {
-                    MzArchive archive(file);
-                    if (!archive.isValidKaraokeFile()) {
-                        QMessageBox msgBox;
-                        msgBox.setWindowTitle("Invalid karaoke file!");
-                        msgBox.setText("Invalid karaoke file dropped on queue");
-                        msgBox.setIcon(QMessageBox::Warning);
-                        msgBox.setInformativeText(file);
-                        msgBox.exec();
-                        continue;
-                    }
-                } else if (file.endsWith(".cdg", Qt::CaseInsensitive)) {
-                    if (m_karaokeSongsModel.findCdgAudioFile(file) == QString()) {
-                        QMessageBox msgBox;
-                        msgBox.setWindowTitle("Invalid karaoke file!");
-                        msgBox.setIcon(QMessageBox::Warning);
-                        msgBox.setText("CDG file dropped on queue has no matching audio file");
-                        msgBox.setInformativeText(file);
-                        msgBox.exec();
-                        continue;
-                    }
-                } else if (!file.endsWith(".mp4", Qt::CaseInsensitive) && !file.endsWith(".mkv", Qt::CaseInsensitive) &&
-                           !file.endsWith(".avi", Qt::CaseInsensitive) && !file.endsWith(".m4v", Qt::CaseInsensitive)) {
-                    QMessageBox msgBox;
-                    msgBox.setWindowTitle("Invalid karaoke file!");
-                    msgBox.setText(
-                            "Unsupported file type dropped on queue.  Supported file types: mp3+g zip, cdg, mp4, mkv, avi");
-                    msgBox.setIcon(QMessageBox::Warning);
-                    msgBox.setInformativeText(file);
-                    msgBox.exec();
-                    continue;
-                }
-                m_logger->info("{} Karaoke file dropped. Singer: {} Pos: {} Path: {}", m_loggingPrefix, singerId,
-                               position, file.toStdString());
-                QFileInfo dFileInfo(file);
-
-                okj::KaraokeSong droppedSong{
-                        -1,
-                        "--Dropped Song--",
-                        "--dropped song--",
-                        dFileInfo.completeBaseName(),
-                        dFileInfo.completeBaseName().toLower(),
-                        "!!DROPPED!!",
-                        "!!dropped!!",
-                        0,
-                        dFileInfo.fileName(),
-                        file,
-                        "",
-                        0,
-                        QDateTime()
-                };
-                int songId = m_karaokeSongsModel.addSong(droppedSong);
-                m_logger->info("{} addSong returned songid: {}", m_loggingPrefix, songId);
-                if (songId == -1)
-                    continue;
-                m_qModel.insert(songId, position);
-            }
+    QStringList files;
+    for (const auto &url : urls)
+        files.append(url.toLocalFile());
+    m_logger->info("{} {} files dropped on queue. Singer: {} Pos: {}", m_loggingPrefix, files.size(), singerId,
+                   position);
+    // Zip validation reads each whole file, so a big drop gets checked on the thread pool and added in one batch
+    auto watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, files, singerId, position] () {
+        watcher->deleteLater();
+        addDroppedFiles(files, watcher->future().results(), singerId, position);
+    });
+    watcher->setFuture(QtConcurrent::mapped(files, &MainWindow::droppedFileRejectReason));
+}
+
+QString MainWindow::droppedFileRejectReason(const QString &file) {
+    if (!QFile::exists(file))
+        return "File not found";
+    if (file.endsWith(".zip", Qt::CaseInsensitive)) {
+        MzArchive archive(file);
+        if (!archive.isValidKaraokeFile())
+            return "Invalid karaoke file";
+    } else if (file.endsWith(".cdg", Qt::CaseInsensitive)) {
+        if (findMatchingAudioFile(file).isEmpty())
+            return "CDG file has no matching audio file";
+    } else if (!file.endsWith(".mp4", Qt::CaseInsensitive) && !file.endsWith(".mkv", Qt::CaseInsensitive) &&
+               !file.endsWith(".avi", Qt::CaseInsensitive) && !file.endsWith(".m4v", Qt::CaseInsensitive)) {
+        return "Unsupported file type";
+    }
+    return {};
+}
+
+void MainWindow::addDroppedFiles(const QStringList &files, const QList<QString> &rejectReasons, const int singerId,
+                                 const int position) {
+    QStringList rejects;
+    std::vector<okj::KaraokeSong> droppedSongs;
+    for (int i = 0; i < files.size(); i++) {
+        const auto &file = files.at(i);
+        if (!rejectReasons.at(i).isEmpty()) {
+            rejects.append(file + " - " + rejectReasons.at(i));
+            continue;
         }
+        QFileInfo dFileInfo(file);
+        droppedSongs.emplace_back(okj::KaraokeSong{
+                -1,
+                "--Dropped Song--",
+                "--dropped song--",
+                dFileInfo.completeBaseName(),
+                dFileInfo.completeBaseName().toLower(),
+                "!!DROPPED!!",
+                "!!dropped!!",
+                0,
+                dFileInfo.fileName(),
+                file,
+                "",
+                0,
+                QDateTime()
+        });
+    }
+    auto songIds = m_karaokeSongsModel.addSongs(droppedSongs);
+    songIds.erase(std::remove(songIds.begin(), songIds.end(), -1), songIds.end());
+    m_logger->info("{} Adding {} dropped songs to singer {} at pos {}, {} rejected", m_loggingPrefix, songIds.size(),
+                   singerId, position, rejects.size());
+    if (m_qModel.getSingerId() == singerId) {
+        m_qModel.insertSongs(songIds, position);
+    } else {
+        // The operator moved on to another singer while the files were being checked
+        for (auto songId : songIds)
+            m_qModel.songAddSlot(songId, singerId);
+    }
+    if (rejects.isEmpty())
+        return;
+    QMessageBox msgBox;
+    msgBox.setWindowTitle("Invalid karaoke file!");
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.setText(QString("%1 of the %2 files dropped on the queue could not be added.").arg(rejects.size()).arg(files.size()));
+    msgBox.setInformativeText("Supported file types: mp3+g zip, cdg, mp4, mkv, avi");
+    msgBox.setDetailedText(rejects.join('\n'));
+    msgBox.exec();
 }
 
 void MainWindow::appFontChanged(const QFont &font) {
@@ -3350,54 +3594,64 @@ void MainWindow::autosizeViews() {
 }
 
 void MainWindow::autosizeKaraokeDbCols() const {
-    // Toggling the mode on these to get the initial size then allowing manual resize
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_LASTPLAY, QHeaderView::ResizeToContents);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_PLAYS, QHeaderView::ResizeToContents);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_DURATION, QHeaderView::ResizeToContents);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_ARTIST, QHeaderView::Stretch);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_TITLE, QHeaderView::Stretch);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_SONGID, QHeaderView::ResizeToContents);
-    QApplication::processEvents();
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_ARTIST, QHeaderView::Interactive);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_TITLE, QHeaderView::Interactive);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_SONGID, QHeaderView::Interactive);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_LASTPLAY, QHeaderView::Interactive);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_PLAYS, QHeaderView::Interactive);
-    ui->tableViewDB->horizontalHeader()->setSectionResizeMode(TableModelKaraokeSongs::COL_DURATION, QHeaderView::Interactive);
+    // Widths come from the model's cached content metrics so we don't have to make the header walk the model
+    auto header = ui->tableViewDB->horizontalHeader();
+    int textMargin = (ui->tableViewDB->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, ui->tableViewDB) + 1) * 2;
+    int usedWidth{0};
+    for (auto col : {TableModelKaraokeSongs::COL_SONGID, TableModelKaraokeSongs::COL_DURATION,
+                     TableModelKaraokeSongs::COL_PLAYS, TableModelKaraokeSongs::COL_LASTPLAY}) {
+        int width = std::max(header->sectionSizeHint(col), m_karaokeSongsModel.columnContentWidth(col) + textMargin);
+        header->setSectionResizeMode(col, QHeaderView::Interactive);
+        header->resizeSection(col, width);
+        if (!header->isSectionHidden(col))
+            usedWidth += width;
+    }
+    int stretchWidth = std::max(header->minimumSectionSize(), (ui->tableViewDB->viewport()->width() - usedWidth) / 2);
+    header->setSectionResizeMode(TableModelKaraokeSongs::COL_ARTIST, QHeaderView::Interactive);
+    header->setSectionResizeMode(TableModelKaraokeSongs::COL_TITLE, QHeaderView::Interactive);
+    header->resizeSection(TableModelKaraokeSongs::COL_ARTIST, stretchWidth);
+    header->resizeSection(TableModelKaraokeSongs::COL_TITLE, stretchWidth);
 }
 
 void MainWindow::autosizeQueueCols() {
+    auto header = ui->tableViewQueue->horizontalHeader();
     int fH = QFontMetrics(m_settings.applicationFont()).height();
     int iconWidth = fH + fH;
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_PATH, QHeaderView::Fixed);
-    ui->tableViewQueue->horizontalHeader()->resizeSection(TableModelQueueSongs::COL_PATH, iconWidth);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_ARTIST, QHeaderView::Stretch);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_TITLE, QHeaderView::Stretch);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_SONGID, QHeaderView::ResizeToContents);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_DURATION, QHeaderView::ResizeToContents);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_KEY, QHeaderView::ResizeToContents);
-    QApplication::processEvents();
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_ARTIST, QHeaderView::Interactive);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_TITLE, QHeaderView::Interactive);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_SONGID, QHeaderView::Interactive);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_DURATION, QHeaderView::Interactive);
-    ui->tableViewQueue->horizontalHeader()->setSectionResizeMode(TableModelQueueSongs::COL_KEY, QHeaderView::Interactive);
+    int textMargin = (ui->tableViewQueue->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, ui->tableViewQueue) + 1) * 2;
+    header->setSectionResizeMode(TableModelQueueSongs::COL_PATH, QHeaderView::Fixed);
+    header->resizeSection(TableModelQueueSongs::COL_PATH, iconWidth);
+    int usedWidth{iconWidth};
+    for (auto col : {TableModelQueueSongs::COL_SONGID, TableModelQueueSongs::COL_DURATION, TableModelQueueSongs::COL_KEY}) {
+        int width = std::max(header->sectionSizeHint(col), m_qModel.columnContentWidth(col) + textMargin);
+        header->setSectionResizeMode(col, QHeaderView::Interactive);
+        header->resizeSection(col, width);
+        if (!header->isSectionHidden(col))
+            usedWidth += width;
+    }
+    int stretchWidth = std::max(header->minimumSectionSize(), (ui->tableViewQueue->viewport()->width() - usedWidth) / 2);
+    header->setSectionResizeMode(TableModelQueueSongs::COL_ARTIST, QHeaderView::Interactive);
+    header->setSectionResizeMode(TableModelQueueSongs::COL_TITLE, QHeaderView::Interactive);
+    header->resizeSection(TableModelQueueSongs::COL_ARTIST, stretchWidth);
+    header->resizeSection(TableModelQueueSongs::COL_TITLE, stretchWidth);
 }
 
 void MainWindow::autosizeHistoryCols() {
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::LAST_SUNG, QHeaderView::ResizeToContents);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::SUNG_COUNT, QHeaderView::ResizeToContents);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::KEY_CHANGE, QHeaderView::ResizeToContents);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::ARTIST, QHeaderView::Stretch);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::TITLE, QHeaderView::Stretch);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::SONGID, QHeaderView::ResizeToContents);
-    QApplication::processEvents();
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::LAST_SUNG, QHeaderView::Interactive);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::SUNG_COUNT, QHeaderView::Interactive);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::KEY_CHANGE, QHeaderView::Interactive);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::ARTIST, QHeaderView::Interactive);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::TITLE, QHeaderView::Interactive);
-    ui->tableViewHistory->horizontalHeader()->setSectionResizeMode(TableModelHistorySongs::SONGID, QHeaderView::Interactive);
+    auto header = ui->tableViewHistory->horizontalHeader();
+    int textMargin = (ui->tableViewHistory->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, ui->tableViewHistory) + 1) * 2;
+    int usedWidth{0};
+    for (auto col : {TableModelHistorySongs::SONGID, TableModelHistorySongs::KEY_CHANGE,
+                     TableModelHistorySongs::SUNG_COUNT, TableModelHistorySongs::LAST_SUNG}) {
+        int width = std::max(header->sectionSizeHint(col), m_historySongsModel.columnContentWidth(col) + textMargin);
+        header->setSectionResizeMode(col, QHeaderView::Interactive);
+        header->resizeSection(col, width);
+        if (!header->isSectionHidden(col))
+            usedWidth += width;
+    }
+    int stretchWidth = std::max(header->minimumSectionSize(), (ui->tableViewHistory->viewport()->width() - usedWidth) / 2);
+    header->setSectionResizeMode(TableModelHistorySongs::ARTIST, QHeaderView::Interactive);
+    header->setSectionResizeMode(TableModelHistorySongs::TITLE, QHeaderView::Interactive);
+    header->resizeSection(TableModelHistorySongs::ARTIST, stretchWidth);
+    header->resizeSection(TableModelHistorySongs::TITLE, stretchWidth);
 }
 
 void MainWindow::autosizeBmViews() {
@@ -3582,6 +3836,7 @@ void MainWindow::showAlert(const QString &title, const QString &message) {
 }
 
 void MainWindow::tableViewRotationCurrentChanged(const QModelIndex &cur, const QModelIndex &prev) {
+    SqlQueryStatsAction sqlStatsAction("Select rotation singer");
     Q_UNUSED(prev)
     m_qModel.loadSinger(cur.data(Qt::UserRole).toInt());
     m_historySongsModel.loadSinger(m_rotModel.getSinger(cur.data(Qt::UserRole).toInt()).name);
@@ -3602,6 +3857,7 @@ void MainWindow::tableViewRotationCurrentChanged(const QModelIndex &cur, const Q
 }
 
 void MainWindow::updateRotationDuration() {
+    SqlQueryStatsAction sqlStatsAction("Update rotation duration");
     QString text;
     int secs = m_rotModel.rotationDuration();
     if (secs > 0) {
@@ -4093,7 +4349,7 @@ void MainWindow::actionCdgDecodeTorture() {
             if (!cdgFile.exists() || cdgFile.size() == 0) {
                 return;
             }
-            QString audioFilename = findMatchingAudioFile(karaokeFilePath);
+            QString audioFilename = m_karaokeSongsModel.findCdgAudioFile(karaokeFilePath);
             if (audioFilename == "") {
                 return;
             }
@@ -4187,6 +4443,7 @@ void MainWindow::buttonHistoryPlayClicked() {
     if (m_settings.treatAllSingersAsRegs() || m_rotModel.getSinger(curSingerId).regular)
         m_historySongsModel.saveSong(m_curSinger, filePath, m_curArtist, m_curTitle, curSongId, curKeyChange);
     m_mediaBackendKar.setPitchShift(curKeyChange);
+    recordSongStarted(curSingerId, -1, filePath, curKeyChange);
     m_rotModel.setCurrentSinger(curSingerId);
     m_rotDelegate.setCurrentSinger(curSingerId);
     if (m_settings.rotationAltSortOrder()) {
@@ -47,6 +47,7 @@
 #include "bmdbdialog.h"
 #include <QShortcut>
 #include <QThread>
+#include <QElapsedTimer>
 #include "audiorecorder.h"
 #include "dlgbookcreator.h"
 #include "dlgeq.h"
@@ -55,6 +56,10 @@
 #include "dlgsongshop.h"
 #include "songshop.h"
 #include "durationlazyupdater.h"
+#include "integritychecker.h"
+#include "loudnessanalyzer.h"
+#include "playbackjournal.h"
+#include "runstaterecorder.h"
 #include "dlgvideopreview.h"
 #include "src/models/tablemodelhistorysongs.h"
 #include "src/models/tablemodelplaylistsongs.h"
@@ -82,6 +87,8 @@ private:
     bool m_shuttingDown{false};
     bool m_kAASkip{false};
     bool m_k2kTransition{false};
+    const qint64 m_resumeLeadInMs{3000};
+    const int m_resumeSeekTimeoutMs{5000};
     bool m_kHasActiveVideo{false};
     bool m_bmHasActiveVideo{false};
     bool m_kNeedAutoSize{false};
@@ -120,6 +127,8 @@ private:
     MediaBackend m_mediaBackendKar{this, "KAR", MediaBackend::Karaoke};
     MediaBackend m_mediaBackendSfx{this, "SFX", MediaBackend::SFX};
     MediaBackend m_mediaBackendBm{this, "BM", MediaBackend::BackgroundMusic};
+    PlaybackJournal m_playbackJournal{this};
+    RunStateRecorder m_runState{this};
     AudioRecorder audioRecorder;
     QLabel m_labelSingerCount;
     QLabel m_labelRotationDuration;
@@ -127,6 +136,13 @@ private:
     QTimer m_timerSlowUiUpdate;
     QTimer m_timerTest;
     QTimer m_timerButtonFlash;
+    // Rotation changes are coalesced, see rotationDataChanged()
+    QTimer m_timerRotationChanges;
+    QElapsedTimer m_lastRotationFlush;
+    QElapsedTimer m_startupTimer;
+    qint64 m_startupPhaseStartMs{0};
+    const int m_rotationFlushMinIntervalMs{100};
+    QStringList m_lastRequestsDialogSingers;
     QShortcut m_scutAddSinger{this};
     QShortcut m_scutKSelectNextSinger{this};
     QShortcut m_scutKPlayNextUnsung{this};
@@ -154,6 +170,8 @@ private:
     QShortcut m_scutDeleteSong{nullptr};
     QShortcut m_scutDeletePlSong{nullptr};
     std::unique_ptr<LazyDurationUpdateController> m_lazyDurationUpdater;
+    std::unique_ptr<IntegrityCheckController> m_integrityChecker;
+    std::unique_ptr<LoudnessAnalysisController> m_loudnessAnalyzer;
     std::unique_ptr<QTemporaryDir> m_mediaTempDir;
     std::shared_ptr<SongShop> m_songShop;
     std::unique_ptr<UpdateChecker> m_updateChecker;
@@ -164,9 +182,18 @@ private:
     void updateIcons();
     void setupShortcuts();
     void setupConnections();
+    void logStartupPhase(const std::string &phase);
+    DlgSongShop *songShopDialog();
+    BmDbDialog *breakMusicDbDialog();
+    void restartLazyDurationUpdater();
+    static QString droppedFileRejectReason(const QString &file);
+    void addDroppedFiles(const QStringList &files, const QList<QString> &rejectReasons, int singerId, int position);
+    void flushRotationChanges();
     void loadSettings();
     void resetBmLabels();
     void play(const QString &karaokeFilePath, const bool &k2k = false);
+    void recordSongStarted(int singerId, int queueSongId, const QString &path, int keyChange);
+    void resumeInterruptedSong(const RunStateRecorder::RunState &state);
     void bmAddPlaylist(const QString& title);
     bool bmPlaylistExists(const QString& name);
     void addSfxButton(const QString &filename, const QString &label, bool reset = false);
@@ -178,7 +205,7 @@ public:
 
 private slots:
     void search();
-    void databaseUpdated();
+    void databaseSongsChanged(const QVector<int> &addedIds, const QVector<int> &updatedIds, const QVector<int> &removedIds);
     void databaseCleared();
     void buttonStopClicked();
     void buttonPauseClicked();
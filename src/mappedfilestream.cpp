@@ -0,0 +1,122 @@
+#include "mappedfilestream.h"
+#include <QFileInfo>
+#include <QMutex>
+#include <QHash>
+#include <QStorageInfo>
+#include <algorithm>
+
+MappedFileStream::MappedFileStream(const QString &path) : m_file(path)
+{
+#ifdef Q_OS_WIN
+    m_name = path.toStdWString();
+#else
+    m_name = path.toLocal8Bit();
+#endif
+    if (!m_file.open(QIODevice::ReadOnly))
+        return;
+    m_size = static_cast<Offset>(m_file.size());
+    if (m_size > 0)
+        m_data = m_file.map(0, m_size);
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+}
+
+TagLib::FileName MappedFileStream::name() const
+{
+#ifdef Q_OS_WIN
+    return m_name.c_str();
+#else
+    return m_name.constData();
+#endif
+}
+
+TagLib::ByteVector MappedFileStream::readBlock(BlockSize length)
+{
+    if (!m_data || m_pos >= m_size)
+        return {};
+    auto count = std::min(static_cast<Offset>(length), m_size - m_pos);
+    TagLib::ByteVector block(reinterpret_cast<const char *>(m_data + m_pos), static_cast<unsigned int>(count));
+    m_pos += count;
+    return block;
+}
+
+void MappedFileStream::writeBlock(const TagLib::ByteVector &data)
+{
+    Q_UNUSED(data)
+}
+
+void MappedFileStream::insert(const TagLib::ByteVector &data, BlockOffset start, BlockSize replace)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(start)
+    Q_UNUSED(replace)
+}
+
+void MappedFileStream::removeBlock(BlockOffset start, BlockSize length)
+{
+    Q_UNUSED(start)
+    Q_UNUSED(length)
+}
+
+bool MappedFileStream::readOnly() const
+{
+    return true;
+}
+
+bool MappedFileStream::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+void MappedFileStream::seek(Offset offset, Position p)
+{
+    switch (p)
+    {
+    case Beginning:
+        m_pos = offset;
+        break;
+    case Current:
+        m_pos += offset;
+        break;
+    case End:
+        m_pos = m_size + offset;
+        break;
+    }
+    m_pos = std::clamp(m_pos, Offset{0}, m_size);
+}
+
+MappedFileStream::Offset MappedFileStream::tell() const
+{
+    return m_pos;
+}
+
+MappedFileStream::Offset MappedFileStream::length()
+{
+    return m_size;
+}
+
+void MappedFileStream::truncate(Offset length)
+{
+    Q_UNUSED(length)
+}
+
+bool MappedFileStream::isLocalFile(const QString &path)
+{
+    static const QStringList networkFsTypes{"nfs", "nfs4", "cifs", "smb3", "smbfs", "fuse.sshfs", "afpfs", "9p", "davfs"};
+    // Scans walk one directory at a time, so the lookup is cached per directory rather than doing a statfs per file
+    static QMutex cacheMutex;
+    static QHash<QString, bool> localDirs;
+    auto dir = QFileInfo(path).absolutePath();
+    QMutexLocker locker(&cacheMutex);
+    auto it = localDirs.constFind(dir);
+    if (it != localDirs.constEnd())
+        return it.value();
+    QStorageInfo storage(dir);
+    bool local = storage.isValid() && !networkFsTypes.contains(QString::fromLatin1(storage.fileSystemType()), Qt::CaseInsensitive);
+    localDirs.insert(dir, local);
+    return local;
+}
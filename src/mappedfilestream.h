@@ -0,0 +1,60 @@
+#ifndef MAPPEDFILESTREAM_H
+#define MAPPEDFILESTREAM_H
+
+#include <QFile>
+#include <QString>
+#include <taglib.h>
+#include <tiostream.h>
+
+// Read-only TagLib stream over a memory mapped file.
+// TagLib's FileStream issues lots of small buffered reads while hunting for tags and frame headers, each one a
+// syscall. Mapping the file turns those into memcpy's and only the pages TagLib actually touches get read.
+// If the file can't be mapped isOpen() returns false and the caller should fall back to a regular FileRef.
+class MappedFileStream : public TagLib::IOStream
+{
+public:
+    // TagLib 2 moved IOStream from long/unsigned long to offset_t/size_t
+#if TAGLIB_MAJOR_VERSION >= 2
+    using Offset = TagLib::offset_t;
+    using BlockOffset = TagLib::offset_t;
+    using BlockSize = size_t;
+#else
+    using Offset = long;
+    using BlockOffset = unsigned long;
+    using BlockSize = unsigned long;
+#endif
+
+    explicit MappedFileStream(const QString &path);
+    ~MappedFileStream() override;
+    MappedFileStream(const MappedFileStream &) = delete;
+    MappedFileStream &operator=(const MappedFileStream &) = delete;
+
+    [[nodiscard]] TagLib::FileName name() const override;
+    TagLib::ByteVector readBlock(BlockSize length) override;
+    void writeBlock(const TagLib::ByteVector &data) override;
+    void insert(const TagLib::ByteVector &data, BlockOffset start = 0, BlockSize replace = 0) override;
+    void removeBlock(BlockOffset start = 0, BlockSize length = 0) override;
+    [[nodiscard]] bool readOnly() const override;
+    [[nodiscard]] bool isOpen() const override;
+    void seek(Offset offset, Position p = Beginning) override;
+    [[nodiscard]] Offset tell() const override;
+    Offset length() override;
+    void truncate(Offset length) override;
+
+    // Network filesystems are left to TagLib's own FileStream, a share dropping out from under a mapping
+    // would take the whole process down with SIGBUS
+    static bool isLocalFile(const QString &path);
+
+private:
+    QFile m_file;
+#ifdef Q_OS_WIN
+    std::wstring m_name;
+#else
+    QByteArray m_name;
+#endif
+    uchar *m_data{nullptr};
+    Offset m_size{0};
+    Offset m_pos{0};
+};
+
+#endif // MAPPEDFILESTREAM_H
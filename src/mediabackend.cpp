@@ -23,17 +23,23 @@
 #include <cmath>
 #include <QFile>
 #include <gst/audio/streamvolume.h>
+#include <gst/audio/gstaudiobasesink.h>
 #include <gst/gstdebugutils.h>
 #include "softwarerendervideosink.h"
 #include <QDir>
 #include <QProcess>
 #include <functional>
+#include <algorithm>
 #include <utility>
 #include <gst/video/videooverlay.h>
 #include <gst/gstsegment.h>
 #include "gstreamer/gstreamerhelper.h"
+#include "activitypolicy.h"
 #include <spdlog/async_logger.h>
 #include <QTextStream>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QEvent>
 
 
 Q_DECLARE_SMART_POINTER_METATYPE(std::shared_ptr);
@@ -48,21 +54,32 @@ MediaBackend::MediaBackend(QObject *parent, QString objectName, const MediaType
     m_videoAccelEnabled = m_settings.hardwareAccelEnabled();
     m_logger->info("{} Hardware accelerated video rendering mode: {}",m_loggingPrefix, m_videoAccelEnabled);
     QMetaTypeId<std::shared_ptr<GstMessage>>::qt_metatype_id();
+    QElapsedTimer constructionTimer;
+    constructionTimer.start();
+    m_dspQualityFloor = static_cast<DspQualityTier>(std::clamp(m_settings.dspQualityFloor(), static_cast<int>(DspQualityHigh), static_cast<int>(DspQualityMinimal)));
 
     buildPipeline();
-    getAudioOutputDevices();
-
-    switch (type) {
-        case Karaoke:
-            setAudioOutputDevice(m_settings.audioOutputDevice());
-            break;
-        default:
-            setAudioOutputDevice(m_settings.audioOutputDeviceBm());
+    if (m_type == Karaoke && m_settings.cdgMirrorEnabled())
+    {
+        m_cdgMirror = new CdgPacketPublisher(this);
+        m_cdgMirror->setDestination(QHostAddress(m_settings.cdgMirrorAddress()), m_settings.cdgMirrorPort());
     }
-    m_logger->debug("{} GStreamer backend construction complete", m_loggingPrefix);
+    connect(&m_audioDeviceProbeWatcher, &QFutureWatcher<std::vector<AudioOutputDevice>>::finished, this, &MediaBackend::audioOutputDevicesProbed);
+    getAudioOutputDevices();
+    m_logger->debug("{} GStreamer backend construction complete in {} ms", m_loggingPrefix, constructionTimer.elapsed());
 
     connect(&m_timerSlow, &QTimer::timeout, this, &MediaBackend::timerSlow_timeout);
     connect(&m_timerFast, &QTimer::timeout, this, &MediaBackend::timerFast_timeout);
+    m_scrubSettleTimer.setSingleShot(true);
+    m_scrubSettleTimer.setInterval(250);
+    connect(&m_scrubSettleTimer, &QTimer::timeout, this, &MediaBackend::scrubSettled);
+    connect(this, &MediaBackend::stateChanged, this, [this] (const State state) {
+        ActivityPolicy::instance().setPlaybackActive(this, state == PlayingState || state == PausedState);
+    });
+    connect(&ActivityPolicy::instance(), &ActivityPolicy::idleChanged, this, [this] (bool idle) {
+        setTimersThrottled(idle && m_currentState == GST_STATE_NULL);
+    });
+    setTimersThrottled(ActivityPolicy::instance().isIdle());
 }
 
 void MediaBackend::setVideoEnabled(const bool &enabled)
@@ -151,6 +168,11 @@ MediaBackend::~MediaBackend()
 {
     m_logger->debug("{} MediaBackend destructor called", m_loggingPrefix);
     resetPipeline();
+    if (auto pendingSink = m_pendingAudioSink.exchange(nullptr))
+        gst_object_unref(pendingSink);
+    if (m_queuedAudioSink)
+        gst_object_unref(m_queuedAudioSink);
+    ActivityPolicy::instance().setPlaybackActive(this, false);
     m_timerSlow.stop();
     m_timerFast.stop();
     m_gstBusMsgHandlerTimer.stop();
@@ -164,6 +186,11 @@ MediaBackend::~MediaBackend()
     gst_object_unref(m_audioBin);
     gst_object_unref(m_videoBin);
     gst_object_unref(m_videoBin);
+    if (m_pitchEngineSwappable)
+    {
+        gst_object_unref(m_pitchShifterRubberBand);
+        gst_object_unref(m_pitchShifterSoundtouch);
+    }
     delete m_cdgSrc;
     for (auto &device : m_audioOutputDevices)
     {
@@ -220,6 +247,7 @@ QStringList MediaBackend::getOutputDevices()
 void MediaBackend::play()
 {
     m_logger->debug("{} Play called", m_loggingPrefix);
+    setTimersThrottled(false);
     m_videoOffsetMs = m_settings.videoOffsetMs();
 
     if (m_currentlyFadedOut)
@@ -236,6 +264,8 @@ void MediaBackend::play()
     }
 
     resetPipeline();
+    applyPitchShiftEngine();
+    configureAudioSinkBuffering(m_audioSink);
 
     bool allowMissingAudio = false;
 
@@ -266,6 +296,8 @@ void MediaBackend::play()
         patchPipelineSinks();
         allowMissingAudio = m_type == VideoPreview;
         m_cdgSrc->load(m_cdgFilename);
+        if (m_cdgMirror)
+            m_cdgMirror->startStream(m_cdgSrc->packetData());
         m_logger->info("{} Playing CDG graphics from file: {}", m_loggingPrefix, m_cdgFilename.toStdString());
     } else {
         gst_element_unlink_many(m_queueMainVideo, m_prescalerVideoConvert, m_prescaler, m_prescalerCapsFilter, m_videoTee, nullptr);
@@ -294,6 +326,9 @@ void MediaBackend::play()
 
     resetVideoSinks();
 
+    beginHealthSession();
+    m_dspSettleTicks = 0;
+    m_audioEos = false;
     gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
     setEnforceAspectRatio(m_settings.enforceAspectRatio());
     forceVideoExpose();
@@ -402,16 +437,92 @@ bool MediaBackend::isMuted()
     return gst_stream_volume_get_mute(GST_STREAM_VOLUME(m_volumeElement));
 }
 
-void MediaBackend::setPosition(const qint64 &position)
+bool MediaBackend::setPosition(const qint64 &position)
+{
+    m_scrubSettleTimer.stop();
+    return seekTo(position, GST_SEEK_FLAG_FLUSH);
+}
+
+void MediaBackend::seekRelative(const qint64 &offsetMs)
+{
+    // Stack onto the newest requested target rather than the reported position, which lags while a seek is in flight
+    qint64 base;
+    if (m_pendingSeekPosition >= 0)
+        base = m_pendingSeekPosition;
+    else if (seekInFlight())
+        base = m_seekPosition;
+    else
+        base = position();
+    auto target = std::max(base + offsetMs, static_cast<qint64>(0));
+    if (offsetMs > 0 && target >= duration())
+        return;
+    m_scrubSettleTimer.stop();
+    seekTo(target, GST_SEEK_FLAG_FLUSH);
+}
+
+void MediaBackend::scrubTo(const qint64 &position)
+{
+    m_scrubPosition = position;
+    m_scrubSettleTimer.start();
+    // Leave the end of media handling to the settled seek so dragging past the end doesn't stop the song
+    if (position > 1000 && position > duration() - 1000)
+        return;
+    seekTo(position, static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST));
+}
+
+void MediaBackend::scrubSettled()
+{
+    if (m_scrubPosition < 0)
+        return;
+    auto position = m_scrubPosition;
+    m_scrubPosition = -1;
+    seekTo(position, static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE));
+}
+
+bool MediaBackend::seekInFlight() const
+{
+    // A seek that never reports ASYNC_DONE (pipeline torn down, seek refused) mustn't swallow later requests
+    return m_seekPending && m_seekTimer.elapsed() < m_seekTimeoutMs;
+}
+
+bool MediaBackend::seekTo(const qint64 &position, const GstSeekFlags flags)
 {
     if (position > 1000 && position > duration() - 1000)
     {
+        m_pendingSeekPosition = -1;
         emit stateChanged(EndOfMediaState);
-        return;
+        return true;
+    }
+    if (seekInFlight())
+    {
+        // Only the latest target matters, it goes out as one seek when the current one completes
+        m_pendingSeekPosition = position;
+        m_pendingSeekFlags = flags;
+        emit positionChanged(position);
+        return true;
+    }
+    return sendSeek(position, flags);
+}
+
+bool MediaBackend::sendSeek(const qint64 &position, const GstSeekFlags flags)
+{
+    if (m_healthSessionActive)
+        m_health.seeks++;
+    m_seekTimer.start();
+    m_seekPending = true;
+    m_dspSettleTicks = 0;
+    m_audioEos = false;
+    m_seekPosition = position;
+    if (!gst_element_send_event(m_pipeline, gst_event_new_seek(m_playbackRate, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, position * GST_MSECOND, GST_SEEK_TYPE_NONE, 0)))
+    {
+        // No ASYNC_DONE follows a refused seek, don't leave later seeks queued behind it
+        m_logger->warn("{} Seek to {} ms was not handled by the pipeline", m_loggingPrefix, position);
+        m_seekPending = false;
+        return false;
     }
-    gst_element_send_event(m_pipeline, gst_event_new_seek(m_playbackRate, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, position * GST_MSECOND, GST_SEEK_TYPE_NONE, 0));
     emit positionChanged(position);
     forceVideoExpose();
+    return true;
 }
 
 void MediaBackend::setVolume(const int &volume)
@@ -461,6 +572,38 @@ void MediaBackend::rawStop()
     stopPipeline();
 }
 
+void MediaBackend::setLoudnessGain(double gainDb)
+{
+    // rgvolume prefers ReplayGain tags when a file has them, the fallback gain covers everything else
+    m_logger->debug("{} Setting loudness gain to {:.1f} dB", m_loggingPrefix, gainDb);
+    g_object_set(m_rgVolume, "fallback-gain", gainDb, nullptr);
+}
+
+void MediaBackend::setTimersThrottled(bool throttled)
+{
+    if (m_timersThrottled == throttled)
+        return;
+    m_timersThrottled = throttled;
+    m_logger->debug("{} {} timers", m_loggingPrefix, throttled ? "Idle and stopped, backing off" : "Restoring");
+    if (throttled)
+    {
+        // Nothing is playing, so there's no position to report or playback to watch.  The bus still gets drained
+        // for device and error messages, just not 25 times a second.
+        if (m_lastPosition != 0)
+        {
+            m_lastPosition = 0;
+            emit positionChanged(0);
+        }
+        m_timerFast.stop();
+        m_timerSlow.stop();
+        m_gstBusMsgHandlerTimer.setInterval(1000);
+        return;
+    }
+    m_gstBusMsgHandlerTimer.setInterval(40);
+    m_timerFast.start(250);
+    m_timerSlow.start(1000);
+}
+
 void MediaBackend::timerFast_timeout()
 {
     if (m_currentState == GST_STATE_NULL)
@@ -484,6 +627,9 @@ void MediaBackend::timerFast_timeout()
         m_lastPosition = mspos;
         emit positionChanged(mspos);
     }
+    // Driven by the playback position rather than the appsrc, which reads well ahead of what's on screen
+    if (m_cdgMirror && m_cdgMode)
+        m_cdgMirror->publish(mspos, m_currentState == GST_STATE_PLAYING);
 }
 
 void MediaBackend::timerSlow_timeout()
@@ -518,22 +664,176 @@ void MediaBackend::timerSlow_timeout()
     }
 
     // Check if playback is hung (playing but no movement since 1 second ago) for some reason
-    static int hungCycles{0};
     if (state() == PlayingState)
     {
         if (m_positionWatchdogLastPos == currPos && m_positionWatchdogLastPos > 10)
         {
-            hungCycles++;
-            m_logger->warn("{} Playback appears to be hung!  No position change for {} seconds!", m_loggingPrefix, hungCycles);
-            if (hungCycles >= 5)
+            if (!m_watchdogStalled)
             {
-                m_logger->warn("{} Playback has been hung for {} seconds, giving up!", m_loggingPrefix, hungCycles);
+                m_watchdogStalled = true;
+                m_health.watchdogTrips++;
+            }
+            m_hungCycles++;
+            m_logger->warn("{} Playback appears to be hung!  No position change for {} seconds!", m_loggingPrefix, m_hungCycles);
+            if (m_hungCycles >= 5)
+            {
+                m_logger->warn("{} Playback has been hung for {} seconds, giving up!", m_loggingPrefix, m_hungCycles);
                 emit stateChanged(EndOfMediaState);
-                hungCycles = 0;
+                m_hungCycles = 0;
             }
         }
+        else
+            m_watchdogStalled = false;
         m_positionWatchdogLastPos = currPos;
     }
+    updateDspQualityTier();
+    updateAudioSinkBuffering();
+}
+
+void MediaBackend::updateDspQualityTier()
+{
+    int underruns = m_dspUnderruns.exchange(0);
+    int qosEvents = std::exchange(m_dspQosEvents, 0);
+    // The output queue drains on start, seek and end of stream without anything being wrong
+    if (m_audioEos || state() != PlayingState || seekInFlight() || m_dspSettleTicks++ < m_dspSettleSecs)
+        return;
+    m_dspTicksSinceChange++;
+    guint64 queuedNs{0};
+    g_object_get(m_queueEndAudio, "current-level-time", &queuedNs, nullptr);
+    auto queuedMs = static_cast<qint64>(queuedNs / GST_MSECOND);
+    if (underruns > 0 || qosEvents > 0 || queuedMs < m_dspLowWaterMs)
+    {
+        m_dspCleanTicks = 0;
+        if (m_dspQualityTier >= m_dspQualityFloor || m_dspTicksSinceChange < m_dspStepDownHoldSecs)
+            return;
+        m_logger->warn("{} Audio processing is falling behind ({} underruns, {} QoS events, {} ms buffered), reducing DSP quality tier to {}",
+                       m_loggingPrefix, underruns, qosEvents, queuedMs, m_dspQualityTier + 1);
+        applyDspQualityTier(static_cast<DspQualityTier>(m_dspQualityTier + 1));
+        return;
+    }
+    if (m_dspQualityTier > DspQualityHigh && ++m_dspCleanTicks >= m_dspStepUpAfterSecs)
+    {
+        m_logger->info("{} Audio processing has kept up for {} seconds, raising DSP quality tier to {}",
+                       m_loggingPrefix, m_dspCleanTicks, m_dspQualityTier - 1);
+        applyDspQualityTier(static_cast<DspQualityTier>(m_dspQualityTier - 1));
+    }
+}
+
+void MediaBackend::applyDspQualityTier(const DspQualityTier tier)
+{
+    static constexpr std::array<int, 4> resamplerQuality{10, 6, 4, 2};
+    m_dspQualityTier = tier;
+    m_dspTicksSinceChange = 0;
+    m_dspCleanTicks = 0;
+    if (m_pitchShifterRubberBand)
+        g_object_set(m_pitchShifterRubberBand, "formant-preserving", tier == DspQualityHigh, "crispness", tier >= DspQualityLow ? 0 : 1, nullptr);
+    g_object_set(m_audioResample, "quality", resamplerQuality.at(tier), nullptr);
+    if (m_pitchEngineSwappable && (tier == DspQualityMinimal) != m_soundtouchStandIn)
+        m_logger->info("{} Switching pitch shifter to {} at the start of the next song", m_loggingPrefix,
+                       tier == DspQualityMinimal ? "SoundTouch" : "RubberBand");
+}
+
+void MediaBackend::applyPitchShiftEngine()
+{
+    // Only safe between songs, resetPipeline() has stopped the audio bin and unlinked it from the decoder
+    bool useSoundtouch = m_dspQualityTier == DspQualityMinimal;
+    if (!m_pitchEngineSwappable || useSoundtouch == m_soundtouchStandIn)
+        return;
+    auto current = useSoundtouch ? m_pitchShifterRubberBand : m_pitchShifterSoundtouch;
+    auto replacement = useSoundtouch ? m_pitchShifterSoundtouch : m_pitchShifterRubberBand;
+    gst_element_unlink_many(m_aConvPrePitchShift, current, m_aConvPostPitchShift, nullptr);
+    gst_element_set_state(current, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(m_audioBin), current);
+    gst_bin_add(GST_BIN(m_audioBin), replacement);
+    gst_element_link_many(m_aConvPrePitchShift, replacement, m_aConvPostPitchShift, nullptr);
+    m_soundtouchStandIn = useSoundtouch;
+    m_logger->info("{} Using {} pitch shifter", m_loggingPrefix, useSoundtouch ? "SoundTouch" : "RubberBand");
+}
+
+void MediaBackend::setDspQualityFloor(const int floor)
+{
+    m_dspQualityFloor = static_cast<DspQualityTier>(std::clamp(floor, static_cast<int>(DspQualityHigh), static_cast<int>(DspQualityMinimal)));
+    if (m_dspQualityTier <= m_dspQualityFloor)
+        return;
+    m_logger->info("{} DSP quality floor raised, moving to tier {}", m_loggingPrefix, m_dspQualityFloor);
+    applyDspQualityTier(m_dspQualityFloor);
+}
+
+void MediaBackend::updateAudioSinkBuffering()
+{
+    int underruns = m_sinkUnderruns.exchange(0);
+    int resyncs = std::exchange(m_sinkResyncs, 0);
+    // Same settle period as the DSP quality tier, the output drains on start, seek and end of stream
+    if (m_type == VideoPreview || m_audioEos || state() != PlayingState || seekInFlight() || m_dspSettleTicks <= m_dspSettleSecs)
+        return;
+    if (auto sink = gsthlp_find_audio_base_sink(m_audioSink))
+    {
+        // When another element provides the pipeline clock the sink has to slave its output to it, which shows up
+        // as resyncs when the clocks drift apart
+        auto pipelineClock = gst_pipeline_get_clock(GST_PIPELINE(m_pipeline));
+        bool slaved = pipelineClock && pipelineClock != GST_AUDIO_BASE_SINK(sink)->provided_clock;
+        if (slaved != m_sinkSlaved)
+        {
+            m_sinkSlaved = slaved;
+            m_logger->info("{} Audio sink is {} the pipeline clock", m_loggingPrefix, slaved ? "slaved to" : "providing");
+        }
+        if (pipelineClock)
+            gst_object_unref(pipelineClock);
+        gst_object_unref(sink);
+    }
+    if (underruns == 0 && resyncs == 0)
+    {
+        if (++m_sinkCleanTicks < m_sinkStepDownAfterSecs)
+            return;
+        m_sinkCleanTicks = 0;
+        int lower = std::max(m_settings.audioSinkBufferMinMs(), m_sinkBufferMs * 4 / 5 / 10 * 10);
+        if (lower >= m_sinkBufferMs)
+            return;
+        m_logger->info("{} Audio output has played cleanly for {} seconds, lowering the sink buffer from {} to {} ms starting with the next song",
+                       m_loggingPrefix, m_sinkStepDownAfterSecs, m_sinkBufferMs.load(), lower);
+        setAudioSinkBufferMs(lower);
+        return;
+    }
+    m_sinkCleanTicks = 0;
+    m_sinkSongUnderruns += underruns;
+    m_sinkSongResyncs += resyncs;
+    m_logger->warn("{} Audio sink starved {} times and resynced {} times in the last second with a {} ms buffer{}",
+                   m_loggingPrefix, underruns, resyncs, m_sinkAppliedBufferMs.load(), m_sinkSlaved ? " (slaved clock)" : "");
+    // One step per song, the new size can't be judged until it's in use
+    if (m_sinkBufferMs != m_sinkAppliedBufferMs)
+        return;
+    int maxMs = std::max(m_settings.audioSinkBufferMinMs(), m_settings.audioSinkBufferMaxMs());
+    int higher = std::min(maxMs, (m_sinkBufferMs * 3 / 2 + 9) / 10 * 10);
+    if (higher <= m_sinkBufferMs)
+        return;
+    m_logger->info("{} Raising the audio sink buffer from {} to {} ms starting with the next song", m_loggingPrefix, m_sinkBufferMs.load(), higher);
+    setAudioSinkBufferMs(higher);
+}
+
+void MediaBackend::setAudioSinkBufferMs(const int bufferMs)
+{
+    m_sinkBufferMs = bufferMs;
+    m_settings.setAudioSinkBufferMs(audioSinkDeviceKey(), bufferMs);
+}
+
+void MediaBackend::configureAudioSinkBuffering(GstElement *sink)
+{
+    // Takes effect the next time the sink acquires its ring buffer, so only when it's started from READY or below
+    auto baseSink = gsthlp_find_audio_base_sink(sink);
+    if (!baseSink)
+        return;
+    int bufferMs = m_sinkBufferMs;
+    // Ten segments per buffer like GStreamer's defaults (200/10 ms), within what sound servers handle well
+    int latencyMs = std::clamp(bufferMs / 10, 5, 20);
+    g_object_set(baseSink, "buffer-time", static_cast<gint64>(bufferMs) * 1000, "latency-time", static_cast<gint64>(latencyMs) * 1000, nullptr);
+    m_sinkAppliedBufferMs = bufferMs;
+    m_logger->debug("{} Audio sink buffer set to {} ms in {} ms segments", m_loggingPrefix, bufferMs, latencyMs);
+    gst_object_unref(baseSink);
+}
+
+QString MediaBackend::audioSinkDeviceKey() const
+{
+    return m_objName + " - " + (m_outputDevice.index <= 0 ? QString("Default") : m_outputDevice.name);
 }
 
 void MediaBackend::setVideoOffset(const int offsetMs) {
@@ -548,19 +848,16 @@ void MediaBackend::setVideoOffset(const int offsetMs) {
 
 void MediaBackend::setPitchShift(const int &pitchShift)
 {
-    if (m_pitchShifterRubberBand)
-    {
-        g_object_set(m_pitchShifterRubberBand, "semitones", pitchShift, nullptr);
-    }
-    else if (m_pitchShifterSoundtouch)
-    {
-        g_object_set(m_pitchShifterSoundtouch, "pitch", getPitchForSemitone(pitchShift), nullptr);
-    }
-    else
+    if (!m_pitchShifterRubberBand && !m_pitchShifterSoundtouch)
     {
         m_logger->error("{} Pitch shift requested but no plugin is loaded!", m_loggingPrefix);
         return;
     }
+    // Both are kept in step when SoundTouch is standing by to replace RubberBand
+    if (m_pitchShifterRubberBand)
+        g_object_set(m_pitchShifterRubberBand, "semitones", pitchShift, nullptr);
+    if (m_pitchShifterSoundtouch)
+        g_object_set(m_pitchShifterSoundtouch, "pitch", getPitchForSemitone(pitchShift), nullptr);
     emit pitchChanged(pitchShift); // NOLINT(readability-misleading-indentation)
 }
 
@@ -579,6 +876,7 @@ void MediaBackend::gstBusFunc(GstMessage *message)
             {
                 QString player = (m_objName == "KAR") ? "karaoke" : "break music";
                 m_logger->error("{} Unable to play file, missing media codec", m_loggingPrefix);
+                m_health.error = true;
                 emit audioError("Unable to play " + player + " file, missing gstreamer plugin");
                 stop(true);
             }
@@ -591,6 +889,7 @@ void MediaBackend::gstBusFunc(GstMessage *message)
             GError *err;
             gchar *debug;
             gst_message_parse_warning(message, &err, &debug);
+            m_health.warnings++;
             m_logger->warn("{} [GStreamer] {}", m_loggingPrefix, err->message);
             m_logger->debug("{} [GStreamer] {}", m_loggingPrefix, debug);
             g_error_free(err);
@@ -603,10 +902,6 @@ void MediaBackend::gstBusFunc(GstMessage *message)
             // We only want to react once: on the actual pipeline element.
             if (message->src != (GstObject *)m_pipeline) break;
 
-            // Avoid doing anything while audio outputs are changing
-            if (m_changingAudioOutputs)
-                break;
-
             GstState oldState, state, pending;
             gst_message_parse_state_changed(message, &oldState, &state, &pending);
 
@@ -614,6 +909,16 @@ void MediaBackend::gstBusFunc(GstMessage *message)
             if (pending != GST_STATE_VOID_PENDING || oldState == state)
                 break;
 
+            // Avoid doing anything while audio outputs are changing, the pause/play cycle isn't user visible
+            if (m_changingAudioOutputs)
+            {
+                if (state != GST_STATE_PLAYING)
+                    break;
+                m_changingAudioOutputs = false;
+                m_logger->info("{} Audio output device change completed in {} ms", m_loggingPrefix, m_audioSinkSwapTimer.elapsed());
+                break;
+            }
+
             m_currentState = state;
 
             if (m_currentlyFadedOut)
@@ -642,6 +947,7 @@ void MediaBackend::gstBusFunc(GstMessage *message)
         {
             if (message->src != (GstObject *)m_pipeline) break;
             m_logger->debug("{} GStreamer reported state change to EndOfMedia", m_loggingPrefix);
+            endHealthSession();
             emit stateChanged(EndOfMediaState);
             m_currentState = GST_STATE_NULL;
             break;
@@ -676,13 +982,63 @@ void MediaBackend::gstBusFunc(GstMessage *message)
             emit durationChanged(msdur);
             break;
         }
+        case GST_MESSAGE_QOS:
+        {
+            bool fromAudio = gst_object_has_as_ancestor(message->src, GST_OBJECT(m_audioBin));
+            if (fromAudio)
+                m_dspQosEvents++;
+            // The sink posts QoS when it drops or resyncs samples that arrived too late to play on time
+            if (GST_IS_AUDIO_BASE_SINK(message->src))
+                m_sinkResyncs++;
+            if (!m_healthSessionActive)
+                break;
+            GstFormat format;
+            guint64 processed, dropped;
+            gst_message_parse_qos_stats(message, &format, &processed, &dropped);
+            if (fromAudio)
+                m_health.audioQosEvents++;
+            else if (format == GST_FORMAT_BUFFERS && dropped != static_cast<guint64>(-1))
+                m_health.videoFramesDropped = std::max(m_health.videoFramesDropped, static_cast<quint64>(dropped));
+            break;
+        }
+        case GST_MESSAGE_ASYNC_DONE:
+        {
+            if (message->src != (GstObject *)m_pipeline || !m_seekPending)
+                break;
+            m_seekPending = false;
+            auto seekMs = m_seekTimer.elapsed();
+            if (m_healthSessionActive)
+            {
+                m_health.seekTotalMs += seekMs;
+                m_health.seekMaxMs = std::max(m_health.seekMaxMs, seekMs);
+            }
+            m_logger->debug("{} Seek to {} ms completed in {} ms", m_loggingPrefix, m_seekPosition, seekMs);
+            emit seekCompleted(m_seekPosition, seekMs);
+            if (m_pendingSeekPosition >= 0)
+            {
+                auto position = m_pendingSeekPosition;
+                m_pendingSeekPosition = -1;
+                sendSeek(position, m_pendingSeekFlags);
+            }
+            break;
+        }
+        case GST_MESSAGE_CLOCK_LOST:
+        {
+            // The audio sink provides the pipeline clock, a PAUSED->PLAYING cycle makes the pipeline select a new one
+            if (m_currentState != GST_STATE_PLAYING)
+                break;
+            m_logger->debug("{} Pipeline clock lost, cycling state to select a new clock", m_loggingPrefix);
+            m_changingAudioOutputs = true;
+            gst_element_set_state(m_pipeline, GST_STATE_PAUSED);
+            gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
+            break;
+        }
         case GST_MESSAGE_STREAM_START:
             m_logger->debug("{} GStreamer reported stream started", m_loggingPrefix);
         case GST_MESSAGE_NEED_CONTEXT:
         case GST_MESSAGE_TAG:
         case GST_MESSAGE_STREAM_STATUS:
         case GST_MESSAGE_LATENCY:
-        case GST_MESSAGE_ASYNC_DONE:
         case GST_MESSAGE_NEW_CLOCK:
             break;
 
@@ -826,7 +1182,7 @@ void MediaBackend::buildAudioSinkBin()
     m_fader->setVolumeElement(m_faderVolumeElement);
     auto aConvInput = gst_element_factory_make("audioconvert", "aConvInput");
     m_audioSink = gst_element_factory_make("autoaudiosink", "autoAudioSink");
-    auto rgVolume = gst_element_factory_make("rgvolume", "rgVolume");
+    m_rgVolume = gst_element_factory_make("rgvolume", "rgVolume");
     auto level = gst_element_factory_make("level", "level");
     m_equalizer = gst_element_factory_make("equalizer-10bands", "equalizer");
     m_bus = gst_element_get_bus(m_pipeline);
@@ -839,17 +1195,21 @@ void MediaBackend::buildAudioSinkBin()
     g_object_set(m_fltrPostPanorama, "caps", m_audioCapsStereo, nullptr);
     m_volumeElement = gst_element_factory_make("volume", "m_volumeElement");
     auto queueMainAudio = gst_element_factory_make("queue", "queueMainAudio");
-    auto queueEndAudio = gst_element_factory_make("queue", "queueEndAudio");
-    auto audioResample = gst_element_factory_make("audioresample", "audioResample");
-    g_object_set(audioResample, "sinc-filter-mode", 1, "quality", 10, nullptr);
+    m_queueEndAudio = gst_element_factory_make("queue", "queueEndAudio");
+    g_signal_connect(m_queueEndAudio, "underrun", G_CALLBACK(audioQueueUnderrun_cb), this);
+    auto queueEndAudioSinkPad = gst_element_get_static_pad(m_queueEndAudio, "sink");
+    gst_pad_add_probe(queueEndAudioSinkPad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH, &MediaBackend::audioEosProbe, this, nullptr);
+    gst_object_unref(queueEndAudioSinkPad);
+    m_audioResample = gst_element_factory_make("audioresample", "audioResample");
+    g_object_set(m_audioResample, "sinc-filter-mode", 1, nullptr);
     m_scaleTempo = gst_element_factory_make("scaletempo", "scaleTempo");
     m_audioPanorama = gst_element_factory_make("audiopanorama", "audioPanorama");
     g_object_set(m_audioPanorama, "method", 1, nullptr);
 
     GstElement *audioBinLastElement;
 
-    gst_bin_add_many(GST_BIN(m_audioBin), queueMainAudio, audioResample, m_audioPanorama, level, m_scaleTempo, aConvInput, rgVolume, /*rgLimiter,*/ m_volumeElement, m_equalizer, aConvPostPanorama, m_fltrPostPanorama, m_faderVolumeElement, nullptr);
-    gst_element_link_many(queueMainAudio, aConvInput, audioResample, rgVolume, /*rgLimiter,*/ m_scaleTempo, level, m_equalizer, m_audioPanorama, aConvPostPanorama, audioBinLastElement = m_fltrPostPanorama, nullptr);
+    gst_bin_add_many(GST_BIN(m_audioBin), queueMainAudio, m_audioResample, m_audioPanorama, level, m_scaleTempo, aConvInput, m_rgVolume, /*rgLimiter,*/ m_volumeElement, m_equalizer, aConvPostPanorama, m_fltrPostPanorama, m_faderVolumeElement, nullptr);
+    gst_element_link_many(queueMainAudio, aConvInput, m_audioResample, m_rgVolume, /*rgLimiter,*/ m_scaleTempo, level, m_equalizer, m_audioPanorama, aConvPostPanorama, audioBinLastElement = m_fltrPostPanorama, nullptr);
 
     if (m_loadPitchShift)
     {
@@ -859,15 +1219,22 @@ void MediaBackend::buildAudioSinkBin()
         {
             m_logger->info("{} Using RubberBand pitch shifter", m_loggingPrefix);
 
-            auto aConvPrePitchShift = gst_element_factory_make("audioconvert", "aConvPrePitchShift");
-            auto aConvPostPitchShift = gst_element_factory_make("audioconvert", "aConvPostPitchShift");
+            m_aConvPrePitchShift = gst_element_factory_make("audioconvert", "aConvPrePitchShift");
+            m_aConvPostPitchShift = gst_element_factory_make("audioconvert", "aConvPostPitchShift");
 
-            gst_bin_add_many(GST_BIN(m_audioBin), aConvPrePitchShift, m_pitchShifterRubberBand, aConvPostPitchShift, nullptr);
-            gst_element_link_many(audioBinLastElement, aConvPrePitchShift, m_pitchShifterRubberBand, aConvPostPitchShift, nullptr);
-            audioBinLastElement = aConvPostPitchShift;
-            g_object_set(m_pitchShifterRubberBand, "formant-preserving", true, nullptr);
-            g_object_set(m_pitchShifterRubberBand, "crispness", 1, nullptr);
+            gst_bin_add_many(GST_BIN(m_audioBin), m_aConvPrePitchShift, m_pitchShifterRubberBand, m_aConvPostPitchShift, nullptr);
+            gst_element_link_many(audioBinLastElement, m_aConvPrePitchShift, m_pitchShifterRubberBand, m_aConvPostPitchShift, nullptr);
+            audioBinLastElement = m_aConvPostPitchShift;
             g_object_set(m_pitchShifterRubberBand, "semitones", 0, nullptr);
+
+            // Keep SoundTouch on hand for the lowest DSP quality tier, both are held so either can be swapped out
+            if ((m_pitchShifterSoundtouch = gst_element_factory_make("pitch", "pitch")))
+            {
+                gst_object_ref_sink(m_pitchShifterSoundtouch);
+                gst_object_ref(m_pitchShifterRubberBand);
+                g_object_set(m_pitchShifterSoundtouch, "pitch", 1.0, "tempo", 1.0, nullptr);
+                m_pitchEngineSwappable = true;
+            }
         }
 #endif
         // fail back to "pitch" plugin
@@ -883,8 +1250,12 @@ void MediaBackend::buildAudioSinkBin()
         }
     }
 
-    gst_bin_add_many(GST_BIN(m_audioBin), m_aConvEnd, queueEndAudio, m_audioSink, nullptr);
-    gst_element_link_many(audioBinLastElement, queueEndAudio, m_volumeElement, m_faderVolumeElement, m_aConvEnd, m_audioSink, nullptr);
+    gst_bin_add_many(GST_BIN(m_audioBin), m_aConvEnd, m_queueEndAudio, m_audioSink, nullptr);
+    gst_element_link_many(audioBinLastElement, m_queueEndAudio, m_volumeElement, m_faderVolumeElement, m_aConvEnd, m_audioSink, nullptr);
+    // On the converter feeding the sink rather than on the sink itself, which gets swapped when the device changes
+    auto aConvEndSrcPad = gst_element_get_static_pad(m_aConvEnd, "src");
+    gst_pad_add_probe(aConvEndSrcPad, GST_PAD_PROBE_TYPE_BUFFER, &MediaBackend::audioSinkStarvationProbe, this, nullptr);
+    gst_object_unref(aConvEndSrcPad);
 
     auto csource = gst_interpolation_control_source_new ();
     GstControlBinding *cbind = gst_direct_control_binding_new (GST_OBJECT_CAST(m_faderVolumeElement), "volume", csource);
@@ -898,7 +1269,8 @@ void MediaBackend::buildAudioSinkBin()
     gst_element_add_pad(m_audioBin, ghostPad);
     gst_object_unref(pad);
 
-    g_object_set(rgVolume, "album-mode", false, nullptr);
+    g_object_set(m_rgVolume, "album-mode", false, nullptr);
+    applyDspQualityTier(m_dspQualityTier);
     g_object_set(level, "message", TRUE, nullptr);
     setVolume(m_volume);
     m_timerSlow.start(1000);
@@ -920,6 +1292,24 @@ void MediaBackend::buildAudioSinkBin()
 }
 
 
+void MediaBackend::audioQueueUnderrun_cb(GstElement *queue, gpointer caller)
+{
+    // Streaming thread, counted here and evaluated by the slow timer.  The queue running dry only means the DSP is
+    // slow to refill it, whether the sink actually starved is up to audioSinkStarvationProbe.
+    Q_UNUSED(queue)
+    auto backend = static_cast<MediaBackend*>(caller);
+    if (backend->m_audioEos)
+        return;
+    backend->m_dspUnderruns++;
+}
+
+void MediaBackend::audioSinkElementAdded_cb([[maybe_unused]] GstBin *bin, [[maybe_unused]] GstBin *subBin, GstElement *element, gpointer caller)
+{
+    // autoaudiosink only creates the real sink on going to READY, before the buffer sizes are read
+    if (GST_IS_AUDIO_BASE_SINK(element))
+        static_cast<MediaBackend*>(caller)->configureAudioSinkBuffering(element);
+}
+
 void MediaBackend::padAddedToDecoder_cb(GstElement *element,  GstPad *pad, gpointer caller)
 {
     auto *backend = (MediaBackend*)caller;
@@ -949,11 +1339,152 @@ void MediaBackend::padAddedToDecoder_cb(GstElement *element,  GstPad *pad, gpoin
     }
 }
 
+void MediaBackend::setPlaybackSource(const QString &sourcePath, qint64 prepareMs)
+{
+    m_nextSourcePath = sourcePath;
+    m_nextPrepareMs = prepareMs;
+}
+
+void MediaBackend::beginHealthSession()
+{
+    endHealthSession();
+    m_health = PlaybackHealth();
+    m_health.backend = m_objName;
+    m_health.sourcePath = m_nextSourcePath.isEmpty() ? (m_cdgMode ? m_cdgFilename : m_filename) : m_nextSourcePath;
+    m_health.prepareMs = m_nextPrepareMs;
+    m_nextSourcePath.clear();
+    m_nextPrepareMs = -1;
+    m_seekPending = false;
+    m_pendingSeekPosition = -1;
+    m_watchdogStalled = false;
+    m_firstAudioMs = -1;
+    m_firstVideoMs = -1;
+    m_sinkSongUnderruns = 0;
+    m_sinkSongResyncs = 0;
+    m_healthTimer.start();
+    m_healthSessionActive = true;
+    // One shot probes, each removes itself on the first buffer so steady state playback pays nothing
+    auto audioPad = gst_element_get_static_pad(m_aConvEnd, "src");
+    m_firstAudioProbeId = gst_pad_add_probe(audioPad, GST_PAD_PROBE_TYPE_BUFFER, &MediaBackend::firstAudioBufferProbe, this, nullptr);
+    gst_object_unref(audioPad);
+    auto videoPad = gst_element_get_static_pad(m_videoTee, "sink");
+    m_firstVideoProbeId = gst_pad_add_probe(videoPad, GST_PAD_PROBE_TYPE_BUFFER, &MediaBackend::firstVideoBufferProbe, this, nullptr);
+    gst_object_unref(videoPad);
+}
+
+void MediaBackend::endHealthSession()
+{
+    if (!m_healthSessionActive)
+        return;
+    m_healthSessionActive = false;
+    if (auto probeId = m_firstAudioProbeId.exchange(0))
+    {
+        auto pad = gst_element_get_static_pad(m_aConvEnd, "src");
+        gst_pad_remove_probe(pad, probeId);
+        gst_object_unref(pad);
+    }
+    if (auto probeId = m_firstVideoProbeId.exchange(0))
+    {
+        auto pad = gst_element_get_static_pad(m_videoTee, "sink");
+        gst_pad_remove_probe(pad, probeId);
+        gst_object_unref(pad);
+    }
+    m_health.firstAudioMs = m_firstAudioMs;
+    m_health.firstVideoMs = m_firstVideoMs;
+    m_health.playedMs = m_lastPosition;
+    if (m_sinkSongUnderruns > 0 || m_sinkSongResyncs > 0)
+        m_logger->info("{} Audio sink starved {} times and resynced {} times during playback with a {} ms buffer",
+                       m_loggingPrefix, m_sinkSongUnderruns, m_sinkSongResyncs, m_sinkAppliedBufferMs.load());
+    emit playbackHealthRecorded(m_health);
+}
+
+GstPadProbeReturn MediaBackend::firstAudioBufferProbe([[maybe_unused]] GstPad *pad, [[maybe_unused]] GstPadProbeInfo *info, gpointer userData)
+{
+    auto backend = reinterpret_cast<MediaBackend*>(userData);
+    // Whoever zeroes the id owns the probe's removal, endHealthSession() may be racing us from the main thread
+    if (backend->m_firstAudioProbeId.exchange(0) == 0)
+        return GST_PAD_PROBE_OK;
+    backend->m_firstAudioMs = backend->m_healthTimer.elapsed();
+    return GST_PAD_PROBE_REMOVE;
+}
+
+GstPadProbeReturn MediaBackend::audioEosProbe([[maybe_unused]] GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    // Streaming thread.  The queue still holds up to a second of audio at this point, everything it reports while
+    // playing that out is the end of the song and not an underrun.
+    auto backend = reinterpret_cast<MediaBackend*>(userData);
+    switch (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)))
+    {
+    case GST_EVENT_EOS:
+        backend->m_audioEos = true;
+        break;
+    case GST_EVENT_FLUSH_STOP:
+    case GST_EVENT_STREAM_START:
+        backend->m_audioEos = false;
+        break;
+    default:
+        break;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn MediaBackend::audioSinkStarvationProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    // Streaming thread.  A buffer reaching the sink after its play time means the sink's ring buffer already ran out
+    // and played silence in its place, or will drop it and resync.  Small misses are within the sink's own
+    // alignment threshold and don't glitch.
+    static constexpr GstClockTimeDiff toleranceNs{20 * GST_MSECOND};
+    auto backend = reinterpret_cast<MediaBackend*>(userData);
+    auto buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (backend->m_audioEos || !GST_BUFFER_PTS_IS_VALID(buffer) || GST_STATE(backend->m_pipeline) != GST_STATE_PLAYING)
+        return GST_PAD_PROBE_OK;
+    auto segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (!segmentEvent)
+        return GST_PAD_PROBE_OK;
+    const GstSegment *segment;
+    gst_event_parse_segment(segmentEvent, &segment);
+    auto runningTime = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    gst_event_unref(segmentEvent);
+    auto clock = gst_element_get_clock(backend->m_pipeline);
+    if (!clock || !GST_CLOCK_TIME_IS_VALID(runningTime))
+    {
+        if (clock)
+            gst_object_unref(clock);
+        return GST_PAD_PROBE_OK;
+    }
+    auto clockRunningTime = static_cast<GstClockTimeDiff>(gst_clock_get_time(clock) - gst_element_get_base_time(backend->m_pipeline));
+    gst_object_unref(clock);
+    auto latency = gst_pipeline_get_latency(GST_PIPELINE(backend->m_pipeline));
+    auto playTime = static_cast<GstClockTimeDiff>(runningTime + (GST_CLOCK_TIME_IS_VALID(latency) ? latency : 0));
+    bool starved = clockRunningTime - playTime > toleranceNs;
+    if (starved && !backend->m_sinkStarved)
+        backend->m_sinkUnderruns++;
+    backend->m_sinkStarved = starved;
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn MediaBackend::firstVideoBufferProbe([[maybe_unused]] GstPad *pad, [[maybe_unused]] GstPadProbeInfo *info, gpointer userData)
+{
+    auto backend = reinterpret_cast<MediaBackend*>(userData);
+    if (backend->m_firstVideoProbeId.exchange(0) == 0)
+        return GST_PAD_PROBE_OK;
+    backend->m_firstVideoMs = backend->m_healthTimer.elapsed();
+    return GST_PAD_PROBE_REMOVE;
+}
+
 void MediaBackend::stopPipeline()
 {
+    endHealthSession();
+    m_scrubSettleTimer.stop();
+    m_scrubPosition = -1;
+    m_pendingSeekPosition = -1;
+    m_seekPending = false;
+    m_changingAudioOutputs = false;
     gst_element_set_state(m_pipeline, GST_STATE_NULL);
     m_currentState = GST_STATE_NULL;
     m_hasVideo = false;
+    if (m_cdgMirror)
+        m_cdgMirror->endStream();
     emit stateChanged(MediaBackend::StoppedState);
     emit hasActiveVideoChanged(false);
 }
@@ -997,6 +1528,24 @@ void MediaBackend::getAudioOutputDevices()
         m_logger->debug("{} Constructing for preview use, skipping audio output device detection", m_loggingPrefix);
         return;
     }
+    // The pipeline starts out on the default sink, the configured device gets swapped in once the shared probe
+    // finishes.  Device enumeration can take a second or more with some drivers and used to run once per backend
+    // on the GUI thread before the main window could show.
+    m_audioDeviceProbeWatcher.setFuture(audioOutputDeviceProbe());
+}
+
+QFuture<std::vector<MediaBackend::AudioOutputDevice>> MediaBackend::audioOutputDeviceProbe()
+{
+    static auto probe = QtConcurrent::run(&MediaBackend::probeAudioOutputDevices);
+    return probe;
+}
+
+std::vector<MediaBackend::AudioOutputDevice> MediaBackend::probeAudioOutputDevices()
+{
+    auto logger = spdlog::get("logger");
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<AudioOutputDevice> probedDevices;
     auto monitor = gst_device_monitor_new ();
     auto moncaps = gst_caps_new_empty_simple ("audio/x-raw");
     auto monId = gst_device_monitor_add_filter (monitor, "Audio/Sink", moncaps);
@@ -1005,11 +1554,12 @@ void MediaBackend::getAudioOutputDevices()
     devices = gst_device_monitor_get_devices(monitor);
     for(elem = devices; elem; elem = elem->next) {
         auto *deviceName = gst_device_get_display_name(reinterpret_cast<GstDevice*>(elem->data));
-        m_audioOutputDevices.emplace_back(
+        // index 0 is the default device every backend adds itself
+        probedDevices.emplace_back(
                     AudioOutputDevice{
-                        QString::number(m_audioOutputDevices.size()) + " - " + QString(deviceName),
+                        QString::number(probedDevices.size() + 1) + " - " + QString(deviceName),
                         reinterpret_cast<GstDevice*>(elem->data),
-                        m_audioOutputDevices.size()
+                        probedDevices.size() + 1
                     }
                     );
         g_free(deviceName);
@@ -1018,6 +1568,26 @@ void MediaBackend::getAudioOutputDevices()
     gst_device_monitor_remove_filter(monitor, monId);
     gst_caps_unref(moncaps);
     gst_object_unref(monitor);
+    logger->info("[MediaBackend] Found {} audio output devices in {} ms", probedDevices.size(), timer.elapsed());
+    return probedDevices;
+}
+
+void MediaBackend::audioOutputDevicesProbed()
+{
+    // The probe result keeps its own reference to each device for the life of the process
+    for (const auto &device : m_audioDeviceProbeWatcher.result())
+    {
+        gst_object_ref(device.gstDevice);
+        m_audioOutputDevices.emplace_back(device);
+        m_outputDeviceNames.append(device.name);
+    }
+    auto configuredDevice = (m_type == Karaoke) ? m_settings.audioOutputDevice() : m_settings.audioOutputDeviceBm();
+    auto it = std::find_if(m_audioOutputDevices.begin(), m_audioOutputDevices.end(), [&configuredDevice] (const AudioOutputDevice &device) {
+        return (device.name == configuredDevice);
+    });
+    if (it != m_audioOutputDevices.end() && it->index != m_outputDevice.index)
+        setAudioOutputDevice(*it);
+    emit audioOutputDevicesChanged();
 }
 
 void MediaBackend::fadeOut(const bool &waitForFade)
@@ -1106,56 +1676,109 @@ void MediaBackend::setAudioOutputDevice(const AudioOutputDevice &device)
     else
         m_logger->info("{} Setting audio output device to \"{}\"", m_loggingPrefix, device.name.toStdString());
     m_outputDevice = device;
-    auto curpos = position();
-    bool playAfter{false};
-    if (state() == PlayingState)
-    {
-        playAfter = true;
-        m_changingAudioOutputs = true;
-        gst_element_set_state(m_pipeline, GST_STATE_NULL);
-        m_logger->debug("{} Waiting for media to enter stopped state", m_loggingPrefix);
-        GstState curState;
-        gst_element_get_state(m_pipeline, &curState, nullptr, GST_CLOCK_TIME_NONE);
-        while (curState != GST_STATE_NULL)
-        {
-            gst_element_get_state(m_pipeline, &curState, nullptr, GST_CLOCK_TIME_NONE);
-            QApplication::processEvents();
-        }
-        m_logger->debug("{} Media entered stopped state, continuing output device change", m_loggingPrefix);
-    }
-    m_logger->debug("{} Unlinking and removing old elements", m_loggingPrefix);
-    gst_element_unlink(m_aConvEnd, m_audioSink);
-    gst_bin_remove(GST_BIN(m_audioBin), m_audioSink);
     m_logger->debug("{} Creating new audio sink element", m_loggingPrefix);
+    GstElement *newSink;
     if (m_outputDevice.index <= 0) {
-        m_audioSink = gst_element_factory_make("autoaudiosink", "audioSink");
+        newSink = gst_element_factory_make("autoaudiosink", "audioSink");
     } else {
-        m_audioSink = gst_device_create_element(m_outputDevice.gstDevice, nullptr);
+        newSink = gst_device_create_element(m_outputDevice.gstDevice, nullptr);
     }
-    m_logger->debug("{} Adding and linking new audio output element", m_loggingPrefix);
-    gst_bin_add(GST_BIN(m_audioBin), m_audioSink);
-    gst_element_link(m_aConvEnd, m_audioSink);
-    if (playAfter)
+    if (!newSink)
     {
-        m_logger->debug("{} Resuming playback after audio output device change", m_loggingPrefix);
-        if (m_cdgMode)
-            setMediaCdg(m_cdgFilename, m_filename);
-        else
-            setMedia(m_filename);
-        play();
-        m_logger->debug("{} Waiting or pipeline to enter playing state", m_loggingPrefix);
-        GstState curState;
-        gst_element_get_state(m_pipeline, &curState, nullptr, GST_CLOCK_TIME_NONE);
-        while (curState != GST_STATE_PLAYING)
-        {
-            gst_element_get_state(m_pipeline, &curState, nullptr, GST_CLOCK_TIME_NONE);
-            QApplication::processEvents();
-        }
-        m_logger->debug("{} Jumping back to previous playback position after audio output device change", m_loggingPrefix);
-        setPosition(curpos);
+        m_logger->error("{} Unable to create audio sink for output device, keeping current output", m_loggingPrefix);
+        return;
     }
+    int minMs = m_settings.audioSinkBufferMinMs();
+    int maxMs = std::max(minMs, m_settings.audioSinkBufferMaxMs());
+    int learnedMs = m_settings.audioSinkBufferMs(audioSinkDeviceKey());
+    m_sinkBufferMs = std::clamp(learnedMs > 0 ? learnedMs : m_sinkDefaultBufferMs, minMs, maxMs);
+    m_sinkCleanTicks = 0;
+    m_sinkSlaved = false;
+    m_logger->info("{} Using a {} ms audio sink buffer{}", m_loggingPrefix, m_sinkBufferMs.load(), learnedMs > 0 ? " learned for this device" : "");
+    if (GST_IS_BIN(newSink))
+        g_signal_connect(newSink, "deep-element-added", G_CALLBACK(audioSinkElementAdded_cb), this);
+    configureAudioSinkBuffering(newSink);
+    if (m_audioSinkSwapProbeId != 0)
+    {
+        // A swap is already underway, the newest request follows once it's done
+        if (m_queuedAudioSink)
+            gst_object_unref(m_queuedAudioSink);
+        m_queuedAudioSink = GST_ELEMENT(gst_object_ref_sink(newSink));
+        return;
+    }
+    if (state() != PlayingState && state() != PausedState)
+    {
+        swapAudioSink(newSink);
+        return;
+    }
+    startAudioSinkSwap(GST_ELEMENT(gst_object_ref_sink(newSink)));
+}
 
-    m_changingAudioOutputs = false;
+void MediaBackend::startAudioSinkSwap(GstElement *newSink)
+{
+    // Swap the sink in place from an idle probe so the rest of the pipeline keeps its position and decoder state.
+    // While paused the sink is holding the streaming thread for preroll, so the swap happens as soon as playback resumes.
+    // The new sink goes into the bin up front, the probe only relinks pads and everything else is done back on this
+    // thread, m_audioSink is never touched from the streaming thread.
+    m_audioSinkSwapTimer.start();
+    gst_bin_add(GST_BIN(m_audioBin), newSink);
+    m_pendingAudioSink = newSink;
+    m_logger->debug("{} Waiting for audio stream to go idle to swap output elements", m_loggingPrefix);
+    auto pad = gst_element_get_static_pad(m_aConvEnd, "src");
+    m_audioSinkSwapProbeId = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_IDLE, &MediaBackend::audioSinkSwapProbe, this, nullptr);
+    gst_object_unref(pad);
+}
+
+GstPadProbeReturn MediaBackend::audioSinkSwapProbe(GstPad *pad, [[maybe_unused]] GstPadProbeInfo *info, gpointer userData)
+{
+    auto backend = reinterpret_cast<MediaBackend*>(userData);
+    auto newSink = backend->m_pendingAudioSink.exchange(nullptr);
+    if (!newSink)
+        return GST_PAD_PROBE_OK;
+    if (auto oldSinkPad = gst_pad_get_peer(pad))
+    {
+        gst_pad_unlink(pad, oldSinkPad);
+        gst_object_unref(oldSinkPad);
+    }
+    auto newSinkPad = gst_element_get_static_pad(newSink, "sink");
+    gst_pad_link(pad, newSinkPad);
+    gst_object_unref(newSinkPad);
+    // The pad stays blocked until the new sink has been started
+    QMetaObject::invokeMethod(backend, [backend, newSink] () {
+        backend->finishAudioSinkSwap(newSink);
+    }, Qt::QueuedConnection);
+    return GST_PAD_PROBE_OK;
+}
+
+void MediaBackend::finishAudioSinkSwap(GstElement *newSink)
+{
+    m_logger->debug("{} Removing old audio output element and starting the new one", m_loggingPrefix);
+    auto oldSink = std::exchange(m_audioSink, newSink);
+    gst_element_set_state(oldSink, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(m_audioBin), oldSink);
+    // Removing the old sink takes the pipeline clock with it, the resulting clock lost message restarts the clock
+    // from the bus handler once the new sink is running
+    gst_element_sync_state_with_parent(m_audioSink);
+    auto pad = gst_element_get_static_pad(m_aConvEnd, "src");
+    gst_pad_remove_probe(pad, m_audioSinkSwapProbeId);
+    gst_object_unref(pad);
+    m_audioSinkSwapProbeId = 0;
+    gst_object_unref(newSink);
+    if (m_queuedAudioSink)
+        startAudioSinkSwap(std::exchange(m_queuedAudioSink, nullptr));
+}
+
+void MediaBackend::swapAudioSink(GstElement *newSink)
+{
+    m_logger->debug("{} Unlinking and removing old audio output element", m_loggingPrefix);
+    gst_element_unlink(m_aConvEnd, m_audioSink);
+    gst_element_set_state(m_audioSink, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(m_audioBin), m_audioSink);
+    m_logger->debug("{} Adding and linking new audio output element", m_loggingPrefix);
+    m_audioSink = newSink;
+    gst_bin_add(GST_BIN(m_audioBin), m_audioSink);
+    gst_element_link(m_aConvEnd, m_audioSink);
+    gst_element_sync_state_with_parent(m_audioSink);
 }
 
 void MediaBackend::setAudioOutputDevice(const QString &deviceName)
@@ -1204,12 +1827,76 @@ void MediaBackend::setVideoOutputWidgets(const std::vector<QWidget*>& surfaces)
         gst_bin_add_many(GST_BIN(m_videoBin), videoQueue, videoConv, vd.videoScale, vd.videoSink, nullptr);
         gst_element_link_many(m_videoTee, videoQueue, videoConv, vd.videoScale, vd.videoSink, nullptr);
 
-        m_videoSinks.push_back(vd);
+        vd.gate = std::make_unique<VideoBranchGate>();
+        auto queuePad = gst_element_get_static_pad(videoQueue, "sink");
+        gst_pad_add_probe(queuePad, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH),
+                          &MediaBackend::videoBranchGateProbe, vd.gate.get(), nullptr);
+        gst_object_unref(queuePad);
+        surface->installEventFilter(this);
+        if (surface->window() != surface)
+            surface->window()->installEventFilter(this);
+
+        m_videoSinks.push_back(std::move(vd));
     }
 
+    updateVideoBranchGates();
     resetVideoSinks();
 }
 
+GstPadProbeReturn MediaBackend::videoBranchGateProbe([[maybe_unused]] GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    auto gate = reinterpret_cast<VideoBranchGate*>(userData);
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        // Hidden surfaces still get the first frame after a flush or stream start, otherwise their sink
+        // never prerolls and the pipeline can't complete the state change
+        if (gate->prerollPending.exchange(false) || !gate->surfaceHidden)
+            return GST_PAD_PROBE_OK;
+        return GST_PAD_PROBE_DROP;
+    }
+    switch (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)))
+    {
+    case GST_EVENT_FLUSH_STOP:
+    case GST_EVENT_STREAM_START:
+        gate->prerollPending = true;
+        break;
+    default:
+        break;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+void MediaBackend::updateVideoBranchGates()
+{
+    bool anyShown{false};
+    for (auto &vs : m_videoSinks)
+    {
+        bool hidden = !vs.surface->isVisible() || vs.surface->window()->isMinimized();
+        if (vs.gate->surfaceHidden.exchange(hidden) != hidden)
+        {
+            m_logger->debug("{} Video output {} {}", m_loggingPrefix, vs.surface->objectName(), hidden ? "hidden, dropping frames for its branch" : "shown, resuming its branch");
+            anyShown = anyShown || !hidden;
+        }
+    }
+    if (anyShown)
+        forceVideoExpose();
+}
+
+bool MediaBackend::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type())
+    {
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::WindowStateChange:
+        updateVideoBranchGates();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
 const char* MediaBackend::getVideoSinkElementNameForFactory()
 {
 #if defined(Q_OS_LINUX)
@@ -29,10 +29,13 @@
 #include <gst/controller/gstinterpolationcontrolsource.h>
 #include <gst/controller/gstdirectcontrolbinding.h>
 #include <cdg/cdgappsrc.h>
+#include <cdg/cdgmirror.h>
 #include "settings.h"
 
 #include <QTimer>
 #include <QThread>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QImage>
 #include "audiofader.h"
@@ -82,12 +85,39 @@ public:
         XVideo
     };
 
+    // Pitch and tempo processing quality, stepped down while audio processing can't keep up with playback
+    enum DspQualityTier {
+        DspQualityHigh=0,
+        DspQualityBalanced,
+        DspQualityLow,
+        DspQualityMinimal
+    };
+
     struct AudioOutputDevice {
         QString name;
         GstDevice* gstDevice{nullptr};
         size_t index{0};
     };
 
+    // Timing and trouble counters for one play() through to stop or end of media, see PlaybackJournal.
+    // Times are in ms since play() was called, -1 when the event never happened.
+    struct PlaybackHealth {
+        QString backend;
+        QString sourcePath;
+        qint64 prepareMs{-1};
+        qint64 firstAudioMs{-1};
+        qint64 firstVideoMs{-1};
+        int audioQosEvents{0};
+        quint64 videoFramesDropped{0};
+        int warnings{0};
+        int watchdogTrips{0};
+        int seeks{0};
+        qint64 seekTotalMs{0};
+        qint64 seekMaxMs{0};
+        qint64 playedMs{0};
+        bool error{false};
+    };
+
     explicit MediaBackend(QObject *parent, QString objectName, MediaType type);
     ~MediaBackend() override;
 
@@ -107,6 +137,10 @@ public:
     void forceVideoExpose();
     QString getName() { return m_objName; }
     void writePipelinesGraphToFile(const QString& filePath);
+    // Library path and extraction/copy time for the next play(), the backend itself only sees the temp copy
+    void setPlaybackSource(const QString &sourcePath, qint64 prepareMs);
+    // Gain applied to songs without ReplayGain tags, from the library's loudness analysis
+    void setLoudnessGain(double gainDb);
 
     qint64 position();
     qint64 duration();
@@ -131,11 +165,18 @@ public:
 
 private:
 
+    // Shared with the streaming thread through a pad probe at the head of each video branch
+    struct VideoBranchGate {
+        std::atomic<bool> surfaceHidden { false };
+        std::atomic<bool> prerollPending { true };
+    };
+
     struct VideoSinkData {
         QWidget *surface { nullptr };
         GstElement *videoSink { nullptr };
         GstElement *videoScale { nullptr };
         SoftwareRenderVideoSink *softwareRenderVideoSink { nullptr };
+        std::unique_ptr<VideoBranchGate> gate;
     };
 
     QString m_objName;
@@ -148,6 +189,8 @@ private:
     GstBin     *m_pipelineAsBin { nullptr };
     GstElement *m_decoder { nullptr };
     CdgAppSrc  *m_cdgSrc { nullptr };
+    // Only created for the karaoke backend when mirroring is turned on
+    CdgPacketPublisher *m_cdgMirror { nullptr };
 
     PadInfo *m_audioSrcPad { nullptr };
     PadInfo *m_videoSrcPad { nullptr };
@@ -161,8 +204,13 @@ private:
     GstElement *m_fltrPostPanorama { nullptr };
     GstElement *m_pitchShifterRubberBand { nullptr };
     GstElement *m_pitchShifterSoundtouch { nullptr };
+    GstElement *m_aConvPrePitchShift { nullptr };
+    GstElement *m_aConvPostPitchShift { nullptr };
+    GstElement *m_audioResample { nullptr };
+    GstElement *m_queueEndAudio { nullptr };
     GstElement *m_volumeElement { nullptr };
     GstElement *m_faderVolumeElement { nullptr };
+    GstElement *m_rgVolume { nullptr };
     GstElement *m_equalizer { nullptr };
     GstElement *m_audioSink { nullptr };
     GstElement *m_prescalerCapsFilter { nullptr };
@@ -174,6 +222,7 @@ private:
     GstCaps *m_audioCapsMono { nullptr };
 
     std::vector<AudioOutputDevice> m_audioOutputDevices;
+    QFutureWatcher<std::vector<AudioOutputDevice>> m_audioDeviceProbeWatcher;
 
     std::array<int,10> m_eqLevels{0,0,0,0,0,0,0,0,0,0};
 
@@ -193,6 +242,7 @@ private:
     QTimer m_gstBusMsgHandlerTimer;
     QTimer m_timerFast;
     QTimer m_timerSlow;
+    bool m_timersThrottled{false};
     int m_silenceDuration{0};
     long m_positionWatchdogLastPos{0};
 
@@ -210,10 +260,65 @@ private:
     bool m_loadPitchShift;
     bool m_downmix{false};
     gboolean m_changingAudioOutputs{false};
+    // Handed from the GUI thread to the swap probe, which takes it on the streaming thread
+    std::atomic<GstElement*> m_pendingAudioSink{nullptr};
+    gulong m_audioSinkSwapProbeId{0};
+    GstElement *m_queuedAudioSink{nullptr};
+    QElapsedTimer m_audioSinkSwapTimer;
     std::atomic<bool> m_hasVideo{false};
     bool m_videoAccelEnabled{false};
     QPointer<AudioFader> m_fader;
     std::atomic<GstState> m_currentState { GST_STATE_NULL };
+    PlaybackHealth m_health;
+    bool m_healthSessionActive{false};
+    QString m_nextSourcePath;
+    qint64 m_nextPrepareMs{-1};
+    QElapsedTimer m_healthTimer;
+    QElapsedTimer m_seekTimer;
+    bool m_seekPending{false};
+    qint64 m_seekPosition{0};
+    qint64 m_pendingSeekPosition{-1};
+    GstSeekFlags m_pendingSeekFlags{GST_SEEK_FLAG_FLUSH};
+    qint64 m_scrubPosition{-1};
+    QTimer m_scrubSettleTimer;
+    const qint64 m_seekTimeoutMs{2000};
+    int m_hungCycles{0};
+    bool m_watchdogStalled{false};
+    std::atomic<qint64> m_firstAudioMs{-1};
+    std::atomic<qint64> m_firstVideoMs{-1};
+    std::atomic<gulong> m_firstAudioProbeId{0};
+    std::atomic<gulong> m_firstVideoProbeId{0};
+    DspQualityTier m_dspQualityTier{DspQualityHigh};
+    DspQualityTier m_dspQualityFloor{DspQualityMinimal};
+    // SoundTouch stands in for RubberBand at the lowest tier, swapped between songs while the audio bin is unlinked
+    bool m_pitchEngineSwappable{false};
+    bool m_soundtouchStandIn{false};
+    std::atomic<int> m_dspUnderruns{0};
+    // Set once end of stream has gone into the output queue, the drain that follows isn't the DSP falling behind
+    std::atomic<bool> m_audioEos{false};
+    int m_dspQosEvents{0};
+    int m_dspSettleTicks{0};
+    int m_dspTicksSinceChange{0};
+    int m_dspCleanTicks{0};
+    const int m_dspSettleSecs{3};
+    const int m_dspStepDownHoldSecs{5};
+    const int m_dspStepUpAfterSecs{120};
+    const qint64 m_dspLowWaterMs{200};
+    // Output buffering of the audio sink, learned per device.  Sink underruns and resyncs grow it, it shrinks again after
+    // a long stretch of clean playback.  Buffer sizes can only change while the sink is stopped, so a new size is
+    // used from the next song on.
+    std::atomic<int> m_sinkBufferMs{200};
+    std::atomic<int> m_sinkAppliedBufferMs{0};
+    // Counted by audioSinkStarvationProbe, once per stretch of buffers reaching the sink after their play time
+    std::atomic<int> m_sinkUnderruns{0};
+    bool m_sinkStarved{false};
+    int m_sinkResyncs{0};
+    int m_sinkSongUnderruns{0};
+    int m_sinkSongResyncs{0};
+    int m_sinkCleanTicks{0};
+    bool m_sinkSlaved{false};
+    const int m_sinkDefaultBufferMs{200};
+    const int m_sinkStepDownAfterSecs{600};
 
     void buildPipeline();
     void buildVideoSinkBin();
@@ -221,14 +326,46 @@ private:
     void resetVideoSinks();
     const char* getVideoSinkElementNameForFactory();
     void getAudioOutputDevices();
+    void audioOutputDevicesProbed();
+    static QFuture<std::vector<AudioOutputDevice>> audioOutputDeviceProbe();
+    static std::vector<AudioOutputDevice> probeAudioOutputDevices();
     void writePipelineGraphToFile(GstBin *bin, const QString& filePath, QString fileName);
     static double getPitchForSemitone(const int &semitone);
 
     void gstBusFunc(GstMessage *message);
     static void padAddedToDecoder_cb(GstElement *element,  GstPad *pad, gpointer caller);
+    static void audioQueueUnderrun_cb(GstElement *queue, gpointer caller);
     void stopPipeline();
     void resetPipeline();
     void patchPipelineSinks();
+    void beginHealthSession();
+    void endHealthSession();
+    [[nodiscard]] bool seekInFlight() const;
+    bool seekTo(const qint64 &position, GstSeekFlags flags);
+    bool sendSeek(const qint64 &position, GstSeekFlags flags);
+    void scrubSettled();
+    void setTimersThrottled(bool throttled);
+    static GstPadProbeReturn firstAudioBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn firstVideoBufferProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn audioEosProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn audioSinkStarvationProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn videoBranchGateProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn audioSinkSwapProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    void startAudioSinkSwap(GstElement *newSink);
+    void finishAudioSinkSwap(GstElement *newSink);
+    void swapAudioSink(GstElement *newSink);
+    void updateVideoBranchGates();
+    void updateDspQualityTier();
+    void applyDspQualityTier(DspQualityTier tier);
+    void applyPitchShiftEngine();
+    void updateAudioSinkBuffering();
+    void setAudioSinkBufferMs(int bufferMs);
+    void configureAudioSinkBuffering(GstElement *sink);
+    [[nodiscard]] QString audioSinkDeviceKey() const;
+    static void audioSinkElementAdded_cb(GstBin *bin, GstBin *subBin, GstElement *element, gpointer caller);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
     void timerFast_timeout();
@@ -243,7 +380,9 @@ public slots:
     void setMediaCdg(const QString &cdgFilename, const QString &audioFilename);
     void setMuted(const bool &muted);
     bool isMuted();
-    void setPosition(const qint64 &position);
+    bool setPosition(const qint64 &position);
+    void seekRelative(const qint64 &offsetMs);
+    void scrubTo(const qint64 &position);
     void setVolume(const int &volume);
     void stop(const bool &skipFade = false);
     void rawStop();
@@ -260,6 +399,7 @@ public slots:
     void fadeInImmediate();
     void fadeOutImmediate();
     void setEnforceAspectRatio(const bool &enforce);
+    void setDspQualityFloor(int floor);
 
 signals:
     void audioAvailableChanged(const bool audioAvailable);
@@ -273,6 +413,9 @@ signals:
     void silenceDetected();
     void pitchChanged(const int key);
     void audioError(const QString &msg);
+    void audioOutputDevicesChanged();
+    void playbackHealthRecorded(const MediaBackend::PlaybackHealth &health);
+    void seekCompleted(const qint64 position, const qint64 latencyMs);
 
 };
 
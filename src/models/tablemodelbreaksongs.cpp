@@ -4,6 +4,7 @@
 #include <QMimeData>
 #include <QSqlQuery>
 #include <QString>
+#include <QtConcurrent>
 #include <spdlog/spdlog.h>
 #include <okjsongbookapi.h>
 
@@ -34,7 +35,7 @@ TableModelBreakSongs::TableModelBreakSongs(QObject *parent)
     : QAbstractTableModel(parent)
 {
     m_logger = spdlog::get("logger");
-    loadDatabase();
+    connect(&m_loadWatcher, &QFutureWatcher<std::optional<std::vector<BreakSong>>>::finished, this, &TableModelBreakSongs::asyncLoadFinished);
 }
 
 QVariant TableModelBreakSongs::headerData(int section, Qt::Orientation orientation, int role) const
@@ -107,14 +108,55 @@ QVariant TableModelBreakSongs::data(const QModelIndex &index, int role) const
 
 void TableModelBreakSongs::loadDatabase()
 {
-    emit layoutAboutToBeChanged();
-    m_allSongs.clear();
-    m_filteredSongs.clear();
-    QSqlQuery query;
+    setAllSongs(fetchAllSongs(QSqlDatabase::database()));
+}
+
+void TableModelBreakSongs::loadDatabaseAsync()
+{
+    if (m_loadWatcher.isRunning())
+        return;
+    m_loadTimer.start();
+    auto dbFilePath = QSqlDatabase::database().databaseName();
+    auto connectionName = QString("breaksongs-load-%1").arg(reinterpret_cast<quintptr>(this));
+    m_loadWatcher.setFuture(QtConcurrent::run([dbFilePath, connectionName] () {
+        std::optional<std::vector<BreakSong>> songs;
+        {
+            auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(dbFilePath);
+            if (database.open()) {
+                songs = fetchAllSongs(database);
+                database.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        return songs;
+    }));
+}
+
+void TableModelBreakSongs::asyncLoadFinished()
+{
+    auto songs = m_loadWatcher.result();
+    if (songs)
+    {
+        m_logger->info("{} Background break music load took {} ms", m_loggingPrefix, m_loadTimer.elapsed());
+        setAllSongs(std::move(*songs));
+    }
+    else
+    {
+        m_logger->warn("{} Unable to open the db for a background load, loading on the main thread", m_loggingPrefix);
+        loadDatabase();
+    }
+    emit databaseLoaded();
+}
+
+std::vector<BreakSong> TableModelBreakSongs::fetchAllSongs(const QSqlDatabase &db)
+{
+    std::vector<BreakSong> songs;
+    QSqlQuery query(db);
     query.exec("SELECT songid,artist,title,path,filename,duration,searchstring FROM bmsongs");
     while (query.next())
     {
-        m_allSongs.emplace_back(
+        songs.emplace_back(
         BreakSong{
             query.value(0).toInt(),
             query.value(1).toString(),
@@ -125,6 +167,14 @@ void TableModelBreakSongs::loadDatabase()
             query.value(6).toString().toLower().toStdString(),
         });
     }
+    return songs;
+}
+
+void TableModelBreakSongs::setAllSongs(std::vector<BreakSong> songs)
+{
+    emit layoutAboutToBeChanged();
+    m_allSongs = std::move(songs);
+    m_filteredSongs.clear();
     emit layoutChanged();
     search(m_lastSearch);
     sort(m_lastSortColumn, m_lastSortOrder);
@@ -216,12 +266,30 @@ QMimeData *TableModelBreakSongs::mimeData(const QModelIndexList &indexes) const
     return mimeData;
 }
 
-BreakSong &TableModelBreakSongs::getSong(const int breakSongId)
+std::optional<BreakSong> TableModelBreakSongs::getSong(const int breakSongId)
 {
     auto it = std::find_if(m_allSongs.begin(), m_allSongs.end(), [&breakSongId] (BreakSong &song) {
         return (song.id == breakSongId);
     });
-    return *it;
+    if (it != m_allSongs.end())
+        return *it;
+    QSqlQuery query;
+    query.prepare("SELECT songid,artist,title,path,filename,duration,searchstring FROM bmsongs WHERE songid = :songid");
+    query.bindValue(":songid", breakSongId);
+    if (!query.exec() || !query.first())
+    {
+        m_logger->warn("{} Break song id {} not found in the catalog or the db", m_loggingPrefix, breakSongId);
+        return std::nullopt;
+    }
+    return BreakSong{
+        query.value(0).toInt(),
+        query.value(1).toString(),
+        query.value(2).toString(),
+        query.value(3).toString(),
+        query.value(4).toString(),
+        query.value(5).toInt(),
+        query.value(6).toString().toLower().toStdString(),
+    };
 }
 
 int TableModelBreakSongs::getSongId(const QString &filePath)
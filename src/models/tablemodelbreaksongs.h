@@ -2,7 +2,11 @@
 #define TABLEMODELBREAKSONGSNEW_H
 
 #include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QSqlDatabase>
 #include <QTime>
+#include <optional>
 #include <chrono>
 #include <spdlog/async_logger.h>
 #include "spdlog/spdlog.h"
@@ -35,9 +39,12 @@ public:
     void sort(int column, Qt::SortOrder order) override;
     QMimeData *mimeData(const QModelIndexList &indexes) const override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
-    BreakSong &getSong(const int breakSongId);
+    // Falls back to the db while the break music catalog is still loading, nullopt if the song doesn't exist
+    std::optional<BreakSong> getSong(const int breakSongId);
     int getSongId(const QString &filePath);
     void loadDatabase();
+    // Reads bmsongs on a worker thread with its own db connection and swaps it in when done
+    void loadDatabaseAsync();
     void search(const QString &searchStr);
 
 
@@ -50,6 +57,15 @@ private:
     Qt::SortOrder m_lastSortOrder{Qt::AscendingOrder};
     int m_lastSortColumn{1};
     Settings m_settings;
+    QFutureWatcher<std::optional<std::vector<BreakSong>>> m_loadWatcher;
+    QElapsedTimer m_loadTimer;
+
+    static std::vector<BreakSong> fetchAllSongs(const QSqlDatabase &db);
+    void setAllSongs(std::vector<BreakSong> songs);
+    void asyncLoadFinished();
+
+signals:
+    void databaseLoaded();
 
 };
 
@@ -2,6 +2,7 @@
 
 #include <QSize>
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 #include <QSqlError>
 #include <QPainter>
 #include <QSvgRenderer>
@@ -80,7 +81,7 @@ QVariant TableModelHistorySingers::data(const QModelIndex &index, int role) cons
 
 int TableModelHistorySingers::getSongCount(const int historySingerId)
 {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT COUNT(id) FROM historySongs WHERE historySinger = :historySinger");
     query.bindValue(":historySinger", historySingerId);
     query.exec();
@@ -93,7 +94,7 @@ void TableModelHistorySingers::loadSingers()
 {
     emit layoutAboutToBeChanged();
     m_singers.clear();
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     if (m_filterString == QString())
         query.exec("SELECT id,name FROM historySingers ORDER BY name");
     else
@@ -139,7 +140,7 @@ int TableModelHistorySingers::getId(const QString &historySingerName) const
 
 void TableModelHistorySingers::deleteHistory(const int historySingerId)
 {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("DELETE from historySongs WHERE historySinger = :historySingerId");
     query.bindValue(":historySingerId", historySingerId);
     query.exec();
@@ -154,7 +155,7 @@ bool TableModelHistorySingers::rename(const int historySingerId, const QString &
 {
     if (exists(newName))
         return false;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE historySingers SET name = :newName WHERE id = :historySingerId");
     query.bindValue(":newName", newName);
     query.bindValue(":historySingerId", historySingerId);
@@ -6,6 +6,7 @@
 #include <QSqlError>
 #include <QFontMetrics>
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 
 TableModelHistorySongs::TableModelHistorySongs(TableModelKaraokeSongs &songsModel) : m_karaokeSongsModel(songsModel) {
     m_logger = spdlog::get("logger");
@@ -94,7 +95,7 @@ void TableModelHistorySongs::loadSinger(const int historySingerId) {
     emit layoutAboutToBeChanged();
     beginInsertRows(QModelIndex(), m_songs.size(), m_songs.size());
     m_songs.clear();
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT * from historySongs WHERE historySinger = :historySinger");
     query.bindValue(":historySinger", historySingerId);
     query.exec();
@@ -111,6 +112,7 @@ void TableModelHistorySongs::loadSinger(const int historySingerId) {
         song.lastPlayed = (query.value(8).canConvert<QDateTime>()) ? query.value(8).toDateTime() : QDateTime();
         m_songs.emplace_back(song);
     }
+    updateColumnContentWidths();
     sort(m_lastSortColumn, m_lastSortOrder);
     emit layoutChanged();
     emit endInsertRows();
@@ -118,7 +120,7 @@ void TableModelHistorySongs::loadSinger(const int historySingerId) {
 
 void TableModelHistorySongs::loadSinger(const QString &historySingerName) {
     m_currentSinger = historySingerName;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT id FROM historySingers WHERE name == :name LIMIT 1");
     query.bindValue(":name", historySingerName);
     query.exec();
@@ -128,6 +130,7 @@ void TableModelHistorySongs::loadSinger(const QString &historySingerName) {
         m_logger->debug("{} No history found for singer '{}'. Nothing loaded", m_loggingPrefix, historySingerName);
         emit layoutAboutToBeChanged();
         m_songs.clear();
+        updateColumnContentWidths();
         emit layoutChanged();
     }
 }
@@ -139,7 +142,7 @@ void TableModelHistorySongs::saveSong(const QString &singerName, const QString &
                        m_loggingPrefix);
         return;
     }
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     auto historySingerId = getSingerId(singerName);
     if (historySingerId != -1 && songExists(historySingerId, filePath)) {
         query.prepare("UPDATE historySongs SET artist = :artist, title = :title, songid = :songid, "
@@ -180,7 +183,7 @@ void TableModelHistorySongs::saveSong(const QString &singerName, const QString &
 void TableModelHistorySongs::saveSong(const QString &singerName, const QString &filePath, const QString &artist,
                                       const QString &title, const QString &songid, const int keyChange, int plays,
                                       const QDateTime &lastPlayed) {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     auto historySingerId = getSingerId(singerName);
     if (historySingerId != -1 && songExists(historySingerId, filePath)) {
         return;
@@ -206,7 +209,7 @@ void TableModelHistorySongs::saveSong(const QString &singerName, const QString &
 }
 
 void TableModelHistorySongs::deleteSong(const int historySongId) {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("DELETE FROM historySongs WHERE id = :historySongId");
     query.bindValue(":historySongId", historySongId);
     query.exec();
@@ -214,7 +217,7 @@ void TableModelHistorySongs::deleteSong(const int historySongId) {
 }
 
 int TableModelHistorySongs::addSinger(const QString &name) const {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("INSERT INTO historySingers (name) VALUES( :name )");
     query.bindValue(":name", name);
     query.exec();
@@ -224,7 +227,7 @@ int TableModelHistorySongs::addSinger(const QString &name) const {
 }
 
 bool TableModelHistorySongs::songExists(const int historySingerId, const QString &filePath) const {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT id FROM historySongs WHERE historySinger = :historySinger AND filepath = :filePath LIMIT 1");
     query.bindValue(":historySinger", historySingerId);
     query.bindValue(":filePath", filePath);
@@ -236,7 +239,7 @@ bool TableModelHistorySongs::songExists(const int historySingerId, const QString
 
 int TableModelHistorySongs::getSingerId(const QString &name) const {
     int retVal = -1;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT id FROM historySingers WHERE name = :name LIMIT 1");
     query.bindValue(":name", name);
     query.exec();
@@ -248,7 +251,7 @@ int TableModelHistorySongs::getSingerId(const QString &name) const {
 
 std::vector<okj::HistorySong> TableModelHistorySongs::getSingerSongs(const int historySingerId) {
     std::vector<okj::HistorySong> songs;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT * from historySongs WHERE historySinger = :historySinger");
     query.bindValue(":historySinger", historySingerId);
     query.exec();
@@ -388,4 +391,23 @@ void TableModelHistorySongs::setFont(const QFont &font) {
     m_headerFont.setBold(true);
     m_itemFontMetrics = QFontMetrics(m_itemFont);
     m_itemHeight = m_itemFontMetrics.height() + 6;
+    updateColumnContentWidths();
+}
+
+int TableModelHistorySongs::columnContentWidth(const int column) const {
+    if (column < 0 || column >= static_cast<int>(m_colContentWidths.size()))
+        return 0;
+    return std::max(m_colContentWidths.at(column), getSizeHint(column).toSize().width());
+}
+
+void TableModelHistorySongs::updateColumnContentWidths() {
+    m_colContentWidths.fill(0);
+    for (int row = 0; row < static_cast<int>(m_songs.size()); row++) {
+        for (auto column : {SONGID, KEY_CHANGE, SUNG_COUNT, LAST_SUNG}) {
+            auto text = getDisplayData(index(row, column)).toString();
+            if (text.isEmpty())
+                continue;
+            m_colContentWidths[column] = std::max(m_colContentWidths[column], m_itemFontMetrics.horizontalAdvance(text));
+        }
+    }
 }
@@ -4,6 +4,7 @@
 #include <QAbstractTableModel>
 #include <QDateTime>
 #include <QObject>
+#include <array>
 #include "tablemodelkaraokesongs.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/async_logger.h>
@@ -27,8 +28,10 @@ private:
     QFontMetrics m_itemFontMetrics{m_settings.applicationFont()};
     int m_itemHeight{20};
     QFont m_headerFont;
+    std::array<int, 9> m_colContentWidths{};
 
     QVariant getSizeHint(int section) const;
+    void updateColumnContentWidths();
     QString getColumnName(int section) const;
 
 public slots:
@@ -67,6 +70,7 @@ public:
     void sort(int column, Qt::SortOrder order) override;
     [[nodiscard]] QVariant getDisplayData(const QModelIndex &index) const;
     [[nodiscard]] static QVariant getTextAlignment(const QModelIndex &index) ;
+    [[nodiscard]] int columnContentWidth(int column) const;
 
 };
 
@@ -2,6 +2,7 @@
 
 #include <QApplication>
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 #include <QSqlError>
 #include <QPainter>
 #include <QFileInfo>
@@ -9,7 +10,10 @@
 #include <QDirIterator>
 #include <QSvgRenderer>
 #include <QMimeData>
+#include <QSet>
+#include <QtConcurrent>
 #include <array>
+#include "okjutil.h"
 
 std::ostream & operator<<(std::ostream& os, const QString& s);
 
@@ -18,6 +22,7 @@ TableModelKaraokeSongs::TableModelKaraokeSongs(QObject *parent)
     m_logger = spdlog::get("logger");
     resizeIconsForFont(m_settings.applicationFont());
     connect(&searchTimer, &QTimer::timeout, this, &TableModelKaraokeSongs::searchExec);
+    connect(&m_loadWatcher, &QFutureWatcher<std::optional<SongList>>::finished, this, &TableModelKaraokeSongs::asyncLoadFinished);
 }
 
 QVariant TableModelKaraokeSongs::headerData(int section, Qt::Orientation orientation, int role) const {
@@ -168,34 +173,70 @@ QVariant TableModelKaraokeSongs::getItemDisplayData(const QModelIndex &index) co
 }
 
 void TableModelKaraokeSongs::loadData() {
-    emit layoutAboutToBeChanged();
-    m_allSongs.clear();
-    m_filteredSongs.clear();
-    QSqlQuery query;
-    query.exec("SELECT songid,artist,title,discid,duration,filename,path,searchstring,plays,lastplay FROM dbsongs");
+    setAllSongs(fetchAllSongs(QSqlDatabase::database()));
+}
+
+void TableModelKaraokeSongs::loadDataAsync() {
+    if (m_loadWatcher.isRunning()) {
+        m_reloadAfterLoad = true;
+        return;
+    }
+    m_loadTimer.start();
+    auto dbFilePath = QSqlDatabase::database().databaseName();
+    auto connectionName = QString("karaokesongs-load-%1").arg(reinterpret_cast<quintptr>(this));
+    m_loadWatcher.setFuture(QtConcurrent::run([dbFilePath, connectionName] () {
+        std::optional<SongList> songs;
+        {
+            auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(dbFilePath);
+            if (database.open()) {
+                songs = fetchAllSongs(database);
+                database.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        return songs;
+    }));
+}
+
+void TableModelKaraokeSongs::asyncLoadFinished() {
+    auto songs = m_loadWatcher.result();
+    if (songs) {
+        m_logger->info("{} Background catalog load took {} ms", m_loggingPrefix, m_loadTimer.elapsed());
+        setAllSongs(std::move(*songs));
+    } else {
+        m_logger->warn("{} Unable to open the db for a background load, loading on the main thread", m_loggingPrefix);
+        loadData();
+    }
+    if (m_sortColumn > -1)
+        sort(m_sortColumn, m_sortOrder);
+    emit dataLoaded();
+    if (m_reloadAfterLoad) {
+        // Something changed the db while the load was running, the snapshot we got may predate it
+        m_reloadAfterLoad = false;
+        loadDataAsync();
+    }
+}
+
+TableModelKaraokeSongs::SongList TableModelKaraokeSongs::fetchAllSongs(const QSqlDatabase &db) {
+    SongList songs;
+    InstrumentedSqlQuery query(db);
+    query.exec("SELECT songid,artist,title,discid,duration,filename,path,searchstring,plays,lastplay,audiopath FROM dbsongs");
     if (query.size() > 0)
-        m_filteredSongs.reserve(query.size());
-    while (query.next()) {
-        auto song = m_allSongs.emplace_back(std::make_shared<okj::KaraokeSong>(okj::KaraokeSong{
-                query.value(0).toInt(),
-                query.value(1).toString(),
-                query.value(1).toString().toLower(),
-                query.value(2).toString(),
-                query.value(2).toString().toLower(),
-                query.value(3).toString(),
-                query.value(3).toString().toLower(),
-                query.value(4).toInt(),
-                query.value(5).toString(),
-                query.value(6).toString(),
-                query.value(7).toString().replace('&', " and ").toLower(),
-                query.value(8).toInt(),
-                query.value(9).toDateTime(),
-                (query.value(3).toString() == "!!BAD!!"),
-                (query.value(3).toString() == "!!DROPPED!!")
-        }));
-    }
-    m_logger->info("{} Loaded {} karaoke songs from the db on disk", m_loggingPrefix, m_filteredSongs.size());
-    search(m_lastSearch);
+        songs.reserve(query.size());
+    while (query.next())
+        songs.emplace_back(std::make_shared<okj::KaraokeSong>(songFromQuery(query)));
+    return songs;
+}
+
+void TableModelKaraokeSongs::setAllSongs(SongList songs) {
+    emit layoutAboutToBeChanged();
+    m_allSongs = std::move(songs);
+    m_logger->info("{} Loaded {} karaoke songs from the db on disk", m_loggingPrefix, m_allSongs.size());
+    updateColumnContentWidths();
+    // Filter right away, the debounced search would leave the view empty until its timer fires
+    searchTimer.stop();
+    filterSongs();
     emit layoutChanged();
 }
 
@@ -213,55 +254,51 @@ void TableModelKaraokeSongs::search(const QString &searchString) {
 void TableModelKaraokeSongs::searchExec() {
     searchTimer.stop();
     emit layoutAboutToBeChanged();
-    std::vector<std::string> searchTerms;
-    std::string s = m_lastSearch.toLower().toStdString();
-    std::string::size_type prev_pos = 0, pos = 0;
-    while ((pos = s.find(' ', pos)) != std::string::npos) {
-        searchTerms.emplace_back(s.substr(prev_pos, pos - prev_pos));
-        prev_pos = ++pos;
-    }
-    searchTerms.emplace_back(s.substr(prev_pos, pos - prev_pos));
+    filterSongs();
+    emit layoutChanged();
+}
+
+void TableModelKaraokeSongs::filterSongs() {
     m_filteredSongs.clear();
     m_filteredSongs.reserve(m_allSongs.size());
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-    auto needles = m_lastSearch.split(' ', QString::SplitBehavior::SkipEmptyParts);
-#else
-    auto needles = m_lastSearch.split(' ', Qt::SplitBehavior(Qt::SkipEmptyParts));
-#endif
+    auto needles = searchNeedles();
     for (const auto &song : m_allSongs) {
-        if (song->dropped)
-            continue;
-        if (song->bad)
-            continue;
-        QString haystack;
-        switch (m_searchType) {
-            case TableModelKaraokeSongs::SEARCH_TYPE_ALL: {
-                haystack = song->searchString;
-                break;
-            }
-            case TableModelKaraokeSongs::SEARCH_TYPE_ARTIST: {
-                haystack = song->artistL.replace('&', " and ");
-                break;
-            }
-            case TableModelKaraokeSongs::SEARCH_TYPE_TITLE: {
-                haystack = song->titleL.replace('&', " and ");
-                break;
-            }
-        }
-        if (m_settings.ignoreAposInSearch())
-            haystack.remove('\'');
-        bool match{true};
-        for (const auto &needle : needles) {
-            if (!haystack.contains(needle)) {
-                match = false;
-                continue;
-            }
-        }
-        if (match)
+        if (matchesSearch(*song, needles))
             m_filteredSongs.emplace_back(song);
     }
     m_filteredSongs.shrink_to_fit();
-    emit layoutChanged();
+}
+
+QStringList TableModelKaraokeSongs::searchNeedles() const {
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
+    return m_lastSearch.split(' ', QString::SplitBehavior::SkipEmptyParts);
+#else
+    return m_lastSearch.split(' ', Qt::SplitBehavior(Qt::SkipEmptyParts));
+#endif
+}
+
+bool TableModelKaraokeSongs::matchesSearch(const okj::KaraokeSong &song, const QStringList &needles) const {
+    if (song.dropped || song.bad)
+        return false;
+    QString haystack;
+    switch (m_searchType) {
+        case TableModelKaraokeSongs::SEARCH_TYPE_ALL:
+            haystack = song.searchString;
+            break;
+        case TableModelKaraokeSongs::SEARCH_TYPE_ARTIST:
+            haystack = song.artistL;
+            haystack.replace('&', " and ");
+            break;
+        case TableModelKaraokeSongs::SEARCH_TYPE_TITLE:
+            haystack = song.titleL;
+            haystack.replace('&', " and ");
+            break;
+    }
+    if (m_settings.ignoreAposInSearch())
+        haystack.remove('\'');
+    return std::all_of(needles.begin(), needles.end(), [&haystack](const QString &needle) {
+        return haystack.contains(needle);
+    });
 }
 
 void TableModelKaraokeSongs::setSearchType(TableModelKaraokeSongs::SearchType type) {
@@ -296,6 +333,7 @@ void TableModelKaraokeSongs::updateSongHistory(const int songId) {
     if (it != m_allSongs.end()) {
         it->get()->plays++;
         it->get()->lastPlay = QDateTime::currentDateTime();
+        growColumnContentWidths(**it);
     }
 
     auto it2 = find_if(m_filteredSongs.begin(), m_filteredSongs.end(),
@@ -309,7 +347,7 @@ void TableModelKaraokeSongs::updateSongHistory(const int songId) {
         emit dataChanged(this->index(row, COL_PLAYS), this->index(row, COL_LASTPLAY), QVector<int>(Qt::DisplayRole));
     }
 
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE dbSongs set plays = plays + :incVal, lastplay = :curTs WHERE songid = :songid");
     query.bindValue(":curTs", QDateTime::currentDateTime());
     query.bindValue(":songid", songId);
@@ -317,11 +355,20 @@ void TableModelKaraokeSongs::updateSongHistory(const int songId) {
     query.exec();
 }
 
-okj::KaraokeSong &TableModelKaraokeSongs::getSong(const int songId) {
+std::optional<okj::KaraokeSong> TableModelKaraokeSongs::getSong(const int songId) {
     auto it = std::find_if(m_allSongs.begin(), m_allSongs.end(), [&songId](const std::shared_ptr<okj::KaraokeSong> &song) {
         return (song->id == songId);
     });
-    return **it;
+    if (it != m_allSongs.end())
+        return **it;
+    // The catalog loads in the background at startup, songs added from another model before it's done are still
+    // in the db
+    auto songs = loadSongsById({songId});
+    if (songs.empty()) {
+        m_logger->warn("{} Song id {} not found in the catalog or the db", m_loggingPrefix, songId);
+        return std::nullopt;
+    }
+    return songs.front();
 }
 
 void TableModelKaraokeSongs::resizeIconsForFont(const QFont &font) {
@@ -331,6 +378,7 @@ void TableModelKaraokeSongs::resizeIconsForFont(const QFont &font) {
     m_headerFont.setBold(true);
     m_itemFontMetrics = QFontMetrics(m_itemFont);
     m_itemHeight = m_itemFontMetrics.height() + 6;
+    updateColumnContentWidths();
     QString thm = (m_settings.theme() == 1) ? ":/theme/Icons/okjbreeze-dark/" : ":/theme/Icons/okjbreeze/";
     m_curFontHeight = QFontMetrics(font).height();
     m_iconVid = QImage(m_curFontHeight, m_curFontHeight, QImage::Format_ARGB32);
@@ -365,39 +413,51 @@ Qt::ItemFlags TableModelKaraokeSongs::flags(const QModelIndex &index) const {
 }
 
 
-void TableModelKaraokeSongs::sort(int column, Qt::SortOrder order) {
-    auto sortLambda = [&column](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) -> bool {
-        switch (column) {
-            case COL_ARTIST:
-                if (a->artistL == b->artistL) {
-                    if (a->titleL == b->titleL) {
-                        return (a->songidL < b->songidL);
-                    }
-                    return (a->titleL < b->titleL);
+bool TableModelKaraokeSongs::songLessThan(const int column, const okj::KaraokeSong &a, const okj::KaraokeSong &b) {
+    switch (column) {
+        case COL_ARTIST:
+            if (a.artistL == b.artistL) {
+                if (a.titleL == b.titleL) {
+                    return (a.songidL < b.songidL);
                 }
-                return (a->artistL < b->artistL);
-            case COL_TITLE:
-                if (a->titleL == b->titleL) {
-                    if (a->artistL == b->artistL) {
-                        return (a->songidL < b->songidL);
-                    }
-                    return (a->artistL < b->artistL);
+                return (a.titleL < b.titleL);
+            }
+            return (a.artistL < b.artistL);
+        case COL_TITLE:
+            if (a.titleL == b.titleL) {
+                if (a.artistL == b.artistL) {
+                    return (a.songidL < b.songidL);
                 }
-                return (a->titleL < b->titleL);
-            case COL_SONGID:
-                return (a->songidL < b->songidL);
-            case COL_FILENAME:
-                return (a->filename.toLower() < b->filename.toLower());
-            case COL_DURATION:
-                return (a->duration < b->duration);
-            case COL_PLAYS:
-                return (a->plays < b->plays);
-            case COL_LASTPLAY:
-                return (a->lastPlay < b->lastPlay);
-
-            default:
-                return (a->id < b->id);
-        }
+                return (a.artistL < b.artistL);
+            }
+            return (a.titleL < b.titleL);
+        case COL_SONGID:
+            return (a.songidL < b.songidL);
+        case COL_FILENAME:
+            return (a.filename.toLower() < b.filename.toLower());
+        case COL_DURATION:
+            return (a.duration < b.duration);
+        case COL_PLAYS:
+            return (a.plays < b.plays);
+        case COL_LASTPLAY:
+            return (a.lastPlay < b.lastPlay);
+
+        default:
+            return (a.id < b.id);
+    }
+}
+
+bool TableModelKaraokeSongs::songSortsBefore(const okj::KaraokeSong &a, const okj::KaraokeSong &b) const {
+    if (m_sortOrder == Qt::AscendingOrder)
+        return songLessThan(m_sortColumn, a, b);
+    return songLessThan(m_sortColumn, b, a);
+}
+
+void TableModelKaraokeSongs::sort(int column, Qt::SortOrder order) {
+    m_sortColumn = column;
+    m_sortOrder = order;
+    auto sortLambda = [&column](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) -> bool {
+        return songLessThan(column, *a, *b);
     };
 
     QApplication::setOverrideCursor(Qt::BusyCursor);
@@ -417,6 +477,7 @@ void TableModelKaraokeSongs::setSongDuration(const QString &path, unsigned int d
     if (it == m_allSongs.end())
         return;
     it->get()->duration = static_cast<int>(duration);
+    growColumnContentWidths(**it);
     int songId = it->get()->id;
     auto it2 = find_if(m_filteredSongs.begin(), m_filteredSongs.end(),
                        [&songId](const std::shared_ptr<okj::KaraokeSong> &song) {
@@ -429,7 +490,7 @@ void TableModelKaraokeSongs::setSongDuration(const QString &path, unsigned int d
 }
 
 void TableModelKaraokeSongs::markSongBad(QString path) {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE dbsongs SET discid='!!BAD!!' WHERE path == :path");
     query.bindValue(":path", path);
     query.exec();
@@ -459,7 +520,7 @@ TableModelKaraokeSongs::DeleteStatus TableModelKaraokeSongs::removeBadSong(QStri
         mediaFile = findCdgAudioFile(path);
     QFile file(path);
     if (file.remove()) {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare("DELETE FROM dbsongs WHERE path == :path");
         query.bindValue(":path", path);
         query.exec();
@@ -490,32 +551,14 @@ TableModelKaraokeSongs::DeleteStatus TableModelKaraokeSongs::removeBadSong(QStri
 }
 
 QString TableModelKaraokeSongs::findCdgAudioFile(const QString &path) {
-    m_logger->debug("{} findMatchingAudioFile({}) called", m_loggingPrefix, path.toStdString());
-    std::array<QString, 41> audioExtensions{
-            "mp3",
-            "ogg",
-            "wav",
-            "mov",
-            "flac",
-            "MP3",
-            "WAV",
-            "OGG",
-            "MOV",
-            "FLAC",
-            "Mp3","mP3",
-            "Wav","wAv","waV","WAv","wAV","WaV",
-            "Ogg","oGg","ogG","OGg","oGG","OgG",
-            "Mov","mOv","moV","MOv","mOV","MoV",
-            "Flac","fLac","flAc","flaC","FLac","FLAc",
-            "flAC","fLAC","FlaC", "FLaC", "FlAC"
-    };
-    QFileInfo cdgInfo(path);
-    for (const auto &ext : audioExtensions) {
-        QString testPath = cdgInfo.absolutePath() + QDir::separator() + cdgInfo.completeBaseName() + '.' + ext;
-        if (QFile::exists(testPath))
-            return testPath;
-    }
-    return {};
+    auto it = std::find_if(m_allSongs.begin(), m_allSongs.end(), [&path](const std::shared_ptr<okj::KaraokeSong> &song) {
+        return (song->path == path);
+    });
+    // The scan stores the companion audio path, only fall back to probing extensions if it's missing or stale
+    if (it != m_allSongs.end() && !it->get()->audioPath.isEmpty() && QFile::exists(it->get()->audioPath))
+        return it->get()->audioPath;
+    m_logger->debug("{} No stored companion audio for {}, probing for a matching audio file", m_loggingPrefix, path);
+    return findMatchingAudioFile(path);
 }
 
 int TableModelKaraokeSongs::addSong(okj::KaraokeSong song) {
@@ -524,9 +567,9 @@ int TableModelKaraokeSongs::addSong(okj::KaraokeSong song) {
         m_logger->debug("{} addSong() - Song at path already exists in the db:{}", m_loggingPrefix, song.path.toStdString());
         return songId;
     }
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare(
-            "INSERT INTO dbSongs (discid,artist,title,path,duration,filename,searchstring) VALUES(:songid, :artist, :title, :path, :duration, :filename, :searchString)");
+            "INSERT INTO dbSongs (discid,artist,title,path,duration,filename,searchstring,audiopath) VALUES(:songid, :artist, :title, :path, :duration, :filename, :searchString, :audioPath)");
     query.bindValue(":songid", song.songid);
     query.bindValue(":artist", song.artist);
     query.bindValue(":title", song.title);
@@ -534,6 +577,7 @@ int TableModelKaraokeSongs::addSong(okj::KaraokeSong song) {
     query.bindValue(":duration", song.duration);
     query.bindValue(":filename", song.filename);
     query.bindValue(":searchString", song.searchString);
+    query.bindValue(":audioPath", song.audioPath);
     query.exec();
     if (auto error = query.lastError(); error.type() != QSqlError::NoError) {
         m_logger->error("{} Error adding song to the database", m_loggingPrefix);
@@ -542,8 +586,300 @@ int TableModelKaraokeSongs::addSong(okj::KaraokeSong song) {
     } else {
         int lastInsertId = query.lastInsertId().toInt();
         song.id = lastInsertId;
-        m_allSongs.push_back(std::make_shared<okj::KaraokeSong>(song));
-        search(m_lastSearch);
+        insertSong(std::make_shared<okj::KaraokeSong>(song));
         return lastInsertId;
     }
 }
+
+std::vector<int> TableModelKaraokeSongs::addSongs(std::vector<okj::KaraokeSong> songs) {
+    m_logger->debug("{} addSongs() called with {} songs", m_loggingPrefix, songs.size());
+    std::vector<int> songIds(songs.size(), -1);
+    QHash<QString, int> idsByPath;
+    idsByPath.reserve(static_cast<int>(m_allSongs.size()));
+    for (const auto &song : m_allSongs)
+        idsByPath.insert(song->path, song->id);
+    SongList added;
+    InstrumentedSqlQuery query;
+    query.exec("BEGIN TRANSACTION");
+    query.prepare(
+            "INSERT INTO dbSongs (discid,artist,title,path,duration,filename,searchstring,audiopath) VALUES(:songid, :artist, :title, :path, :duration, :filename, :searchString, :audioPath)");
+    // m_allSongs is still empty while the catalog loads in the background, the db has the final say on duplicates
+    InstrumentedSqlQuery idQuery;
+    idQuery.prepare("SELECT songid FROM dbsongs WHERE path = :path");
+    for (size_t i = 0; i < songs.size(); i++) {
+        auto &song = songs.at(i);
+        if (auto it = idsByPath.constFind(song.path); it != idsByPath.constEnd()) {
+            songIds[i] = it.value();
+            continue;
+        }
+        query.bindValue(":songid", song.songid);
+        query.bindValue(":artist", song.artist);
+        query.bindValue(":title", song.title);
+        query.bindValue(":path", song.path);
+        query.bindValue(":duration", song.duration);
+        query.bindValue(":filename", song.filename);
+        query.bindValue(":searchString", song.searchString);
+        query.bindValue(":audioPath", song.audioPath);
+        query.exec();
+        if (auto error = query.lastError(); error.type() != QSqlError::NoError) {
+            idQuery.bindValue(":path", song.path);
+            idQuery.exec();
+            if (idQuery.first()) {
+                songIds[i] = idQuery.value(0).toInt();
+                idsByPath.insert(song.path, songIds[i]);
+                continue;
+            }
+            m_logger->error("{} Error adding song to the database: {}", m_loggingPrefix, song.path);
+            m_logger->error("{} Database error: {}", m_loggingPrefix, error.text().toStdString());
+            continue;
+        }
+        song.id = query.lastInsertId().toInt();
+        songIds[i] = song.id;
+        idsByPath.insert(song.path, song.id);
+        added.emplace_back(std::make_shared<okj::KaraokeSong>(song));
+    }
+    query.exec("COMMIT");
+    if (m_loadWatcher.isRunning())
+        m_reloadAfterLoad = true;
+    if (added.size() == 1) {
+        insertSong(added.front());
+    } else if (!added.empty()) {
+        auto sortsBefore = [&](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) {
+            return songSortsBefore(*a, *b);
+        };
+        std::sort(added.begin(), added.end(), sortsBefore);
+        auto oldSize = m_allSongs.size();
+        m_allSongs.insert(m_allSongs.end(), added.begin(), added.end());
+        std::inplace_merge(m_allSongs.begin(), m_allSongs.begin() + static_cast<long>(oldSize), m_allSongs.end(), sortsBefore);
+        for (const auto &song : added)
+            growColumnContentWidths(*song);
+        searchExec();
+    }
+    return songIds;
+}
+
+int TableModelKaraokeSongs::columnContentWidth(const int column) const {
+    if (column < 0 || column >= static_cast<int>(m_colContentWidths.size()))
+        return 0;
+    return m_colContentWidths.at(column);
+}
+
+void TableModelKaraokeSongs::updateColumnContentWidths() {
+    // Only the columns that get sized to their contents are tracked, artist and title just take up the remaining space
+    m_colContentWidths.fill(0);
+    int maxDuration{0};
+    int maxPlays{0};
+    // Character count says little about the rendered width in a proportional font, so every distinct songid gets
+    // measured, discs with many tracks sharing an id only cost one measurement
+    QSet<QString> songIds;
+    songIds.reserve(static_cast<int>(m_allSongs.size()));
+    for (const auto &song : m_allSongs) {
+        maxDuration = std::max(maxDuration, song->duration);
+        maxPlays = std::max(maxPlays, song->plays);
+        songIds.insert(song->songid);
+    }
+    for (const auto &songId : songIds)
+        m_colContentWidths[COL_SONGID] = std::max(m_colContentWidths[COL_SONGID], m_itemFontMetrics.size(Qt::TextSingleLine, songId).width());
+    QLocale locale;
+    auto lastPlayFormat = locale.dateTimeFormat(QLocale::ShortFormat);
+    for (const auto &song : m_allSongs) {
+        if (song->plays > 0)
+            m_colContentWidths[COL_LASTPLAY] = std::max(m_colContentWidths[COL_LASTPLAY], m_itemFontMetrics.size(Qt::TextSingleLine, song->lastPlay.toString(lastPlayFormat)).width());
+    }
+    if (maxDuration > 0)
+        m_colContentWidths[COL_DURATION] = m_itemFontMetrics.size(Qt::TextSingleLine, QTime(0, 0, 0, 0).addSecs(maxDuration / 1000).toString("m:ss")).width();
+    m_colContentWidths[COL_PLAYS] = m_itemFontMetrics.size(Qt::TextSingleLine, QString::number(maxPlays)).width();
+}
+
+void TableModelKaraokeSongs::growColumnContentWidths(const okj::KaraokeSong &song) {
+    QLocale locale;
+    m_colContentWidths[COL_SONGID] = std::max(m_colContentWidths[COL_SONGID], m_itemFontMetrics.size(Qt::TextSingleLine, song.songid).width());
+    m_colContentWidths[COL_PLAYS] = std::max(m_colContentWidths[COL_PLAYS], m_itemFontMetrics.size(Qt::TextSingleLine, QString::number(song.plays)).width());
+    if (song.duration > 0)
+        m_colContentWidths[COL_DURATION] = std::max(m_colContentWidths[COL_DURATION], m_itemFontMetrics.size(Qt::TextSingleLine, QTime(0, 0, 0, 0).addSecs(song.duration / 1000).toString("m:ss")).width());
+    if (song.lastPlay.isValid())
+        m_colContentWidths[COL_LASTPLAY] = std::max(m_colContentWidths[COL_LASTPLAY], m_itemFontMetrics.size(Qt::TextSingleLine, song.lastPlay.toString(locale.dateTimeFormat(QLocale::ShortFormat))).width());
+}
+
+okj::KaraokeSong TableModelKaraokeSongs::songFromQuery(const QSqlQuery &query) {
+    // Expects the column order used by loadData()
+    return okj::KaraokeSong{
+            query.value(0).toInt(),
+            query.value(1).toString(),
+            query.value(1).toString().toLower(),
+            query.value(2).toString(),
+            query.value(2).toString().toLower(),
+            query.value(3).toString(),
+            query.value(3).toString().toLower(),
+            query.value(4).toInt(),
+            query.value(5).toString(),
+            query.value(6).toString(),
+            query.value(7).toString().replace('&', " and ").toLower(),
+            query.value(8).toInt(),
+            query.value(9).toDateTime(),
+            (query.value(3).toString() == "!!BAD!!"),
+            (query.value(3).toString() == "!!DROPPED!!"),
+            query.value(10).toString()
+    };
+}
+
+std::vector<okj::KaraokeSong> TableModelKaraokeSongs::loadSongsById(const QVector<int> &songIds) {
+    std::vector<okj::KaraokeSong> songs;
+    songs.reserve(songIds.size());
+    InstrumentedSqlQuery query;
+    // Stay well under SQLite's host parameter limit
+    const int chunkSize{500};
+    for (int start = 0; start < songIds.size(); start += chunkSize) {
+        QStringList ids;
+        for (int i = start; i < std::min(start + chunkSize, static_cast<int>(songIds.size())); i++)
+            ids.append(QString::number(songIds.at(i)));
+        query.exec("SELECT songid,artist,title,discid,duration,filename,path,searchstring,plays,lastplay,audiopath FROM dbsongs "
+                   "WHERE songid IN (" + ids.join(',') + ")");
+        if (auto error = query.lastError(); error.type() != QSqlError::NoError)
+            m_logger->error("{} DB error: {}", m_loggingPrefix, error.text().toStdString());
+        while (query.next())
+            songs.emplace_back(songFromQuery(query));
+    }
+    return songs;
+}
+
+void TableModelKaraokeSongs::applySongChanges(const QVector<int> &addedIds, const QVector<int> &updatedIds,
+                                              const QVector<int> &removedIds) {
+    m_logger->debug("{} Applying song changes - added: {} updated: {} removed: {}", m_loggingPrefix, addedIds.size(),
+                    updatedIds.size(), removedIds.size());
+    if (m_loadWatcher.isRunning()) {
+        m_reloadAfterLoad = true;
+        return;
+    }
+    if (addedIds.size() + updatedIds.size() + removedIds.size() > m_maxIncrementalChanges) {
+        // Row by row inserts get more expensive than a full reload once a scan touches a big chunk of the library
+        loadData();
+        if (m_sortColumn > -1)
+            sort(m_sortColumn, m_sortOrder);
+        return;
+    }
+    // A song reported as added may already be in the model (re-added dropped song), so both lists go through the
+    // same path
+    auto songs = loadSongsById(addedIds + updatedIds);
+    if (removedIds.size() + songs.size() > 1) {
+        mergeSongChanges(removedIds, songs);
+        return;
+    }
+    // A single edit keeps to row level changes so the view holds on to its selection
+    for (auto songId : removedIds)
+        removeSong(songId);
+    for (const auto &song : songs)
+        updateSong(song);
+}
+
+void TableModelKaraokeSongs::mergeSongChanges(const QVector<int> &removedIds, const std::vector<okj::KaraokeSong> &changedSongs) {
+    // One pass over the catalog for the whole batch: removed songs are dropped, changed ones pulled out and
+    // updated, then everything that moved is sorted and merged back in like addSongs() does
+    QSet<int> removed;
+    removed.reserve(removedIds.size());
+    for (auto songId : removedIds)
+        removed.insert(songId);
+    QHash<int, const okj::KaraokeSong*> changed;
+    changed.reserve(static_cast<int>(changedSongs.size()));
+    for (const auto &song : changedSongs)
+        changed.insert(song.id, &song);
+    SongList moved;
+    moved.reserve(changedSongs.size());
+    auto keptEnd = std::remove_if(m_allSongs.begin(), m_allSongs.end(), [&](const std::shared_ptr<okj::KaraokeSong> &song) {
+        if (removed.contains(song->id))
+            return true;
+        auto it = changed.find(song->id);
+        if (it == changed.end())
+            return false;
+        *song = *it.value();
+        moved.emplace_back(song);
+        changed.erase(it);
+        return true;
+    });
+    m_allSongs.erase(keptEnd, m_allSongs.end());
+    // Whatever wasn't found in the model is new
+    for (const auto *song : qAsConst(changed))
+        moved.emplace_back(std::make_shared<okj::KaraokeSong>(*song));
+    auto sortsBefore = [&](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) {
+        return songSortsBefore(*a, *b);
+    };
+    std::sort(moved.begin(), moved.end(), sortsBefore);
+    auto oldSize = m_allSongs.size();
+    m_allSongs.insert(m_allSongs.end(), moved.begin(), moved.end());
+    std::inplace_merge(m_allSongs.begin(), m_allSongs.begin() + static_cast<long>(oldSize), m_allSongs.end(), sortsBefore);
+    for (const auto &song : moved)
+        growColumnContentWidths(*song);
+    searchExec();
+}
+
+void TableModelKaraokeSongs::insertSong(const std::shared_ptr<okj::KaraokeSong> &song) {
+    auto sortsBefore = [&](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) {
+        return songSortsBefore(*a, *b);
+    };
+    m_allSongs.insert(std::upper_bound(m_allSongs.begin(), m_allSongs.end(), song, sortsBefore), song);
+    growColumnContentWidths(*song);
+    if (!matchesSearch(*song, searchNeedles()))
+        return;
+    auto pos = std::upper_bound(m_filteredSongs.begin(), m_filteredSongs.end(), song, sortsBefore);
+    int row = static_cast<int>(std::distance(m_filteredSongs.begin(), pos));
+    beginInsertRows(QModelIndex(), row, row);
+    m_filteredSongs.insert(pos, song);
+    endInsertRows();
+}
+
+void TableModelKaraokeSongs::updateSong(const okj::KaraokeSong &updatedSong) {
+    auto byId = [&updatedSong](const std::shared_ptr<okj::KaraokeSong> &song) {
+        return (song->id == updatedSong.id);
+    };
+    auto allIt = std::find_if(m_allSongs.begin(), m_allSongs.end(), byId);
+    if (allIt == m_allSongs.end()) {
+        insertSong(std::make_shared<okj::KaraokeSong>(updatedSong));
+        return;
+    }
+    auto song = *allIt;
+    m_allSongs.erase(allIt);
+    *song = updatedSong;
+    auto sortsBefore = [&](const std::shared_ptr<okj::KaraokeSong> &a, const std::shared_ptr<okj::KaraokeSong> &b) {
+        return songSortsBefore(*a, *b);
+    };
+    m_allSongs.insert(std::upper_bound(m_allSongs.begin(), m_allSongs.end(), song, sortsBefore), song);
+    growColumnContentWidths(*song);
+
+    bool visible = matchesSearch(*song, searchNeedles());
+    auto filteredIt = std::find_if(m_filteredSongs.begin(), m_filteredSongs.end(), byId);
+    if (filteredIt != m_filteredSongs.end()) {
+        int row = static_cast<int>(std::distance(m_filteredSongs.begin(), filteredIt));
+        // If the edit didn't move the song in the current sort just refresh the row so the view keeps its selection
+        bool inPlace = visible
+                && (row == 0 || !songSortsBefore(*song, *m_filteredSongs.at(row - 1)))
+                && (row + 1 == static_cast<int>(m_filteredSongs.size()) || !songSortsBefore(*m_filteredSongs.at(row + 1), *song));
+        if (inPlace) {
+            emit dataChanged(index(row, 0), index(row, columnCount(QModelIndex()) - 1));
+            return;
+        }
+        beginRemoveRows(QModelIndex(), row, row);
+        m_filteredSongs.erase(filteredIt);
+        endRemoveRows();
+    }
+    if (!visible)
+        return;
+    auto pos = std::upper_bound(m_filteredSongs.begin(), m_filteredSongs.end(), song, sortsBefore);
+    int row = static_cast<int>(std::distance(m_filteredSongs.begin(), pos));
+    beginInsertRows(QModelIndex(), row, row);
+    m_filteredSongs.insert(pos, song);
+    endInsertRows();
+}
+
+void TableModelKaraokeSongs::removeSong(const int songId) {
+    auto byId = [&songId](const std::shared_ptr<okj::KaraokeSong> &song) {
+        return (song->id == songId);
+    };
+    auto filteredIt = std::find_if(m_filteredSongs.begin(), m_filteredSongs.end(), byId);
+    if (filteredIt != m_filteredSongs.end()) {
+        int row = static_cast<int>(std::distance(m_filteredSongs.begin(), filteredIt));
+        beginRemoveRows(QModelIndex(), row, row);
+        m_filteredSongs.erase(filteredIt);
+        endRemoveRows();
+    }
+    m_allSongs.erase(std::remove_if(m_allSongs.begin(), m_allSongs.end(), byId), m_allSongs.end());
+}
@@ -5,7 +5,13 @@
 #include <QDateTime>
 #include <QImage>
 #include <memory>
+#include <array>
 #include <QTimer>
+#include <QSqlQuery>
+#include <QSqlDatabase>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <optional>
 #include "settings.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/async_logger.h>
@@ -46,17 +52,26 @@ public:
     [[nodiscard]] Qt::ItemFlags flags(const QModelIndex &index) const override;
     [[nodiscard]] QVariant data(const QModelIndex &index, int role) const override;
     void loadData();
+    // Reads the catalog on a worker thread with its own db connection and swaps it in when done
+    void loadDataAsync();
+    [[nodiscard]] bool isLoading() const { return m_loadWatcher.isRunning(); }
     void sort(int column, Qt::SortOrder order) override;
     void search(const QString &searchString);
     void setSearchType(SearchType type);
     int getIdForPath(const QString &path);
     QString getPath(int songId);
     void updateSongHistory(int songId);
-    okj::KaraokeSong &getSong(int songId);
+    // Falls back to the db while the catalog is still loading, nullopt if the song doesn't exist at all
+    std::optional<okj::KaraokeSong> getSong(int songId);
     void markSongBad(QString path);
     DeleteStatus removeBadSong(QString path);
     QString findCdgAudioFile(const QString& path);
     int addSong(okj::KaraokeSong song);
+    // Adds all songs not already in the db in one transaction and refreshes the view once.
+    // Returns the song id for each input song in order, -1 where the insert failed.
+    std::vector<int> addSongs(std::vector<okj::KaraokeSong> songs);
+    void applySongChanges(const QVector<int> &addedIds, const QVector<int> &updatedIds, const QVector<int> &removedIds);
+    [[nodiscard]] int columnContentWidth(int column) const;
 
 
 private:
@@ -70,20 +85,47 @@ private:
     QImage m_iconZip;
     QImage m_iconVid;
     SearchType m_searchType{SearchType::SEARCH_TYPE_ALL};
+    int m_sortColumn{-1};
+    Qt::SortOrder m_sortOrder{Qt::AscendingOrder};
+    const int m_maxIncrementalChanges{2000};
     Settings m_settings;
     QFont m_itemFont;
     int m_itemHeight{20};
     QFont m_headerFont;
     QFontMetrics m_itemFontMetrics{m_settings.applicationFont()};
     QTimer searchTimer{this};
+    std::array<int, 8> m_colContentWidths{};
+    using SongList = std::vector<std::shared_ptr<okj::KaraokeSong>>;
+    QFutureWatcher<std::optional<SongList>> m_loadWatcher;
+    QElapsedTimer m_loadTimer;
+    bool m_reloadAfterLoad{false};
 
     void searchExec();
+    void filterSongs();
+    static SongList fetchAllSongs(const QSqlDatabase &db);
+    void setAllSongs(SongList songs);
+    void asyncLoadFinished();
+    [[nodiscard]] QStringList searchNeedles() const;
+    [[nodiscard]] bool matchesSearch(const okj::KaraokeSong &song, const QStringList &needles) const;
+    [[nodiscard]] static bool songLessThan(int column, const okj::KaraokeSong &a, const okj::KaraokeSong &b);
+    [[nodiscard]] bool songSortsBefore(const okj::KaraokeSong &a, const okj::KaraokeSong &b) const;
+    [[nodiscard]] static okj::KaraokeSong songFromQuery(const QSqlQuery &query);
+    std::vector<okj::KaraokeSong> loadSongsById(const QVector<int> &songIds);
+    void mergeSongChanges(const QVector<int> &removedIds, const std::vector<okj::KaraokeSong> &changedSongs);
+    void insertSong(const std::shared_ptr<okj::KaraokeSong> &song);
+    void updateSong(const okj::KaraokeSong &updatedSong);
+    void removeSong(int songId);
+    void updateColumnContentWidths();
+    void growColumnContentWidths(const okj::KaraokeSong &song);
     static QVariant getColumnName(int section) ;
     [[nodiscard]] QVariant getColumnSizeHint(int section) const;
     [[nodiscard]] QVariant getItemDisplayData(const QModelIndex &index) const;
     [[nodiscard]] static QVariant getColumnTextAlignmentHint(int column) ;
     [[nodiscard]] QVariant getColumnDecorationRole(const QModelIndex &index) const;
 
+signals:
+    void dataLoaded();
+
 public slots:
     void setSongDuration(const QString &path, unsigned int duration);
     void resizeIconsForFont(const QFont &font);
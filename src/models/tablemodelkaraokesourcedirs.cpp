@@ -187,6 +187,19 @@ void TableModelKaraokeSourceDirs::delSourceDir(int index)
     layoutChanged();
 }
 
+void TableModelKaraokeSourceDirs::setSourceDirPattern(int index, int pattern, int customPattern)
+{
+    QSqlQuery query;
+    query.prepare("UPDATE sourceDirs SET pattern = :pattern, custompattern = :custompattern WHERE ROWID == :rowid");
+    query.bindValue(":pattern", pattern);
+    query.bindValue(":custompattern", customPattern);
+    query.bindValue(":rowid", mydata.at(index).getIndex());
+    query.exec();
+    mydata[index].setPattern(static_cast<SourceDir::NamingPattern>(pattern));
+    mydata[index].setCustomPattern(customPattern);
+    emit dataChanged(this->index(index, PATTERN), this->index(index, PATTERN));
+}
+
 int TableModelKaraokeSourceDirs::size()
 {
     return mydata.size();
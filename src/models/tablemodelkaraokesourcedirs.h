@@ -82,6 +82,7 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const;
     void addSourceDir(QString dirpath, int pattern, int customPattern);
     void delSourceDir(int index);
+    void setSourceDirPattern(int index, int pattern, int customPattern);
     int size();
     void loadFromDB();
     QSqlDatabase *getDBObject() const;
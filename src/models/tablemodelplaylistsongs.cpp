@@ -179,9 +179,12 @@ void TableModelPlaylistSongs::moveSong(const int oldPosition, const int newPosit
     emit layoutChanged();
 }
 
-void TableModelPlaylistSongs::addSong(const int songId) {
+bool TableModelPlaylistSongs::addSong(const int songId) {
+    auto song = m_breakSongsModel.getSong(songId);
+    if (!song)
+        return false;
+    const auto &breakSong = *song;
     emit layoutAboutToBeChanged();
-    auto breakSong = m_breakSongsModel.getSong(songId);
     QSqlQuery query;
     query.prepare("INSERT INTO bmplsongs (playlist,position,artist,title,filename,duration,path)"
                   "VALUES(:playlist,:position,:bmsongid,:bmsongid,:bmsongid,:bmsongid,:bmsongid)");
@@ -201,10 +204,12 @@ void TableModelPlaylistSongs::addSong(const int songId) {
             breakSong.duration
     });
     emit layoutChanged();
+    return true;
 }
 
 void TableModelPlaylistSongs::insertSong(const int songId, const int position) {
-    addSong(songId);
+    if (!addSong(songId))
+        return;
     moveSong(static_cast<int>(m_songs.size()) - 1, position);
 }
 
@@ -65,7 +65,8 @@ public:
     [[nodiscard]] int currentPosition() const { return m_currentPosition; }
     void savePlaylistChanges();
     void moveSong(int oldPosition, int newPosition);
-    void addSong(int songId);
+    // Returns false if the song isn't in the break music catalog
+    bool addSong(int songId);
     void insertSong(int songId, int position);
     void deleteSong(int position);
     [[nodiscard]] int currentPlaylist() const;
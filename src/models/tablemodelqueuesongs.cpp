@@ -1,6 +1,7 @@
 #include "tablemodelqueuesongs.h"
 
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 #include <QSqlError>
 #include <QTime>
 #include <QMimeData>
@@ -9,6 +10,7 @@
 #include <QUrl>
 #include <QSvgRenderer>
 #include <spdlog/fmt/ostr.h>
+#include <algorithm>
 
 std::ostream & operator<<(std::ostream& os, const QString& s);
 
@@ -139,7 +141,7 @@ void TableModelQueueSongs::loadSinger(const int singerId) {
     m_songs.clear();
     m_songs.shrink_to_fit();
     m_curSingerId = singerId;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("SELECT queuesongs.qsongid, queuesongs.singer, queuesongs.song, queuesongs.played, "
                   "queuesongs.keychg, queuesongs.position, rotationsingers.name, dbsongs.artist, "
                   "dbsongs.title, dbsongs.discid, dbsongs.duration, dbsongs.path FROM queuesongs "
@@ -167,6 +169,7 @@ void TableModelQueueSongs::loadSinger(const int singerId) {
                 query.value(11).toString()
         });
     }
+    updateColumnContentWidths();
     emit layoutChanged();
 }
 
@@ -231,8 +234,11 @@ void TableModelQueueSongs::moveSongId(const int songId, const int newPosition) {
 }
 
 int TableModelQueueSongs::add(const int songId) {
-    okj::KaraokeSong ksong = m_karaokeSongsModel.getSong(songId);
-    QSqlQuery query;
+    auto song = m_karaokeSongsModel.getSong(songId);
+    if (!song)
+        return -1;
+    const auto &ksong = *song;
+    InstrumentedSqlQuery query;
     query.prepare("INSERT INTO queuesongs (singer,song,artist,title,discid,path,keychg,played,position) "
                   "VALUES (:singerId,:songId,:songId,:songId,:songId,:songId,:key,:played,:position)");
     query.bindValue(":singerId", m_curSingerId);
@@ -256,16 +262,74 @@ int TableModelQueueSongs::add(const int songId) {
             ksong.duration,
             ksong.path
     });
+    updateColumnContentWidths();
     emit layoutChanged();
     emit queueModified(m_curSingerId);
     return queueSongId;
 }
 
 void TableModelQueueSongs::insert(const int songId, const int position) {
-    add(songId);
+    if (add(songId) < 0)
+        return;
     move(static_cast<int>(m_songs.size()) - 1, position);
 }
 
+void TableModelQueueSongs::insertSongs(const std::vector<int> &songIds, int position) {
+    std::vector<okj::KaraokeSong> ksongs;
+    ksongs.reserve(songIds.size());
+    for (auto songId : songIds) {
+        if (auto song = m_karaokeSongsModel.getSong(songId))
+            ksongs.emplace_back(std::move(*song));
+    }
+    if (ksongs.empty())
+        return;
+    position = std::clamp(position, 0, static_cast<int>(m_songs.size()));
+    auto count = static_cast<int>(ksongs.size());
+    std::vector<okj::QueueSong> newSongs;
+    newSongs.reserve(songIds.size());
+    InstrumentedSqlQuery query;
+    query.exec("BEGIN TRANSACTION");
+    query.prepare("UPDATE queuesongs SET position = position + :count WHERE singer = :singerId AND position >= :position");
+    query.bindValue(":count", count);
+    query.bindValue(":singerId", m_curSingerId);
+    query.bindValue(":position", position);
+    query.exec();
+    query.prepare("INSERT INTO queuesongs (singer,song,artist,title,discid,path,keychg,played,position) "
+                  "VALUES (:singerId,:songId,:songId,:songId,:songId,:songId,:key,:played,:position)");
+    for (int i = 0; i < count; i++) {
+        const auto &ksong = ksongs.at(i);
+        auto songId = ksong.id;
+        query.bindValue(":singerId", m_curSingerId);
+        query.bindValue(":songId", songId);
+        query.bindValue(":key", 0);
+        query.bindValue(":played", false);
+        query.bindValue(":position", position + i);
+        query.exec();
+        newSongs.emplace_back(okj::QueueSong{
+                query.lastInsertId().toInt(),
+                m_curSingerId,
+                songId,
+                false,
+                0,
+                position + i,
+                ksong.artist,
+                ksong.title,
+                ksong.songid,
+                ksong.duration,
+                ksong.path
+        });
+    }
+    query.exec("COMMIT");
+    beginInsertRows(QModelIndex(), position, position + count - 1);
+    std::for_each(m_songs.begin() + position, m_songs.end(), [&count](okj::QueueSong &song) {
+        song.position += count;
+    });
+    m_songs.insert(m_songs.begin() + position, newSongs.begin(), newSongs.end());
+    endInsertRows();
+    updateColumnContentWidths();
+    emit queueModified(m_curSingerId);
+}
+
 void TableModelQueueSongs::remove(const int songId) {
     emit layoutAboutToBeChanged();
     auto it = std::remove_if(m_songs.begin(), m_songs.end(), [&songId](okj::QueueSong &song) {
@@ -276,13 +340,14 @@ void TableModelQueueSongs::remove(const int songId) {
     std::for_each(m_songs.begin(), m_songs.end(), [&pos](okj::QueueSong &song) {
         song.position = pos++;
     });
+    updateColumnContentWidths();
     emit layoutChanged();
     commitChanges();
     emit queueModified(m_curSingerId);
 }
 
 void TableModelQueueSongs::setKey(const int songId, const int semitones) {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE queuesongs SET keychg = :key WHERE qsongid = :id");
     query.bindValue(":id", songId);
     query.bindValue(":key", semitones);
@@ -293,13 +358,14 @@ void TableModelQueueSongs::setKey(const int songId, const int semitones) {
     if (it == m_songs.end())
         return;
     it->keyChange = semitones;
+    updateColumnContentWidths();
     emit dataChanged(this->index(it->position, COL_KEY), this->index(it->position, COL_KEY),
                      QVector<int>{Qt::DisplayRole});
 }
 
 void TableModelQueueSongs::setPlayed(const int songId, const bool played) {
     m_logger->debug("{} Setting songId {} to played", m_loggingPrefix, songId);
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE queuesongs SET played = :played WHERE qsongid = :id");
     query.bindValue(":id", songId);
     query.bindValue(":played", played);
@@ -317,18 +383,19 @@ void TableModelQueueSongs::setPlayed(const int songId, const bool played) {
 
 void TableModelQueueSongs::removeAll() {
     emit layoutAboutToBeChanged();
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("DELETE FROM queuesongs WHERE singer = :singerId");
     query.bindValue(":singerId", m_curSingerId);
     query.exec();
     m_songs.clear();
     m_songs.shrink_to_fit();
+    updateColumnContentWidths();
     emit layoutChanged();
     emit queueModified(m_curSingerId);
 }
 
 void TableModelQueueSongs::commitChanges() {
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.exec("BEGIN TRANSACTION");
     query.prepare("DELETE FROM queuesongs WHERE singer = :singerId");
     query.bindValue(":singerId", m_curSingerId);
@@ -350,11 +417,13 @@ void TableModelQueueSongs::commitChanges() {
 void TableModelQueueSongs::songAddSlot(int songId, int singerId, int keyChg) {
     if (singerId == m_curSingerId) {
         int queueSongId = add(songId);
-        setKey(queueSongId, keyChg);
+        if (queueSongId >= 0)
+            setKey(queueSongId, keyChg);
     } else {
         int newPos{0};
-        okj::KaraokeSong ksong = m_karaokeSongsModel.getSong(songId);
-        QSqlQuery query;
+        if (!m_karaokeSongsModel.getSong(songId))
+            return;
+        InstrumentedSqlQuery query;
         query.prepare("SELECT COUNT(qsongid) FROM queuesongs WHERE singer = :singerId");
         query.bindValue(":singerId", singerId);
         query.exec();
@@ -538,9 +607,29 @@ void TableModelQueueSongs::setFont(const QFont &font) {
     m_itemFont = font;
     m_itemFontStrikeout = font;
     m_itemFontStrikeout.setStrikeOut(true);
+    m_itemFontMetrics = QFontMetrics(m_itemFont);
     m_itemHeight = m_itemFontMetrics.height() + 6;
     m_headerFont = font;
     m_headerFont.setBold(true);
+    updateColumnContentWidths();
+}
+
+int TableModelQueueSongs::columnContentWidth(const int column) const {
+    if (column < 0 || column >= static_cast<int>(m_colContentWidths.size()))
+        return 0;
+    return m_colContentWidths.at(column);
+}
+
+void TableModelQueueSongs::updateColumnContentWidths() {
+    m_colContentWidths.fill(0);
+    for (int row = 0; row < static_cast<int>(m_songs.size()); row++) {
+        for (auto column : {COL_SONGID, COL_KEY, COL_DURATION}) {
+            auto text = getItemDisplayRoleData(index(row, column)).toString();
+            if (text.isEmpty())
+                continue;
+            m_colContentWidths[column] = std::max(m_colContentWidths[column], m_itemFontMetrics.size(Qt::TextSingleLine, text).width());
+        }
+    }
 }
 
 QSize TableModelQueueSongs::getColumnSizeHint(int section) const {
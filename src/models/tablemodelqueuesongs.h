@@ -6,6 +6,7 @@
 #include <QModelIndex>
 #include <QPainter>
 #include <QUrl>
+#include <array>
 #include "tablemodelkaraokesongs.h"
 #include "settings.h"
 #include <spdlog/spdlog.h>
@@ -57,13 +58,17 @@ public:
     [[nodiscard]] int getKey(int songId);
     void move(int oldPosition, int newPosition);
     void moveSongId(int songId, int newPosition);
+    // Returns the new queue song id, -1 if the song isn't in the catalog
     int add(int songId);
     void insert(int songId, int position);
+    // Inserts the songs as one block starting at position with a single transaction and change notification
+    void insertSongs(const std::vector<int> &songIds, int position);
     void remove(int songId);
     void setKey(int songId, int semitones);
     void setPlayed(int qSongId, bool played = true);
     void removeAll();
     void commitChanges();
+    [[nodiscard]] int columnContentWidth(int column) const;
 
 private:
     std::string m_loggingPrefix{"[QueueSongsModel]"};
@@ -77,7 +82,9 @@ private:
     QFont m_headerFont;
     QFontMetrics m_itemFontMetrics{m_settings.applicationFont()};
     int m_itemHeight{20};
+    std::array<int, 8> m_colContentWidths{};
 
+    void updateColumnContentWidths();
     [[nodiscard]] QVariant getItemDisplayRoleData(const QModelIndex &index) const;
     [[nodiscard]] static QVariant getColumnTextAlignmentRoleData(int column);
     [[nodiscard]] static QString getColumnName(int section);
@@ -20,6 +20,7 @@
 
 #include "tablemodelrotation.h"
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 #include <QSqlError>
 #include <QDateTime>
 #include <QSvgRenderer>
@@ -166,6 +167,7 @@ QVariant TableModelRotation::getDisplayData(const QModelIndex &index) const {
 }
 
 QVariant TableModelRotation::getTooltipData(const QModelIndex &index) const {
+    SqlQueryStatsAction sqlStatsAction("Rotation tooltip");
     QString toolTipText;
     int totalWaitDuration = 0;
     const auto &singer = m_singers.at(index.row());
@@ -209,7 +211,7 @@ void TableModelRotation::loadData() {
     m_logger->debug("{} loading rotation data from DB on disk", m_loggingPrefix);
     emit layoutAboutToBeChanged();
     m_singers.clear();
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.exec("SELECT singerid,name,position,regular,addts FROM rotationsingers ORDER BY position");
     if (auto sqlError = query.lastError(); sqlError.type() != QSqlError::NoError)
         m_logger->error("{} TableModelRotation - SQL error on load: {}", m_loggingPrefix,
@@ -232,7 +234,7 @@ void TableModelRotation::commitChanges() {
     auto st = std::chrono::high_resolution_clock::now();
 
     m_logger->debug("{} Committing db changes to disk", m_loggingPrefix);
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.exec("BEGIN TRANSACTION");
     query.exec("DELETE FROM rotationsingers");
     query.prepare(
@@ -267,7 +269,7 @@ int TableModelRotation::singerAdd(const QString &name, const int positionHint) {
     m_logger->debug("{} Adding singer {} to rotation using positionHint {}", m_loggingPrefix, name, positionHint);
     auto curTs = QDateTime::currentDateTime();
     int addPos = static_cast<int>(m_singers.size());
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare(
             "INSERT INTO rotationsingers (name,position,regular,regularid,addts) VALUES(:name,:pos,:regular,:regularid,:addts)");
     query.bindValue(":name", name);
@@ -407,7 +409,7 @@ void TableModelRotation::singerSetName(const int singerId, const QString &newNam
     it->name = newName;
     emit dataChanged(this->index(it->position, COL_NAME), this->index(it->position, COL_NAME),
                      QVector<int>{Qt::DisplayRole});
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE rotationsingers SET name = :name WHERE singerid = :singerid");
     query.bindValue(":name", newName);
     query.bindValue(":singerid", singerId);
@@ -460,7 +462,7 @@ void TableModelRotation::singerSetRegular(const int singerId, const bool isRegul
     it->regular = isRegular;
     emit dataChanged(this->index(it->position, COL_REGULAR), this->index(it->position, COL_REGULAR),
                      QVector<int>{Qt::DisplayRole});
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.prepare("UPDATE rotationsingers SET regular = :regular WHERE singerid = :singerid");
     query.bindValue(":regular", isRegular);
     query.bindValue(":singerid", singerId);
@@ -498,7 +500,7 @@ QStringList TableModelRotation::singers() const {
 
 QStringList TableModelRotation::historySingers() const {
     QStringList names;
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.exec("SELECT name FROM historySingers");
     if (auto lastError = query.lastError(); lastError.type() != QSqlError::NoError)
         m_logger->error("{} DB error! Unable to read history singers data from the db on disk! Error: {}",
@@ -520,7 +522,7 @@ int TableModelRotation::rotationDuration() const {
 void TableModelRotation::clearRotation() {
     m_logger->debug("{} Clearing rotation", m_loggingPrefix);
     emit layoutAboutToBeChanged();
-    QSqlQuery query;
+    InstrumentedSqlQuery query;
     query.exec("DELETE from queuesongs");
     if (auto lastError = query.lastError(); lastError.type() != QSqlError::NoError)
         m_logger->error("{} DB error! Error occurred while clearing the queuesongs db table on disk! Error: {}",
@@ -23,7 +23,6 @@
 #include <QFile>
 #include <QBuffer>
 #include <QTemporaryDir>
-#include "src/miniz/miniz.h"
 #ifdef Q_OS_WIN
 #include <io.h>
 #endif
@@ -32,22 +31,49 @@ MzArchive::MzArchive(const QString &ArchiveFile, QObject *parent) : QObject(pare
 {
     archiveFile = ArchiveFile;
     oka.setArchiveFile(archiveFile);
-    audioExtensions.append(".mp3");
-    audioExtensions.append(".wav");
-    audioExtensions.append(".ogg");
-    audioExtensions.append(".mov");
     m_logger = spdlog::get("logger");
 }
 
 MzArchive::MzArchive(QObject *parent) : QObject(parent)
 {
-    audioExtensions.append(".mp3");
-    audioExtensions.append(".wav");
-    audioExtensions.append(".ogg");
-    audioExtensions.append(".mov");
     m_logger = spdlog::get("logger");
 }
 
+const QStringList &MzArchive::audioExtensions()
+{
+    static const QStringList extensions{".mp3", ".wav", ".ogg", ".mov"};
+    return extensions;
+}
+
+MzArchive::KaraokeMembers MzArchive::findKaraokeMembers(mz_zip_archive *archive)
+{
+    KaraokeMembers members;
+    unsigned int files = mz_zip_reader_get_num_files(archive);
+    for (unsigned int i = 0; i < files && !members.complete(); i++)
+    {
+        mz_zip_archive_file_stat fStat;
+        if (!mz_zip_reader_file_stat(archive, i, &fStat))
+            continue;
+        QString fileName = fStat.m_filename;
+        if (fileName.endsWith(".cdg", Qt::CaseInsensitive))
+        {
+            members.cdgIndex = static_cast<int>(fStat.m_file_index);
+            members.cdgStat = fStat;
+            continue;
+        }
+        for (const auto &ext : audioExtensions())
+        {
+            if (fileName.endsWith(ext, Qt::CaseInsensitive))
+            {
+                members.audioIndex = static_cast<int>(fStat.m_file_index);
+                members.audioExtension = ext;
+                members.audioStat = fStat;
+            }
+        }
+    }
+    return members;
+}
+
 int MzArchive::getSongDuration()
 {
     if (findCDG())
@@ -223,7 +249,6 @@ bool MzArchive::findEntries()
         return true;
     mz_zip_archive archive;
     memset(&archive, 0, sizeof(archive));
-    mz_zip_archive_file_stat fStat;
 
     QFile zipFile(archiveFile);
     if (!zipFile.open(QIODevice::ReadOnly))
@@ -238,44 +263,28 @@ bool MzArchive::findEntries()
         m_logger->warn("{} Error opening zip file!", m_loggingPrefix);
         return false;
     }
-    unsigned int files = mz_zip_reader_get_num_files(&archive);
-    for (unsigned int i=0; i < files; i++)
+    auto members = findKaraokeMembers(&archive);
+    mz_zip_reader_end(&archive);
+    if (members.cdgIndex >= 0)
     {
-        if (mz_zip_reader_file_stat(&archive, i, &fStat))
-        {
-            QString fileName = fStat.m_filename;
-            if (fileName.endsWith(".cdg",Qt::CaseInsensitive))
-            {
-                m_cdgFileIndex = fStat.m_file_index;
-                m_cdgSize = fStat.m_uncomp_size;
-                m_cdgSupportedCompression = fStat.m_is_supported;
-                m_cdgFound = true;
-            }
-            else
-            {
-                for (int e=0; e < audioExtensions.size(); e++)
-                {
-                    if (fileName.endsWith(audioExtensions.at(e), Qt::CaseInsensitive))
-                    {
-                        m_audioFileIndex = fStat.m_file_index;
-                        audioExt = audioExtensions.at(e);
-                        m_audioSize = fStat.m_uncomp_size;
-                        m_audioSupportedCompression = fStat.m_is_supported;
-                        m_audioFound = true;
-                    }
-                }
-            }
-            if (m_audioFound && m_cdgFound && m_cdgSupportedCompression && m_audioSupportedCompression)
-            {
-                mz_zip_reader_end(&archive);
-                return true;
-            }
-            else if (m_audioFound && m_cdgFound && (!m_cdgSupportedCompression || !m_audioSupportedCompression))
-                return oka.isValidKaraokeFile();
-        }
+        m_cdgFileIndex = members.cdgStat.m_file_index;
+        m_cdgSize = static_cast<int>(members.cdgStat.m_uncomp_size);
+        m_cdgSupportedCompression = members.cdgStat.m_is_supported;
+        m_cdgFound = true;
     }
-    mz_zip_reader_end(&archive);
-    return false;
+    if (members.audioIndex >= 0)
+    {
+        m_audioFileIndex = members.audioStat.m_file_index;
+        audioExt = members.audioExtension;
+        m_audioSize = static_cast<unsigned int>(members.audioStat.m_uncomp_size);
+        m_audioSupportedCompression = members.audioStat.m_is_supported;
+        m_audioFound = true;
+    }
+    if (!members.complete())
+        return false;
+    if (m_cdgSupportedCompression && m_audioSupportedCompression)
+        return true;
+    return oka.isValidKaraokeFile();
 }
 
 
@@ -25,6 +25,7 @@
 #include <QObject>
 #include <QStringList>
 #include <okarchive.h>
+#include "src/miniz/miniz.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/async_logger.h>
 #include <spdlog/fmt/ostr.h>
@@ -36,6 +37,20 @@ class MzArchive : public QObject
 {
     Q_OBJECT
 public:
+    // The cdg and audio members that get played.  Entries are taken in central directory order and the search stops
+    // at the first complete pair, so trailing junk like __MACOSX/._Song.cdg never replaces the real members.
+    // Anything else that rewrites or checks archives has to pick members through this to act on what actually plays.
+    struct KaraokeMembers {
+        int cdgIndex{-1};
+        int audioIndex{-1};
+        QString audioExtension;
+        mz_zip_archive_file_stat cdgStat{};
+        mz_zip_archive_file_stat audioStat{};
+        [[nodiscard]] bool complete() const { return cdgIndex >= 0 && audioIndex >= 0; }
+    };
+    static KaraokeMembers findKaraokeMembers(mz_zip_archive *archive);
+    static const QStringList &audioExtensions();
+
     explicit MzArchive(const QString &ArchiveFile, QObject *parent = nullptr);
     explicit MzArchive(QObject *parent = nullptr);
     int getSongDuration();
@@ -63,7 +78,6 @@ private:
     bool m_cdgFound{false};
     bool m_audioFound{false};
     bool findEntries();
-    QStringList audioExtensions;
     OkArchive oka;
     std::string m_loggingPrefix{"[MZArchive]"};
     std::shared_ptr<spdlog::logger> m_logger;
@@ -7,10 +7,11 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
-#include <QSqlQuery>
+#include <QSqlDatabase>
 #include <QMessageBox>
 #include <QPushButton>
 #include "idledetect.h"
+#include "songbookuploader.h"
 
 extern IdleDetect *filter;
 
@@ -28,6 +29,7 @@ OKJSongbookAPI::OKJSongbookAPI(QObject *parent) : QObject(parent)
     delayErrorEmitted = false;
     connectionReset = false;
     cancelUpdate = false;
+    updateFailed = false;
     updateInProgress = false;
     serial = 0;
     entitledSystems = 1;
@@ -161,98 +163,20 @@ void OKJSongbookAPI::clearRequests()
 void OKJSongbookAPI::updateSongDb()
 {
     cancelUpdate = false;
+    updateFailed = false;
     updateInProgress = true;
     emit remoteSongDbUpdateStart();
-    int songsPerDoc = 1000;
-    QList<QJsonDocument> jsonDocs;
-    QSqlQuery query;
-    int numEntries = 0;
-    if (cancelUpdate)
-        return;
-    if (query.exec("SELECT COUNT(DISTINCT artist||title) FROM dbsongs WHERE discid != '!!DROPPED!!' AND discid != '!!BAD!!'"))
-    {
-        if (query.next())
-            numEntries = query.value(0).toInt();
-    }
-    if (cancelUpdate)
-        return;
-    if (query.exec("SELECT DISTINCT artist,title FROM dbsongs WHERE discid != '!!DROPPED!!' AND discid != '!!BAD!!' ORDER BY artist ASC, title ASC"))
-    {
-        if (cancelUpdate)
-            return;
-        bool done = false;
-        int numDocs = numEntries / songsPerDoc;
-        if (numEntries % songsPerDoc > 0)
-            numDocs++;
-        emit remoteSongDbUpdateNumDocs(numDocs);
-        int docs = 0;
-        while (!done)
-        {
-            if (cancelUpdate)
-                return;
-            QApplication::processEvents();
-            QJsonArray songsArray;
-            int count = 0;
-            while ((query.next()) && (count < songsPerDoc))
-            {
-                if (cancelUpdate)
-                    return;
-                QJsonObject songObject;
-                songObject.insert("artist", query.value(0).toString());
-                songObject.insert("title", query.value(1).toString());
-                songsArray.insert(0, songObject);
-                QApplication::processEvents();
-                count++;
-            }
-            docs++;
-            if (count < songsPerDoc)
-                done = true;
-            QJsonObject mainObject;
-            mainObject.insert("api_key", m_settings.requestServerApiKey());
-            mainObject.insert("command","addSongs");
-            mainObject.insert("songs", songsArray);
-            mainObject.insert("system_id", m_settings.systemId());
-            QJsonDocument jsonDocument;
-            jsonDocument.setObject(mainObject);
-            jsonDocs.append(jsonDocument);
-        }
-        QUrl url(m_settings.requestServerUrl());
-        QJsonObject mainObject;
-        mainObject.insert("api_key", m_settings.requestServerApiKey());
-        mainObject.insert("command","clearDatabase");
-        mainObject.insert("system_id", m_settings.systemId());
-        QJsonDocument jsonDocument;
-        jsonDocument.setObject(mainObject);
-        QNetworkRequest request(url);
-        if (cancelUpdate)
-            return;
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-        QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-        QNetworkReply *reply = manager->post(request, jsonDocument.toJson());
-        while (!reply->isFinished())
-            QApplication::processEvents();
-        m_logger->trace("{} Got reply: {}", m_loggingPrefix, reply->readAll().toStdString());
-        for (int i=0; i < jsonDocs.size(); i++)
-        {
-            if (cancelUpdate)
-                return;
-            QApplication::processEvents();
-            QNetworkRequest request(url);
-            request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-            QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-            QNetworkReply *reply = manager->post(request, jsonDocs.at(i).toJson());
-            while (!reply->isFinished()){
-                if (cancelUpdate)
-                    return;
-                QApplication::processEvents();
-            }
-            if (cancelUpdate)
-                return;
-            emit remoteSongDbUpdateProgress(i + 1);
-        }
-    }
+    SongbookUploader uploader;
+    m_uploader = &uploader;
+    uploader.setIgnoreSslErrors(m_settings.requestServerIgnoreCertErrors());
+    connect(&uploader, &SongbookUploader::documentCountChanged, this, &OKJSongbookAPI::remoteSongDbUpdateNumDocs);
+    connect(&uploader, &SongbookUploader::progressChanged, this, &OKJSongbookAPI::remoteSongDbUpdateProgress);
+    bool success = uploader.upload(QUrl(m_settings.requestServerUrl()), m_settings.requestServerApiKey(),
+                                   m_settings.systemId(), QSqlDatabase::database().databaseName());
+    m_uploader = nullptr;
     if (cancelUpdate)
         return;
+    updateFailed = !success;
     updateInProgress = false;
     emit remoteSongDbUpdateDone();
 }
@@ -548,6 +472,8 @@ void OKJSongbookAPI::dbUpdateCanceled()
         {
             cancelUpdate = true;
             updateInProgress = false;
+            if (m_uploader)
+                m_uploader->cancel();
         }
     }
 }
@@ -4,6 +4,7 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QPointer>
 #include <QUrl>
 #include <QTimer>
 #include "settings.h"
@@ -44,6 +45,8 @@ std::ostream& operator<<(std::ostream& os, const OkjsVenue& v);
 
 typedef QList<OkjsVenue> OkjsVenues;
 
+class SongbookUploader;
+
 class OKJSongbookAPI : public QObject
 {
     Q_OBJECT
@@ -62,7 +65,9 @@ private:
     int entitledSystems;
     bool programIsIdle;
     bool cancelUpdate;
+    bool updateFailed;
     bool updateInProgress;
+    QPointer<SongbookUploader> m_uploader;
     Settings m_settings;
 
 public:
@@ -80,6 +85,7 @@ public:
     void getEntitledSystemCount();
     [[nodiscard]] int entitledSystemCount() const { return entitledSystems; }
     [[nodiscard]] bool updateWasCancelled() const {return cancelUpdate; }
+    [[nodiscard]] bool updateWasSuccessful() const {return !updateFailed; }
     void triggerTestAdd();
 
 signals:
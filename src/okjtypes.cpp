@@ -20,6 +20,7 @@
 
 #include "okjtypes.h"
 #include <QSqlQuery>
+#include "sqlquerystats.h"
 #include <QSqlError>
 #include <utility>
 #include <spdlog/spdlog.h>
@@ -40,7 +41,7 @@ std::ostream & operator<<(std::ostream& os, const okj::RotationSinger& s)
 namespace okj {
 
     QString RotationSinger::nextSongPath() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.path FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -54,7 +55,7 @@ namespace okj {
     }
 
     QString RotationSinger::nextSongArtist() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.artist FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -68,7 +69,7 @@ namespace okj {
     }
 
     QString RotationSinger::nextSongTitle() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.title FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -82,7 +83,7 @@ namespace okj {
     }
 
     QString RotationSinger::nextSongArtistTitle() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.artist, dbsongs.title FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -96,7 +97,7 @@ namespace okj {
     }
 
     QString RotationSinger::nextSongSongId() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.discid FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -110,7 +111,7 @@ namespace okj {
     }
 
     int RotationSinger::nextSongDurationSecs() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT dbsongs.duration FROM dbsongs,queuesongs WHERE queuesongs.singer = :singerid AND queuesongs.played = 0 AND dbsongs.songid = queuesongs.song ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -126,7 +127,7 @@ namespace okj {
     }
 
     int RotationSinger::nextSongKeyChg() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT keychg FROM queuesongs WHERE singer = :singerid AND played = 0 ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -140,7 +141,7 @@ namespace okj {
     }
 
     int RotationSinger::nextSongQueueId() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare(
                 "SELECT qsongid FROM queuesongs WHERE singer = :singerid AND played = 0 ORDER BY position LIMIT 1");
         query.bindValue(":singerid", id);
@@ -154,7 +155,7 @@ namespace okj {
     }
 
     int RotationSinger::numSongsSung() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare("SELECT COUNT(qsongid) FROM queuesongs WHERE singer = :singerid AND played = true");
         query.bindValue(":singerid", id);
         query.exec();
@@ -167,7 +168,7 @@ namespace okj {
     }
 
     int RotationSinger::numSongsUnsung() const {
-        QSqlQuery query;
+        InstrumentedSqlQuery query;
         query.prepare("SELECT COUNT(qsongid) FROM queuesongs WHERE singer = :singerid AND played = false");
         query.bindValue(":singerid", id);
         query.exec();
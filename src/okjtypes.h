@@ -46,6 +46,8 @@ namespace okj {
         QDateTime lastPlay;
         bool bad{false};
         bool dropped{false};
+        // Companion audio file for loose cdg songs, resolved when the library is scanned
+        QString audioPath;
     };
 
     struct HistorySinger {
@@ -36,6 +36,20 @@ inline QString findMatchingAudioFile(const QString &cdgFilePath) {
     return QString();
 }
 
+// MediaBackend hands gstreamer a URI built from the local 8 bit encoding of the path.  Paths that don't survive
+// that round trip (non ASCII names on Windows code pages) have to be played from a temporary copy.
+inline bool pathIsSafeForGstreamer(const QString &path) {
+#ifdef Q_OS_WIN
+    for (const auto &c : path) {
+        if (c.unicode() > 0x7F)
+            return false;
+    }
+    return true;
+#else
+    return QString::fromLocal8Bit(path.toLocal8Bit()) == path;
+#endif
+}
+
 
 
 
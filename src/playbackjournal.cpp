@@ -0,0 +1,122 @@
+#include "playbackjournal.h"
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QDir>
+
+PlaybackJournal::PlaybackJournal(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(m_flushDelayMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &PlaybackJournal::flush);
+}
+
+PlaybackJournal::~PlaybackJournal()
+{
+    flush();
+}
+
+void PlaybackJournal::record(const MediaBackend::PlaybackHealth &health)
+{
+    m_logger->debug("{} {} {}: prepare {} ms, first audio {} ms, first video {} ms, {} audio qos, {} frames dropped, "
+                    "{} watchdog trips, {} seeks (max {} ms)", m_loggingPrefix, health.backend, health.sourcePath,
+                    health.prepareMs, health.firstAudioMs, health.firstVideoMs, health.audioQosEvents,
+                    health.videoFramesDropped, health.watchdogTrips, health.seeks, health.seekMaxMs);
+    m_pending.emplace_back(Entry{QDateTime::currentDateTime(), health});
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void PlaybackJournal::flush()
+{
+    m_flushTimer.stop();
+    if (m_pending.empty() || !QSqlDatabase::database().isOpen())
+        return;
+    QSqlQuery query;
+    if (!m_pruned)
+    {
+        query.prepare("DELETE FROM playbackJournal WHERE timestamp < :cutoff");
+        query.bindValue(":cutoff", QDateTime::currentDateTime().addDays(-m_retentionDays));
+        query.exec();
+        m_pruned = true;
+    }
+    QStringList sourceDirs;
+    query.exec("SELECT path FROM sourceDirs UNION SELECT path FROM bmsrcdirs");
+    while (query.next())
+        sourceDirs.append(QDir::cleanPath(query.value(0).toString()));
+
+    QSqlDatabase::database().transaction();
+    query.prepare("INSERT INTO playbackJournal (timestamp, backend, filepath, filetype, sourcedir, prepare_ms, "
+                  "first_audio_ms, first_video_ms, audio_qos_events, video_frames_dropped, warnings, watchdog_trips, "
+                  "seeks, seek_total_ms, seek_max_ms, played_ms, error) "
+                  "VALUES(:timestamp, :backend, :filepath, :filetype, :sourcedir, :prepare_ms, :first_audio_ms, "
+                  ":first_video_ms, :audio_qos_events, :video_frames_dropped, :warnings, :watchdog_trips, :seeks, "
+                  ":seek_total_ms, :seek_max_ms, :played_ms, :error)");
+    for (const auto &[timestamp, health] : m_pending)
+    {
+        query.bindValue(":timestamp", timestamp);
+        query.bindValue(":backend", health.backend);
+        query.bindValue(":filepath", health.sourcePath);
+        query.bindValue(":filetype", QFileInfo(health.sourcePath).suffix().toLower());
+        query.bindValue(":sourcedir", sourceDirFor(health.sourcePath, sourceDirs));
+        query.bindValue(":prepare_ms", health.prepareMs);
+        query.bindValue(":first_audio_ms", health.firstAudioMs);
+        query.bindValue(":first_video_ms", health.firstVideoMs);
+        query.bindValue(":audio_qos_events", health.audioQosEvents);
+        query.bindValue(":video_frames_dropped", health.videoFramesDropped);
+        query.bindValue(":warnings", health.warnings);
+        query.bindValue(":watchdog_trips", health.watchdogTrips);
+        query.bindValue(":seeks", health.seeks);
+        query.bindValue(":seek_total_ms", health.seekTotalMs);
+        query.bindValue(":seek_max_ms", health.seekMaxMs);
+        query.bindValue(":played_ms", health.playedMs);
+        query.bindValue(":error", health.error);
+        if (!query.exec())
+            m_logger->error("{} Unable to write journal entry: {}", m_loggingPrefix, query.lastError().text());
+    }
+    QSqlDatabase::database().commit();
+    m_pending.clear();
+}
+
+void PlaybackJournal::logSummary(int days)
+{
+    flush();
+    QSqlQuery query;
+    query.prepare("SELECT sourcedir, filetype, COUNT(*), AVG(NULLIF(prepare_ms, -1)), MAX(prepare_ms), "
+                  "AVG(NULLIF(first_audio_ms, -1)), MAX(first_audio_ms), AVG(NULLIF(first_video_ms, -1)), "
+                  "MAX(first_video_ms), SUM(audio_qos_events), SUM(video_frames_dropped), SUM(watchdog_trips), "
+                  "SUM(seeks), MAX(seek_max_ms), SUM(error) "
+                  "FROM playbackJournal WHERE timestamp >= :cutoff GROUP BY sourcedir, filetype "
+                  "ORDER BY AVG(NULLIF(first_audio_ms, -1)) DESC");
+    query.bindValue(":cutoff", QDateTime::currentDateTime().addDays(-days));
+    if (!query.exec())
+    {
+        m_logger->error("{} Unable to read journal: {}", m_loggingPrefix, query.lastError().text());
+        return;
+    }
+    m_logger->info("{} ---- Playback health for the last {} days, slowest first audio first ----", m_loggingPrefix, days);
+    while (query.next())
+    {
+        m_logger->info("{} {} [{}] {} plays - prepare avg {:.0f} max {} ms - first audio avg {:.0f} max {} ms - "
+                       "first video avg {:.0f} max {} ms - {} audio qos, {} frames dropped, {} watchdog trips, "
+                       "{} seeks (max {} ms), {} errors", m_loggingPrefix, query.value(0).toString(),
+                       query.value(1).toString(), query.value(2).toInt(), query.value(3).toDouble(),
+                       query.value(4).toLongLong(), query.value(5).toDouble(), query.value(6).toLongLong(),
+                       query.value(7).toDouble(), query.value(8).toLongLong(), query.value(9).toLongLong(),
+                       query.value(10).toLongLong(), query.value(11).toLongLong(), query.value(12).toLongLong(),
+                       query.value(13).toLongLong(), query.value(14).toLongLong());
+    }
+}
+
+QString PlaybackJournal::sourceDirFor(const QString &path, const QStringList &sourceDirs)
+{
+    QString best;
+    for (const auto &dir : sourceDirs)
+    {
+        if (path.startsWith(dir + '/') && dir.size() > best.size())
+            best = dir;
+    }
+    // Files outside the library (dropped on the queue, temp copies) are grouped by their own folder
+    return best.isEmpty() ? QFileInfo(path).absolutePath() : best;
+}
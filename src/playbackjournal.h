@@ -0,0 +1,45 @@
+#ifndef PLAYBACKJOURNAL_H
+#define PLAYBACKJOURNAL_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QTimer>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+#include "mediabackend.h"
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Keeps a row per played song in the playbackJournal table with the startup, underrun, watchdog and seek numbers
+// MediaBackend collected for it, tagged by file type and library source directory.
+// Rows are buffered and written a little while after the song ends so the insert never competes with starting
+// the next song.  logSummary() groups the history so slow shares or formats stand out.
+class PlaybackJournal : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PlaybackJournal(QObject *parent = nullptr);
+    ~PlaybackJournal() override;
+    void record(const MediaBackend::PlaybackHealth &health);
+    void flush();
+    void logSummary(int days = 30);
+
+private:
+    struct Entry {
+        QDateTime timestamp;
+        MediaBackend::PlaybackHealth health;
+    };
+    std::string m_loggingPrefix{"[PlaybackJournal]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::vector<Entry> m_pending;
+    QTimer m_flushTimer;
+    bool m_pruned{false};
+    const int m_flushDelayMs{15000};
+    const int m_retentionDays{365};
+
+    [[nodiscard]] static QString sourceDirFor(const QString &path, const QStringList &sourceDirs);
+};
+
+#endif // PLAYBACKJOURNAL_H
@@ -0,0 +1,108 @@
+#include "runstaterecorder.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+RunStateRecorder::RunStateRecorder(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+}
+
+QString RunStateRecorder::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QDir::separator() + "runstate.json";
+}
+
+std::optional<RunStateRecorder::RunState> RunStateRecorder::takeInterruptedSong()
+{
+    QFile file(filePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+    auto json = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    file.remove();
+    RunState state;
+    state.singerId = json.value("singerId").toInt(-1);
+    state.singer = json.value("singer").toString();
+    state.queueSongId = json.value("queueSongId").toInt(-1);
+    state.path = json.value("path").toString();
+    state.artist = json.value("artist").toString();
+    state.title = json.value("title").toString();
+    state.positionMs = static_cast<qint64>(json.value("positionMs").toDouble());
+    state.keyChange = json.value("keyChange").toInt();
+    state.tempo = json.value("tempo").toInt(100);
+    state.paused = json.value("paused").toBool();
+    state.updated = QDateTime::fromString(json.value("updated").toString(), Qt::ISODate);
+    if (state.path.isEmpty())
+    {
+        m_logger->warn("{} Ignoring unreadable run state record", m_loggingPrefix);
+        return std::nullopt;
+    }
+    if (!state.updated.isValid() || state.updated.secsTo(QDateTime::currentDateTime()) > m_maxResumeAgeSecs)
+    {
+        m_logger->info("{} Previous run was interrupted during {}, but too long ago to resume", m_loggingPrefix, state.path);
+        return std::nullopt;
+    }
+    return state;
+}
+
+void RunStateRecorder::songStarted(const RunState &state)
+{
+    m_current = state;
+    flush();
+}
+
+void RunStateRecorder::updatePlayback(const qint64 positionMs, const int keyChange, const int tempo)
+{
+    if (!m_current)
+        return;
+    bool settingsChanged = keyChange != m_current->keyChange || tempo != m_current->tempo;
+    m_current->positionMs = positionMs;
+    m_current->keyChange = keyChange;
+    m_current->tempo = tempo;
+    if (settingsChanged || m_lastFlush.hasExpired(m_flushIntervalMs))
+        flush();
+}
+
+void RunStateRecorder::setPaused(const bool paused)
+{
+    if (!m_current || m_current->paused == paused)
+        return;
+    m_current->paused = paused;
+    flush();
+}
+
+void RunStateRecorder::songStopped()
+{
+    if (!m_current)
+        return;
+    m_current.reset();
+    QFile::remove(filePath());
+}
+
+void RunStateRecorder::flush()
+{
+    m_lastFlush.start();
+    m_current->updated = QDateTime::currentDateTime();
+    QJsonObject json{
+            {"singerId", m_current->singerId},
+            {"singer", m_current->singer},
+            {"queueSongId", m_current->queueSongId},
+            {"path", m_current->path},
+            {"artist", m_current->artist},
+            {"title", m_current->title},
+            {"positionMs", static_cast<double>(m_current->positionMs)},
+            {"keyChange", m_current->keyChange},
+            {"tempo", m_current->tempo},
+            {"paused", m_current->paused},
+            {"updated", m_current->updated.toString(Qt::ISODate)}
+    };
+    // Written aside and renamed into place, a crash mid-write leaves the previous record intact
+    QSaveFile file(filePath());
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(json).toJson(QJsonDocument::Compact)) < 0 || !file.commit())
+        m_logger->warn("{} Unable to write run state: {}", m_loggingPrefix, file.errorString());
+}
@@ -0,0 +1,57 @@
+#ifndef RUNSTATERECORDER_H
+#define RUNSTATERECORDER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Keeps a small record of the karaoke song that's playing, rewritten every couple of seconds, so a crash or kill
+// mid-song can be picked back up at about the same spot on the next start.  The record is removed whenever the
+// karaoke backend stops and on a clean shutdown, if it's there at startup the last run went away mid-song.
+class RunStateRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    struct RunState {
+        int singerId{-1};
+        QString singer;
+        int queueSongId{-1};
+        QString path;
+        QString artist;
+        QString title;
+        qint64 positionMs{0};
+        int keyChange{0};
+        int tempo{100};
+        bool paused{false};
+        QDateTime updated;
+    };
+
+    explicit RunStateRecorder(QObject *parent = nullptr);
+    // What the previous run was playing when it went away, empty after a clean exit or if it's too old to matter.
+    // The record is consumed, resuming the song starts a new one.
+    [[nodiscard]] std::optional<RunState> takeInterruptedSong();
+    void songStarted(const RunState &state);
+    void updatePlayback(qint64 positionMs, int keyChange, int tempo);
+    void setPaused(bool paused);
+    void songStopped();
+
+private:
+    std::string m_loggingPrefix{"[RunState]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::optional<RunState> m_current;
+    QElapsedTimer m_lastFlush;
+    const qint64 m_flushIntervalMs{2000};
+    const qint64 m_maxResumeAgeSecs{6 * 3600};
+
+    void flush();
+    // Looked up on use, the application name that picks the data directory isn't set until MainWindow starts up
+    [[nodiscard]] static QString filePath();
+};
+
+#endif // RUNSTATERECORDER_H
@@ -1808,3 +1808,67 @@ bool Settings::tickerReducedCpuMode() {
 void Settings::setTickerReducedCpuMode(bool enabled) {
     settings->setValue("tickerReducedCpuMode", enabled);
 }
+
+bool Settings::sqlQueryStatsEnabled() const {
+    return settings->value("sqlQueryStatsEnabled", false).toBool();
+}
+
+void Settings::setSqlQueryStatsEnabled(bool enabled) {
+    settings->setValue("sqlQueryStatsEnabled", enabled);
+}
+
+int Settings::sqlSlowQueryThresholdMs() const {
+    return settings->value("sqlSlowQueryThresholdMs", 50).toInt();
+}
+
+int Settings::dspQualityFloor() const {
+    return settings->value("dspQualityFloor", 3).toInt();
+}
+
+void Settings::setDspQualityFloor(int tier) {
+    settings->setValue("dspQualityFloor", tier);
+}
+
+bool Settings::cdgMirrorEnabled() const {
+    return settings->value("cdgMirrorEnabled", false).toBool();
+}
+
+void Settings::setCdgMirrorEnabled(bool enabled) {
+    settings->setValue("cdgMirrorEnabled", enabled);
+}
+
+QString Settings::cdgMirrorAddress() const {
+    return settings->value("cdgMirrorAddress", "239.255.42.99").toString();
+}
+
+void Settings::setCdgMirrorAddress(const QString &address) {
+    settings->setValue("cdgMirrorAddress", address);
+}
+
+int Settings::cdgMirrorPort() const {
+    return settings->value("cdgMirrorPort", 5007).toInt();
+}
+
+void Settings::setCdgMirrorPort(int port) {
+    settings->setValue("cdgMirrorPort", port);
+}
+
+int Settings::audioSinkBufferMinMs() const {
+    return settings->value("audioSinkBufferMinMs", 40).toInt();
+}
+
+int Settings::audioSinkBufferMaxMs() const {
+    return settings->value("audioSinkBufferMaxMs", 1000).toInt();
+}
+
+int Settings::audioSinkBufferMs(const QString &deviceKey) const {
+    QString key = deviceKey;
+    key.replace('/', '_').replace('\\', '_');
+    return settings->value("audioSinkBufferMs/" + key, -1).toInt();
+}
+
+void Settings::setAudioSinkBufferMs(const QString &deviceKey, int bufferMs) {
+    QString key = deviceKey;
+    key.replace('/', '_').replace('\\', '_');
+    settings->setValue("audioSinkBufferMs/" + key, bufferMs);
+}
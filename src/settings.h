@@ -67,6 +67,9 @@ public:
     int getFileLogLevel();
     bool tickerReducedCpuMode();
     void setTickerReducedCpuMode(bool enabled);
+    [[nodiscard]] bool sqlQueryStatsEnabled() const;
+    void setSqlQueryStatsEnabled(bool enabled);
+    [[nodiscard]] int sqlSlowQueryThresholdMs() const;
     void setConsoleLogLevel(int level);
     void setFileLogLevel(int level);
     int lastRunRotationTopSingerId();
@@ -183,6 +186,19 @@ public:
     void setAudioOutputDeviceBm(QString device);
     int audioBackend();
     void setAudioBackend(int index);
+    [[nodiscard]] int dspQualityFloor() const;
+    void setDspQualityFloor(int tier);
+    [[nodiscard]] int audioSinkBufferMinMs() const;
+    [[nodiscard]] int audioSinkBufferMaxMs() const;
+    // Learned output buffer per player and device, -1 if nothing has been learned yet
+    [[nodiscard]] int audioSinkBufferMs(const QString &deviceKey) const;
+    void setAudioSinkBufferMs(const QString &deviceKey, int bufferMs);
+    [[nodiscard]] bool cdgMirrorEnabled() const;
+    void setCdgMirrorEnabled(bool enabled);
+    [[nodiscard]] QString cdgMirrorAddress() const;
+    void setCdgMirrorAddress(const QString &address);
+    [[nodiscard]] int cdgMirrorPort() const;
+    void setCdgMirrorPort(int port);
     QString recordingContainer();
     void setRecordingContainer(QString container);
     QString recordingCodec();
@@ -2,6 +2,7 @@
 #include <QObject>
 #include <QPainter>
 #include <QResizeEvent>
+#include <gst/video/video.h>
 
 SoftwareRenderVideoSink::SoftwareRenderVideoSink(QWidget *surface)
 {
@@ -34,6 +35,10 @@ SoftwareRenderVideoSink::SoftwareRenderVideoSink(QWidget *surface)
     // Allow the sink to send qos messages to pipeline to allow skipping frames
     gst_base_sink_set_qos_enabled(reinterpret_cast<GstBaseSink*>(m_appSink), true);
 
+    m_capsUpdateTimer.setSingleShot(true);
+    m_capsUpdateTimer.setInterval(m_capsUpdateDelayMs);
+    connect(&m_capsUpdateTimer, &QTimer::timeout, this, &SoftwareRenderVideoSink::applyPendingSize);
+
     m_surface->installEventFilter(this);
 
     connect(this, SIGNAL(newFrameAvailable()), m_surface, SLOT(update()), Qt::QueuedConnection);
@@ -75,9 +80,25 @@ bool SoftwareRenderVideoSink::eventFilter(QObject *obj, QEvent *event)
 
 void SoftwareRenderVideoSink::onSurfaceResized(const QSize &size)
 {
+    m_pendingSize = size;
+    // The first size is applied right away so playback doesn't start out scaled by the painter
+    if (!m_negotiatedSize.isValid())
+    {
+        applyPendingSize();
+        return;
+    }
+    m_capsUpdateTimer.start();
+}
+
+void SoftwareRenderVideoSink::applyPendingSize()
+{
+    m_capsUpdateTimer.stop();
+    if (m_pendingSize == m_negotiatedSize || m_pendingSize.isEmpty())
+        return;
+    m_negotiatedSize = m_pendingSize;
     // Tell what image dimension we can handle and let
     // the Videoscale element earlier in the pipeline do the actual scaline.
-    gst_caps_set_simple(m_videoCaps, "width", G_TYPE_INT, size.width(), "height", G_TYPE_INT, size.height(), nullptr);
+    gst_caps_set_simple(m_videoCaps, "width", G_TYPE_INT, m_negotiatedSize.width(), "height", G_TYPE_INT, m_negotiatedSize.height(), nullptr);
     gst_app_sink_set_caps(m_appSink, m_videoCaps);
     gst_element_send_event(GST_ELEMENT(m_appSink), gst_event_new_reconfigure());
 }
@@ -112,40 +133,46 @@ bool SoftwareRenderVideoSink::pullSampleAndDrawImage()
 
     if (sample)
     {
+        GstVideoInfo videoInfo;
+        QImage::Format qtFormat{QImage::Format_Invalid};
+        if (gst_video_info_from_caps(&videoInfo, gst_sample_get_caps(sample)))
+        {
+            if (GST_VIDEO_INFO_FORMAT(&videoInfo) == GST_VIDEO_FORMAT_RGB16)
+                qtFormat = QImage::Format_RGB16;
+            else if (GST_VIDEO_INFO_FORMAT(&videoInfo) == GST_VIDEO_FORMAT_BGRx)
+                qtFormat = QImage::Format_RGB32;
+        }
+        if (qtFormat == QImage::Format_Invalid)
+        {
+            gst_sample_unref(sample);
+            return paintBuffer();
+        }
+
         SampleInfo *info = new SampleInfo();
         info->sample = sample;
         info->bufferInfo = new GstMapInfo;
-        GstCaps *caps;
-        GstStructure *s;
-        const gchar *format;
-        int width, height;
-
-        caps = gst_sample_get_caps(sample);
-        s = gst_caps_get_structure(caps, 0);
-        gst_structure_get_int(s, "width", &width);
-        gst_structure_get_int(s, "height", &height);
-        format = gst_structure_get_string(s, "format");
-
         info->buffer = gst_sample_get_buffer (sample);
-
         gst_buffer_map(info->buffer, info->bufferInfo, GST_MAP_READ);
-        guint8 *rawFrame = info->bufferInfo->data;
-
-        QImage::Format qtFormat;
 
-        if (strcmp(format, "RGB16") == 0)
-            qtFormat = QImage::Format_RGB16;
-        else if (strcmp(format, "BGRx") == 0)
-            qtFormat = QImage::Format_RGB32;
+        // Rows can be padded (RGB16 rows are rounded up to 4 bytes), so use the actual stride
+        // from the buffer's video meta when there is one, or the default stride for the caps otherwise.
+        int stride = GST_VIDEO_INFO_PLANE_STRIDE(&videoInfo, 0);
+        guint8 *rawFrame = info->bufferInfo->data + GST_VIDEO_INFO_PLANE_OFFSET(&videoInfo, 0);
+        if (GstVideoMeta *meta = gst_buffer_get_video_meta(info->buffer))
+        {
+            stride = meta->stride[0];
+            rawFrame = info->bufferInfo->data + meta->offset[0];
+        }
 
-        QImage frame(rawFrame, width, height, qtFormat, cleanupFunction, info);
+        QImage frame(rawFrame, GST_VIDEO_INFO_WIDTH(&videoInfo), GST_VIDEO_INFO_HEIGHT(&videoInfo), stride, qtFormat, cleanupFunction, info);
         m_buffer = frame;
     }
     else
     {
         // No sample found in queue - are we still playing?
+        // Zero timeout: this runs in the paint event, so only look at the current state and never wait for a pending change.
         GstState state = GST_STATE_NULL;
-        gst_element_get_state(reinterpret_cast<GstElement*>(m_appSink), &state, nullptr, GST_CLOCK_TIME_NONE);
+        gst_element_get_state(reinterpret_cast<GstElement*>(m_appSink), &state, nullptr, 0);
 
         if (state == GST_STATE_NULL)
         {
@@ -154,12 +181,15 @@ bool SoftwareRenderVideoSink::pullSampleAndDrawImage()
         }
     }
 
-    if (!m_buffer.isNull())
-    {
-        QPainter painter(m_surface);
-        painter.drawImage(m_surface->contentsRect(), m_buffer, m_buffer.rect());
-        return true;
-    }
+    return paintBuffer();
+}
+
+bool SoftwareRenderVideoSink::paintBuffer()
+{
+    if (m_buffer.isNull())
+        return false;
 
-    return false;
+    QPainter painter(m_surface);
+    painter.drawImage(m_surface->contentsRect(), m_buffer, m_buffer.rect());
+    return true;
 }
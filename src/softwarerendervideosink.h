@@ -5,6 +5,7 @@
 #include <gst/app/gstappsink.h>
 
 #include <QWidget>
+#include <QTimer>
 
 
 class SoftwareRenderVideoSink : public QObject
@@ -26,13 +27,22 @@ private:
     QWidget *m_surface;
     QImage m_buffer;
 
+    // Resizes are coalesced so dragging or fullscreening the window renegotiates caps once.
+    // Frames arriving in the meantime are scaled by the painter.
+    QTimer m_capsUpdateTimer;
+    QSize m_pendingSize;
+    QSize m_negotiatedSize;
+    const int m_capsUpdateDelayMs{150};
+
     void onSurfaceResized(const QSize &size);
+    void applyPendingSize();
 
     GstAppSink *m_appSink;
     GstCaps *m_videoCaps;
 
     static GstFlowReturn NewSampleCallback(GstAppSink *appsink, gpointer user_data);
     bool pullSampleAndDrawImage();
+    bool paintBuffer();
     static void cleanupFunction(void *info);
 
 signals:
@@ -0,0 +1,281 @@
+#include "songbookuploader.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkRequest>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+#include <utility>
+#include "src/miniz/miniz.h"
+
+SongbookDocumentWorker::SongbookDocumentWorker(QString dbFilePath, QJsonObject documentTemplate, int songsPerDoc) :
+        m_dbFilePath(std::move(dbFilePath)), m_documentTemplate(std::move(documentTemplate)), m_songsPerDoc(songsPerDoc)
+{
+}
+
+QByteArray SongbookDocumentWorker::gzipCompress(const QByteArray &data)
+{
+    // miniz writes raw deflate streams, gzip is a raw deflate stream wrapped in a 10 byte header and a crc/size trailer
+    auto flags = static_cast<int>(tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+    size_t compressedSize{0};
+    auto compressed = tdefl_compress_mem_to_heap(data.constData(), data.size(), &compressedSize, flags);
+    if (!compressed)
+        return {};
+    static const char header[] {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\xff'};
+    QByteArray gzipped;
+    gzipped.reserve(static_cast<int>(sizeof(header) + compressedSize + 8));
+    gzipped.append(header, sizeof(header));
+    gzipped.append(static_cast<const char*>(compressed), static_cast<int>(compressedSize));
+    mz_free(compressed);
+    auto appendLittleEndian = [&gzipped] (quint32 value) {
+        for (int i = 0; i < 4; i++)
+            gzipped.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+    };
+    appendLittleEndian(static_cast<quint32>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(data.constData()), data.size())));
+    appendLittleEndian(static_cast<quint32>(data.size()));
+    return gzipped;
+}
+
+void SongbookDocumentWorker::buildDocuments()
+{
+    std::string m_loggingPrefix{"[SongbookDocumentWorker]"};
+    auto logger = spdlog::get("logger");
+    QString connectionName = QString("songbook-upload-%1").arg(reinterpret_cast<quintptr>(this));
+    {
+        auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(m_dbFilePath);
+        if (!database.open()) {
+            logger->error("{} Unable to open database: {}", m_loggingPrefix, database.lastError().text());
+            emit documentCountKnown(0);
+        } else {
+            QSqlQuery query(database);
+            int numEntries{0};
+            if (query.exec("SELECT COUNT(DISTINCT artist||title) FROM dbsongs WHERE discid != '!!DROPPED!!' AND discid != '!!BAD!!'") && query.first())
+                numEntries = query.value(0).toInt();
+            emit documentCountKnown((numEntries + m_songsPerDoc - 1) / m_songsPerDoc);
+            query.setForwardOnly(true);
+            query.exec("SELECT DISTINCT artist,title FROM dbsongs WHERE discid != '!!DROPPED!!' AND discid != '!!BAD!!' ORDER BY artist ASC, title ASC");
+            QJsonArray songsArray;
+            int index{0};
+            auto emitDocument = [&] () {
+                auto document = m_documentTemplate;
+                document.insert("songs", songsArray);
+                auto json = QJsonDocument(document).toJson(QJsonDocument::Compact);
+                emit documentReady(index++, json, gzipCompress(json));
+                songsArray = QJsonArray();
+            };
+            bool interrupted{false};
+            while (query.next()) {
+                if ((interrupted = QThread::currentThread()->isInterruptionRequested()))
+                    break;
+                songsArray.append(QJsonObject{
+                        {"artist", query.value(0).toString()},
+                        {"title", query.value(1).toString()}
+                });
+                if (songsArray.size() == m_songsPerDoc)
+                    emitDocument();
+            }
+            if (!interrupted && !songsArray.isEmpty())
+                emitDocument();
+            logger->debug("{} Built {} documents", m_loggingPrefix, index);
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    emit documentsDone();
+}
+
+
+SongbookUploader::SongbookUploader(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+    m_workerThread.setObjectName("SongbookUpload");
+}
+
+SongbookUploader::~SongbookUploader()
+{
+    m_workerThread.requestInterruption();
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+bool SongbookUploader::upload(const QUrl &url, const QString &apiKey, int systemId, const QString &dbFilePath)
+{
+    m_url = url;
+    m_pending.clear();
+    m_inFlight.clear();
+    m_documentCount = -1;
+    m_posted = 0;
+    m_retriesWaiting = 0;
+    m_cleared = false;
+    m_documentsDone = false;
+    m_failed = false;
+    m_cancelled = false;
+    m_running = true;
+    QElapsedTimer uploadTimer;
+    uploadTimer.start();
+
+    auto worker = new SongbookDocumentWorker(dbFilePath, QJsonObject{
+            {"api_key", apiKey},
+            {"command", "addSongs"},
+            {"system_id", systemId}
+    }, m_songsPerDoc);
+    worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &SongbookDocumentWorker::documentCountKnown, this, [this] (int count) {
+        m_documentCount = count;
+        emit documentCountChanged(count);
+    });
+    connect(worker, &SongbookDocumentWorker::documentReady, this, &SongbookUploader::documentReady);
+    connect(worker, &SongbookDocumentWorker::documentsDone, this, [this] () {
+        m_documentsDone = true;
+        finishIfDone();
+    });
+    m_workerThread.start(QThread::LowPriority);
+    QMetaObject::invokeMethod(worker, &SongbookDocumentWorker::buildDocuments, Qt::QueuedConnection);
+
+    // The server's list has to be cleared before any songs are added, the worker builds documents in the meantime
+    sendDocument(Document{-1, QJsonDocument(QJsonObject{
+            {"api_key", apiKey},
+            {"command", "clearDatabase"},
+            {"system_id", systemId}
+    }).toJson(QJsonDocument::Compact), {}, 0});
+
+    m_loop.exec();
+
+    m_running = false;
+    m_workerThread.requestInterruption();
+    m_workerThread.quit();
+    m_workerThread.wait();
+    // Documents the worker finished after the loop exited are still queued for us, they belong to this upload only
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+    for (auto reply : QList<QNetworkReply*>(m_inFlight))
+        reply->abort();
+    m_inFlight.clear();
+    m_pending.clear();
+
+    if (m_cancelled)
+        m_logger->info("{} Upload cancelled after {} of {} documents", m_loggingPrefix, m_posted, m_documentCount);
+    else if (m_failed)
+        m_logger->error("{} Upload failed after {} of {} documents", m_loggingPrefix, m_posted, m_documentCount);
+    else
+        m_logger->info("{} Uploaded {} documents in {} ms", m_loggingPrefix, m_posted, uploadTimer.elapsed());
+    return !m_failed && !m_cancelled;
+}
+
+void SongbookUploader::cancel()
+{
+    if (!m_running)
+        return;
+    m_cancelled = true;
+    m_loop.quit();
+}
+
+QNetworkReply *SongbookUploader::post(const QByteArray &body, bool gzipped)
+{
+    QNetworkRequest request(m_url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (gzipped)
+        request.setRawHeader("Content-Encoding", "gzip");
+    auto reply = m_manager.post(request, body);
+    if (m_ignoreSslErrors)
+        reply->ignoreSslErrors();
+    m_inFlight.append(reply);
+    return reply;
+}
+
+void SongbookUploader::documentReady(int index, const QByteArray &json, const QByteArray &gzipped)
+{
+    if (!m_running)
+        return;
+    m_pending.push_back(Document{index, json, gzipped, 0});
+    postPending();
+}
+
+void SongbookUploader::sendDocument(const Document &document)
+{
+    bool gzipped = m_compress && !document.gzipped.isEmpty();
+    auto reply = post(gzipped ? document.gzipped : document.json, gzipped);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, document] () {
+        documentPosted(reply, document);
+    });
+}
+
+void SongbookUploader::postPending()
+{
+    while (m_running && m_cleared && m_inFlight.size() < m_maxInFlight && !m_pending.empty())
+    {
+        auto document = m_pending.front();
+        m_pending.pop_front();
+        sendDocument(document);
+    }
+}
+
+void SongbookUploader::documentPosted(QNetworkReply *reply, Document document)
+{
+    m_inFlight.removeAll(reply);
+    reply->deleteLater();
+    if (!m_running)
+        return;
+    auto data = reply->readAll();
+    if (replySucceeded(reply, data))
+    {
+        if (document.index < 0)
+            m_cleared = true;
+        else
+            emit progressChanged(++m_posted);
+        postPending();
+        finishIfDone();
+        return;
+    }
+    auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 415 && m_compress && !document.gzipped.isEmpty())
+    {
+        m_logger->warn("{} Server doesn't accept compressed uploads, sending the remaining documents uncompressed", m_loggingPrefix);
+        m_compress = false;
+        m_pending.push_front(document);
+        postPending();
+        return;
+    }
+    if (++document.attempts >= m_maxAttempts)
+    {
+        m_logger->error("{} Giving up on document {} after {} attempts, last error: {}", m_loggingPrefix, document.index,
+                        document.attempts, reply->errorString());
+        m_failed = true;
+        m_loop.quit();
+        return;
+    }
+    int delayMs = 1000 * document.attempts;
+    m_logger->warn("{} Posting document {} failed ({}), retrying in {} ms", m_loggingPrefix, document.index,
+                   reply->errorString(), delayMs);
+    m_retriesWaiting++;
+    QTimer::singleShot(delayMs, this, [this, document] () {
+        m_retriesWaiting--;
+        if (!m_running)
+            return;
+        if (document.index < 0)
+        {
+            sendDocument(document);
+            return;
+        }
+        m_pending.push_front(document);
+        postPending();
+    });
+}
+
+void SongbookUploader::finishIfDone()
+{
+    if (m_running && m_cleared && m_documentsDone && m_pending.empty() && m_inFlight.empty() && m_retriesWaiting == 0)
+        m_loop.quit();
+}
+
+bool SongbookUploader::replySucceeded(QNetworkReply *reply, const QByteArray &data)
+{
+    if (reply->error() != QNetworkReply::NoError)
+        return false;
+    return !QJsonDocument::fromJson(data).object().value("error").toBool();
+}
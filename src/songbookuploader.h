@@ -0,0 +1,100 @@
+#ifndef SONGBOOKUPLOADER_H
+#define SONGBOOKUPLOADER_H
+
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QThread>
+#include <QUrl>
+#include <deque>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Reads the distinct artist/title list from its own db connection and turns it into addSongs request bodies,
+// both plain and gzip compressed, handing each one over as soon as it's built so uploading can start right away.
+class SongbookDocumentWorker : public QObject
+{
+    Q_OBJECT
+public:
+    SongbookDocumentWorker(QString dbFilePath, QJsonObject documentTemplate, int songsPerDoc);
+    static QByteArray gzipCompress(const QByteArray &data);
+
+public slots:
+    void buildDocuments();
+
+signals:
+    void documentCountKnown(int count);
+    void documentReady(int index, const QByteArray &json, const QByteArray &gzipped);
+    void documentsDone();
+
+private:
+    QString m_dbFilePath;
+    QJsonObject m_documentTemplate;
+    int m_songsPerDoc;
+};
+
+// Replaces the songbook server's song list with the local catalog.
+// Documents are posted over one network manager with a small window of requests in flight, failed posts are
+// retried with a growing delay.  upload() runs a local event loop until everything is posted, a document fails
+// for good, or cancel() is called.
+class SongbookUploader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SongbookUploader(QObject *parent = nullptr);
+    ~SongbookUploader() override;
+    bool upload(const QUrl &url, const QString &apiKey, int systemId, const QString &dbFilePath);
+    void cancel();
+    void setIgnoreSslErrors(bool ignore) { m_ignoreSslErrors = ignore; }
+    void setCompressionEnabled(bool enabled) { m_compress = enabled; }
+    [[nodiscard]] bool wasCancelled() const { return m_cancelled; }
+    [[nodiscard]] int songsPerDocument() const { return m_songsPerDoc; }
+
+signals:
+    void documentCountChanged(int count);
+    void progressChanged(int documentsPosted);
+
+private:
+    struct Document {
+        int index{0};
+        QByteArray json;
+        QByteArray gzipped;
+        int attempts{0};
+    };
+    std::string m_loggingPrefix{"[SongbookUploader]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    QNetworkAccessManager m_manager;
+    QThread m_workerThread;
+    QEventLoop m_loop;
+    QUrl m_url;
+    std::deque<Document> m_pending;
+    QList<QNetworkReply*> m_inFlight;
+    int m_documentCount{-1};
+    int m_posted{0};
+    int m_retriesWaiting{0};
+    bool m_running{false};
+    bool m_cleared{false};
+    bool m_documentsDone{false};
+    bool m_failed{false};
+    bool m_cancelled{false};
+    bool m_compress{true};
+    bool m_ignoreSslErrors{false};
+    const int m_songsPerDoc{1000};
+    const int m_maxInFlight{4};
+    const int m_maxAttempts{4};
+
+    QNetworkReply *post(const QByteArray &body, bool gzipped);
+    void documentReady(int index, const QByteArray &json, const QByteArray &gzipped);
+    void sendDocument(const Document &document);
+    void postPending();
+    void documentPosted(QNetworkReply *reply, Document document);
+    void finishIfDone();
+    static bool replySucceeded(QNetworkReply *reply, const QByteArray &data);
+};
+
+#endif // SONGBOOKUPLOADER_H
@@ -0,0 +1,308 @@
+#include "sqlquerystats.h"
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+constexpr int summaryStatementsPerAction{5};
+constexpr int summaryTopStatements{15};
+const QString noActionName{"(no action)"};
+
+double nsToMs(qint64 ns)
+{
+    return static_cast<double>(ns) / 1000000.0;
+}
+
+std::vector<std::pair<QString, SqlQueryStats::StatementStats>> sortedByTotalTime(const QHash<QString, SqlQueryStats::StatementStats> &stats)
+{
+    std::vector<std::pair<QString, SqlQueryStats::StatementStats>> sorted;
+    sorted.reserve(stats.size());
+    for (auto it = stats.cbegin(); it != stats.cend(); ++it)
+        sorted.emplace_back(it.key(), it.value());
+    std::sort(sorted.begin(), sorted.end(), [] (const auto &a, const auto &b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+    return sorted;
+}
+}
+
+thread_local std::vector<SqlQueryStats::ActiveAction> SqlQueryStats::t_activeActions;
+
+SqlQueryStats &SqlQueryStats::instance()
+{
+    static SqlQueryStats stats;
+    return stats;
+}
+
+SqlQueryStats::SqlQueryStats()
+{
+    m_logger = spdlog::get("logger");
+}
+
+void SqlQueryStats::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled) == enabled)
+        return;
+    m_logger->info("{} SQL query statistics recording {}", m_loggingPrefix, enabled ? "enabled" : "disabled");
+}
+
+void SqlQueryStats::setSlowThresholdMs(int ms)
+{
+    m_slowThresholdMs = ms;
+}
+
+void SqlQueryStats::recordExec(const QSqlQuery &query, const QSqlDatabase &db, qint64 elapsedNs)
+{
+    auto statement = normalizeStatement(query.lastQuery());
+    auto actionName = currentActionName();
+    for (auto &action : t_activeActions) {
+        action.queries++;
+        action.queryNs += elapsedNs;
+    }
+    int thresholdMs = m_slowThresholdMs;
+    bool slow = thresholdMs > 0 && nsToMs(elapsedNs) >= thresholdMs;
+    bool explain{false};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto *stats : {&m_statements[statement], &m_actions[actionName].statements[statement]}) {
+            stats->count++;
+            stats->totalNs += elapsedNs;
+            stats->maxNs = std::max(stats->maxNs, elapsedNs);
+        }
+        if (t_activeActions.empty()) {
+            auto &noAction = m_actions[actionName];
+            noAction.queries++;
+            noAction.totalNs += elapsedNs;
+        }
+        // The plan only gets logged the first time a statement is slow, it won't change between runs
+        if (slow && !m_explainedStatements.contains(statement)) {
+            m_explainedStatements.insert(statement);
+            explain = true;
+        }
+    }
+    if (slow)
+        logSlowQuery(query, db, statement, elapsedNs, explain);
+}
+
+void SqlQueryStats::recordRows(const QString &statement, quint64 rows)
+{
+    auto normalized = normalizeStatement(statement);
+    auto actionName = currentActionName();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statements[normalized].rows += rows;
+    m_actions[actionName].statements[normalized].rows += rows;
+}
+
+void SqlQueryStats::beginAction(const QString &name)
+{
+    t_activeActions.emplace_back(ActiveAction{name});
+}
+
+void SqlQueryStats::endAction()
+{
+    if (t_activeActions.empty())
+        return;
+    auto finished = t_activeActions.back();
+    t_activeActions.pop_back();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &action = m_actions[finished.name];
+        action.invocations++;
+        action.queries += finished.queries;
+        action.maxQueries = std::max(action.maxQueries, finished.queries);
+        action.totalNs += finished.queryNs;
+    }
+    int thresholdMs = m_slowThresholdMs;
+    if (thresholdMs > 0 && nsToMs(finished.queryNs) >= thresholdMs)
+        m_logger->warn("{} Action '{}' ran {} queries taking {:.1f} ms", m_loggingPrefix, finished.name,
+                       finished.queries, nsToMs(finished.queryNs));
+    else
+        m_logger->debug("{} Action '{}' ran {} queries taking {:.1f} ms", m_loggingPrefix, finished.name,
+                        finished.queries, nsToMs(finished.queryNs));
+}
+
+void SqlQueryStats::logSummary()
+{
+    QHash<QString, StatementStats> statements;
+    QHash<QString, ActionStats> actions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        statements = m_statements;
+        actions = m_actions;
+    }
+    m_logger->info("{} ---- SQL query summary: {} distinct statements ----", m_loggingPrefix, statements.size());
+
+    std::vector<std::pair<QString, ActionStats>> sortedActions;
+    for (auto it = actions.cbegin(); it != actions.cend(); ++it)
+        sortedActions.emplace_back(it.key(), it.value());
+    std::sort(sortedActions.begin(), sortedActions.end(), [] (const auto &a, const auto &b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+    for (const auto &[name, action] : sortedActions) {
+        if (action.invocations > 0)
+            m_logger->info("{} Action '{}': {} runs, {} queries ({:.1f} per run, max {}), {:.1f} ms total",
+                           m_loggingPrefix, name, action.invocations, action.queries,
+                           static_cast<double>(action.queries) / action.invocations, action.maxQueries,
+                           nsToMs(action.totalNs));
+        else
+            m_logger->info("{} Action '{}': {} queries, {:.1f} ms total", m_loggingPrefix, name, action.queries,
+                           nsToMs(action.totalNs));
+        auto sortedStatements = sortedByTotalTime(action.statements);
+        for (int i = 0; i < std::min(summaryStatementsPerAction, static_cast<int>(sortedStatements.size())); i++) {
+            const auto &[statement, stats] = sortedStatements.at(i);
+            m_logger->info("{}     {}x {:.1f} ms total, {:.2f} ms max, {} rows: {}", m_loggingPrefix, stats.count,
+                           nsToMs(stats.totalNs), nsToMs(stats.maxNs), stats.rows, statement);
+        }
+    }
+
+    m_logger->info("{} ---- Top statements by total time ----", m_loggingPrefix);
+    auto sortedStatements = sortedByTotalTime(statements);
+    for (int i = 0; i < std::min(summaryTopStatements, static_cast<int>(sortedStatements.size())); i++) {
+        const auto &[statement, stats] = sortedStatements.at(i);
+        m_logger->info("{} {}x {:.1f} ms total, {:.3f} ms avg, {:.2f} ms max, {} rows: {}", m_loggingPrefix,
+                       stats.count, nsToMs(stats.totalNs), nsToMs(stats.totalNs) / static_cast<double>(stats.count),
+                       nsToMs(stats.maxNs), stats.rows, statement);
+    }
+}
+
+void SqlQueryStats::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statements.clear();
+    m_actions.clear();
+    m_explainedStatements.clear();
+}
+
+QString SqlQueryStats::normalizeStatement(const QString &statement)
+{
+    // Literal numbers are folded so "WHERE songid = 12" and "WHERE songid = 13" count as one statement
+    static const QRegularExpression numbers("\\b\\d+\\b");
+    auto normalized = statement.simplified();
+    normalized.replace(numbers, "?");
+    if (normalized.size() > 300)
+        normalized = normalized.left(300) + "...";
+    return normalized;
+}
+
+QString SqlQueryStats::currentActionName() const
+{
+    return t_activeActions.empty() ? noActionName : t_activeActions.back().name;
+}
+
+void SqlQueryStats::logSlowQuery(const QSqlQuery &query, const QSqlDatabase &db, const QString &statement,
+                                 qint64 elapsedNs, bool explain)
+{
+    m_logger->warn("{} Slow query ({:.1f} ms) in action '{}': {}", m_loggingPrefix, nsToMs(elapsedNs),
+                   currentActionName(), statement);
+    if (!explain)
+        return;
+    auto sql = query.lastQuery().trimmed();
+    static const QStringList explainable{"SELECT", "UPDATE", "DELETE", "INSERT", "WITH", "REPLACE"};
+    if (std::none_of(explainable.cbegin(), explainable.cend(), [&sql] (const QString &keyword) {
+        return sql.startsWith(keyword, Qt::CaseInsensitive);
+    }))
+        return;
+    QSqlQuery explainQuery(db);
+    explainQuery.prepare("EXPLAIN QUERY PLAN " + sql);
+    const auto boundValues = query.boundValues();
+    for (auto it = boundValues.cbegin(); it != boundValues.cend(); ++it) {
+        if (it.key().startsWith(':'))
+            explainQuery.bindValue(it.key(), it.value());
+        else
+            explainQuery.addBindValue(it.value());
+    }
+    if (!explainQuery.exec()) {
+        m_logger->warn("{}     Unable to get query plan: {}", m_loggingPrefix, explainQuery.lastError().text());
+        return;
+    }
+    int detailColumn = explainQuery.record().indexOf("detail");
+    while (explainQuery.next()) {
+        auto detail = explainQuery.value(detailColumn).toString();
+        bool fullScan = detail.startsWith("SCAN", Qt::CaseInsensitive) && !detail.contains("INDEX", Qt::CaseInsensitive);
+        m_logger->warn("{}     plan: {}{}", m_loggingPrefix, detail, fullScan ? "  <-- full table scan" : "");
+    }
+}
+
+
+InstrumentedSqlQuery::InstrumentedSqlQuery(const QSqlDatabase &db) :
+        QSqlQuery(db), m_db(db)
+{
+}
+
+InstrumentedSqlQuery::InstrumentedSqlQuery(const QString &query, const QSqlDatabase &db) :
+        QSqlQuery(db), m_db(db)
+{
+    if (!query.isEmpty())
+        exec(query);
+}
+
+InstrumentedSqlQuery::~InstrumentedSqlQuery()
+{
+    flushRows();
+}
+
+bool InstrumentedSqlQuery::exec()
+{
+    auto &stats = SqlQueryStats::instance();
+    if (!stats.enabled())
+        return QSqlQuery::exec();
+    flushRows();
+    QElapsedTimer timer;
+    timer.start();
+    bool result = QSqlQuery::exec();
+    stats.recordExec(*this, m_db, timer.nsecsElapsed());
+    return result;
+}
+
+bool InstrumentedSqlQuery::exec(const QString &query)
+{
+    auto &stats = SqlQueryStats::instance();
+    if (!stats.enabled())
+        return QSqlQuery::exec(query);
+    flushRows();
+    QElapsedTimer timer;
+    timer.start();
+    bool result = QSqlQuery::exec(query);
+    stats.recordExec(*this, m_db, timer.nsecsElapsed());
+    return result;
+}
+
+bool InstrumentedSqlQuery::next()
+{
+    bool result = QSqlQuery::next();
+    if (result)
+        m_pendingRows++;
+    return result;
+}
+
+bool InstrumentedSqlQuery::first()
+{
+    bool result = QSqlQuery::first();
+    if (result && m_pendingRows == 0)
+        m_pendingRows = 1;
+    return result;
+}
+
+void InstrumentedSqlQuery::flushRows()
+{
+    if (m_pendingRows > 0 && SqlQueryStats::instance().enabled())
+        SqlQueryStats::instance().recordRows(lastQuery(), m_pendingRows);
+    m_pendingRows = 0;
+}
+
+
+SqlQueryStatsAction::SqlQueryStatsAction(const QString &name)
+{
+    if (SqlQueryStats::instance().enabled()) {
+        SqlQueryStats::instance().beginAction(name);
+        m_active = true;
+    }
+}
+
+SqlQueryStatsAction::~SqlQueryStatsAction()
+{
+    if (m_active)
+        SqlQueryStats::instance().endAction();
+}
@@ -0,0 +1,108 @@
+#ifndef SQLQUERYSTATS_H
+#define SQLQUERYSTATS_H
+
+#include <QSqlQuery>
+#include <QSqlDatabase>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QElapsedTimer>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Collects execution counts, latency and rows fetched per SQL statement for queries run through
+// InstrumentedSqlQuery, both overall and per user action (see SqlQueryStatsAction).
+// Recording is off by default. When on, statements slower than the threshold are logged together with
+// their EXPLAIN QUERY PLAN output so missing indexes and full table scans show up in the log.
+class SqlQueryStats
+{
+public:
+    struct StatementStats {
+        quint64 count{0};
+        qint64 totalNs{0};
+        qint64 maxNs{0};
+        quint64 rows{0};
+    };
+    struct ActionStats {
+        quint64 invocations{0};
+        quint64 queries{0};
+        quint64 maxQueries{0};
+        qint64 totalNs{0};
+        QHash<QString, StatementStats> statements;
+    };
+
+    static SqlQueryStats &instance();
+    [[nodiscard]] bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+    void setSlowThresholdMs(int ms);
+    void recordExec(const QSqlQuery &query, const QSqlDatabase &db, qint64 elapsedNs);
+    void recordRows(const QString &statement, quint64 rows);
+    void beginAction(const QString &name);
+    void endAction();
+    void logSummary();
+    void reset();
+
+private:
+    struct ActiveAction {
+        QString name;
+        quint64 queries{0};
+        qint64 queryNs{0};
+    };
+    SqlQueryStats();
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::string m_loggingPrefix{"[SqlQueryStats]"};
+    std::atomic<bool> m_enabled{false};
+    std::atomic<int> m_slowThresholdMs{50};
+    std::mutex m_mutex;
+    QHash<QString, StatementStats> m_statements;
+    QHash<QString, ActionStats> m_actions;
+    QSet<QString> m_explainedStatements;
+    static thread_local std::vector<ActiveAction> t_activeActions;
+
+    static QString normalizeStatement(const QString &statement);
+    [[nodiscard]] QString currentActionName() const;
+    void logSlowQuery(const QSqlQuery &query, const QSqlDatabase &db, const QString &statement, qint64 elapsedNs,
+                      bool explain);
+};
+
+// Drop in replacement for QSqlQuery that reports to SqlQueryStats.
+// Only exec(), next() and first() are instrumented, when recording is off they cost one atomic load.
+class InstrumentedSqlQuery : public QSqlQuery
+{
+public:
+    explicit InstrumentedSqlQuery(const QSqlDatabase &db = QSqlDatabase::database());
+    explicit InstrumentedSqlQuery(const QString &query, const QSqlDatabase &db = QSqlDatabase::database());
+    InstrumentedSqlQuery(const InstrumentedSqlQuery &other) = default;
+    InstrumentedSqlQuery &operator=(const InstrumentedSqlQuery &other) = default;
+    ~InstrumentedSqlQuery();
+    bool exec();
+    bool exec(const QString &query);
+    bool next();
+    bool first();
+
+private:
+    QSqlDatabase m_db;
+    quint64 m_pendingRows{0};
+    void flushRows();
+};
+
+// Attributes every query run on this thread until it goes out of scope to the named action
+class SqlQueryStatsAction
+{
+public:
+    explicit SqlQueryStatsAction(const QString &name);
+    ~SqlQueryStatsAction();
+    SqlQueryStatsAction(const SqlQueryStatsAction &) = delete;
+    SqlQueryStatsAction &operator=(const SqlQueryStatsAction &) = delete;
+
+private:
+    bool m_active{false};
+};
+
+#endif // SQLQUERYSTATS_H
@@ -1,4 +1,6 @@
 #include "tagreader.h"
+#include "mappedfilestream.h"
+#include <memory>
 #include <tag.h>
 #include <taglib/fileref.h>
 
@@ -93,12 +95,24 @@ void TagReader::setMedia(const QString& path)
 
 void TagReader::taglibTags(const QString& path)
 {
-    TagLib::FileRef f(path.toLocal8Bit().data());
+    bool readProperties = m_readMode != ReadMode::TagsOnly;
+    auto style = (m_readMode == ReadMode::EstimatedDuration) ? TagLib::AudioProperties::Fast : TagLib::AudioProperties::Average;
+    // The stream has to outlive the FileRef, TagLib doesn't take ownership of it
+    std::unique_ptr<MappedFileStream> stream;
+    TagLib::FileRef f;
+    if (MappedFileStream::isLocalFile(path))
+    {
+        stream = std::make_unique<MappedFileStream>(path);
+        if (stream->isOpen())
+            f = TagLib::FileRef(stream.get(), readProperties, style);
+    }
+    if (f.isNull())
+        f = TagLib::FileRef(path.toLocal8Bit().data(), readProperties, style);
     if (!f.isNull())
     {
         m_artist = f.tag()->artist().toCString(true);
         m_title = f.tag()->title().toCString(true);
-        m_duration = f.audioProperties()->length() * 1000;
+        m_duration = (readProperties && f.audioProperties()) ? f.audioProperties()->lengthInMilliseconds() : 0;
         m_album = f.tag()->album().toCString(true);
         auto track = f.tag()->track();
         if (track == 0)
@@ -115,6 +129,7 @@ void TagReader::taglibTags(const QString& path)
         m_artist = QString();
         m_title = QString();
         m_album = QString();
+        m_track = QString();
         m_duration = 0;
     }
 }
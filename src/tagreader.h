@@ -14,6 +14,13 @@ std::ostream& operator<<(std::ostream& os, const QString& s);
 class TagReader : public QObject
 {
     Q_OBJECT
+public:
+    // TagsAndDuration reads tags and has taglib compute an accurate duration.
+    // TagsOnly skips audio properties entirely, for callers that get the duration elsewhere (cdg size, zip contents).
+    // EstimatedDuration only looks at headers (Xing/VBRI frame, first/last frame, mp4 moov) for the duration,
+    // the bulk of the file is never read.  Good enough for library scans, playback gets the real duration.
+    enum class ReadMode {TagsAndDuration, TagsOnly, EstimatedDuration};
+
 private:
     std::string m_loggingPrefix{"[TagReader]"};
     std::shared_ptr<spdlog::logger> m_logger;
@@ -23,6 +30,7 @@ private:
     QString m_track;
     unsigned int m_duration;
     QString m_path;
+    ReadMode m_readMode{ReadMode::TagsAndDuration};
     GstDiscoverer *discoverer;
 
 public:
@@ -34,6 +42,7 @@ public:
     QString getTrack();
     unsigned int getDuration() const;
     void setMedia(const QString& path);
+    void setReadMode(ReadMode mode) { m_readMode = mode; }
     void taglibTags(const QString& path);
 
 signals:
@@ -30,6 +30,12 @@ void TickerNew::run() {
     m_textChanged = true;
     while (!m_stop)
     {
+        // Nothing on screen would change while the widget is hidden or the text fits without scrolling
+        if (m_paused || (!m_textOverflows && !m_textChanged))
+        {
+            TickerNew::msleep(50);
+            continue;
+        }
         if (!m_textOverflows)
             curOffset = 0;
         if (curOffset >= m_txtWidth) {
@@ -205,6 +211,18 @@ void TickerDisplayWidget::resizeEvent(QResizeEvent *event)
     ticker->setWidth(event->size().width());
 }
 
+void TickerDisplayWidget::showEvent(QShowEvent *event)
+{
+    ticker->setPaused(false);
+    QWidget::showEvent(event);
+}
+
+void TickerDisplayWidget::hideEvent(QHideEvent *event)
+{
+    ticker->setPaused(true);
+    QWidget::hideEvent(event);
+}
+
 void TickerDisplayWidget::newFrameRect(const QPixmap& frame, const QRect displayArea)
 {
     rectBasedDrawing = true;
@@ -9,6 +9,7 @@
 #include <spdlog/async_logger.h>
 #include <spdlog/fmt/ostr.h>
 #include <QMutex>
+#include <atomic>
 
 std::ostream& operator<<(std::ostream& os, const QString& s);
 
@@ -42,6 +43,7 @@ private:
     bool m_textOverflows{false};
     int m_speed{5};
     bool m_textChanged{false};
+    std::atomic<bool> m_paused{false};
     std::string m_loggingPrefix{"[TickerThread]"};
     std::shared_ptr<spdlog::logger> m_logger;
 
@@ -51,6 +53,7 @@ public:
     TickerNew();
     QSize getSize();
     void stop();
+    void setPaused(bool paused) { m_paused = paused; }
 
 public slots:
     void setWidth(int width);
@@ -96,6 +99,8 @@ private slots:
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 };
 
 #endif // TICKERNEW_H
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "zipoptimizer.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include "mzarchive.h"
+
+namespace {
+size_t readFromQFile(void *opaque, mz_uint64 offset, void *buffer, size_t size)
+{
+    auto file = static_cast<QFile*>(opaque);
+    if (!file->seek(static_cast<qint64>(offset)))
+        return 0;
+    auto bytesRead = file->read(static_cast<char*>(buffer), static_cast<qint64>(size));
+    return bytesRead < 0 ? 0 : static_cast<size_t>(bytesRead);
+}
+
+QString zipError(mz_zip_archive &archive)
+{
+    return mz_zip_get_error_string(mz_zip_get_last_error(&archive));
+}
+}
+
+ZipOptimizer::ZipOptimizer(QObject *parent) : QObject(parent)
+{
+    m_logger = spdlog::get("logger");
+}
+
+ZipOptimizer::Report ZipOptimizer::run(const QStringList &paths, bool dryRun)
+{
+    Report report;
+    report.dryRun = dryRun;
+    m_cancelled = false;
+    QElapsedTimer timer;
+    timer.start();
+    m_logger->info("{} Starting {} of {} archives", m_loggingPrefix, dryRun ? "dry run" : "optimization", paths.size());
+    emit stateChanged(dryRun ? tr("Checking archives (dry run)") : tr("Optimizing archives"));
+    for (const auto &path : paths)
+    {
+        if (m_cancelled)
+        {
+            report.cancelled = true;
+            break;
+        }
+        qint64 bytesBefore{0};
+        qint64 bytesAfter{0};
+        int entriesRemoved{0};
+        QString error;
+        switch (optimizeArchive(path, dryRun, bytesBefore, bytesAfter, entriesRemoved, error))
+        {
+            case Outcome::AlreadyOptimized:
+                report.alreadyOptimized++;
+                break;
+            case Outcome::Optimized:
+                report.optimized++;
+                report.entriesRemoved += entriesRemoved;
+                emit progressMessage(QString("%1%2 (%3 KB -> %4 KB, %5 extra entries)").arg(dryRun ? "Would optimize: " : "Optimized: ",
+                        path).arg(bytesBefore / 1024).arg(bytesAfter / 1024).arg(entriesRemoved));
+                break;
+            case Outcome::Failed:
+                report.failed++;
+                report.errors.append(path + " - " + error);
+                emit progressMessage("Skipped: " + path + " - " + error);
+                m_logger->warn("{} Skipped {}: {}", m_loggingPrefix, path, error);
+                break;
+        }
+        report.bytesBefore += bytesBefore;
+        report.bytesAfter += bytesAfter;
+        emit progressChanged(++report.scanned, static_cast<int>(paths.size()));
+    }
+    report.elapsedMs = timer.elapsed();
+    m_logger->info("{} {} {} of {} archives in {} ms, {} already optimized, {} failed, {} -> {} bytes",
+                   m_loggingPrefix, dryRun ? "Dry run would optimize" : "Optimized", report.optimized, report.scanned,
+                   report.elapsedMs, report.alreadyOptimized, report.failed, report.bytesBefore, report.bytesAfter);
+    return report;
+}
+
+ZipOptimizer::Outcome ZipOptimizer::optimizeArchive(const QString &path, bool dryRun, qint64 &bytesBefore,
+                                                    qint64 &bytesAfter, int &entriesRemoved, QString &error)
+{
+    QFile zipFile(path);
+    if (!zipFile.open(QIODevice::ReadOnly))
+    {
+        error = "Unable to open zip file";
+        return Outcome::Failed;
+    }
+    bytesBefore = zipFile.size();
+    auto modified = QFileInfo(path).lastModified();
+
+    // Only the central directory is read until we know the archive needs rewriting
+    mz_zip_archive reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.m_pRead = readFromQFile;
+    reader.m_pIO_opaque = &zipFile;
+    if (!mz_zip_reader_init(&reader, static_cast<mz_uint64>(zipFile.size()), 0))
+    {
+        error = "Unable to read zip directory: " + zipError(reader);
+        return Outcome::Failed;
+    }
+    // Same members MzArchive picks at play time, so the repacked archive plays exactly like the original
+    auto members = MzArchive::findKaraokeMembers(&reader);
+    int cdgIndex = members.cdgIndex;
+    int audioIndex = members.audioIndex;
+    auto cdgStat = members.cdgStat;
+    auto audioStat = members.audioStat;
+    unsigned int files = mz_zip_reader_get_num_files(&reader);
+    if (cdgIndex < 0 || audioIndex < 0)
+        error = cdgIndex < 0 ? "CDG not found in zip file" : "Audio file not found in zip file";
+    else if (!cdgStat.m_is_supported || !audioStat.m_is_supported)
+        error = "Archive uses a compression method or encryption that can't be rewritten";
+    if (!error.isEmpty())
+    {
+        mz_zip_reader_end(&reader);
+        return Outcome::Failed;
+    }
+    if (files == 2 && cdgIndex == 0 && audioIndex == 1 && cdgStat.m_method == 0 && audioStat.m_method == 0)
+    {
+        mz_zip_reader_end(&reader);
+        bytesAfter = bytesBefore;
+        return Outcome::AlreadyOptimized;
+    }
+    entriesRemoved = static_cast<int>(files) - 2;
+
+    // Extraction checks each member against its stored CRC32
+    size_t cdgSize{0};
+    size_t audioSize{0};
+    auto cdgData = mz_zip_reader_extract_to_heap(&reader, cdgIndex, &cdgSize, 0);
+    if (!cdgData)
+        error = "Unable to extract CDG member: " + zipError(reader);
+    auto audioData = cdgData ? mz_zip_reader_extract_to_heap(&reader, audioIndex, &audioSize, 0) : nullptr;
+    if (cdgData && !audioData)
+        error = "Unable to extract audio member: " + zipError(reader);
+    mz_zip_reader_end(&reader);
+    zipFile.close();
+
+    void *archiveData{nullptr};
+    size_t archiveSize{0};
+    if (error.isEmpty())
+    {
+        mz_zip_archive writer;
+        memset(&writer, 0, sizeof(writer));
+        size_t expectedSize = cdgSize + audioSize + 512;
+        if (!mz_zip_writer_init_heap(&writer, 0, expectedSize)
+            || !mz_zip_writer_add_mem_ex_v2(&writer, cdgStat.m_filename, cdgData, cdgSize, nullptr, 0, MZ_NO_COMPRESSION,
+                                            0, 0, &cdgStat.m_time, nullptr, 0, nullptr, 0)
+            || !mz_zip_writer_add_mem_ex_v2(&writer, audioStat.m_filename, audioData, audioSize, nullptr, 0, MZ_NO_COMPRESSION,
+                                            0, 0, &audioStat.m_time, nullptr, 0, nullptr, 0)
+            || !mz_zip_writer_finalize_heap_archive(&writer, &archiveData, &archiveSize))
+            error = "Unable to build optimized archive: " + zipError(writer);
+        mz_zip_writer_end(&writer);
+    }
+    mz_free(cdgData);
+    mz_free(audioData);
+
+    mz_zip_error validateError{MZ_ZIP_NO_ERROR};
+    if (error.isEmpty() && !mz_zip_validate_mem_archive(archiveData, archiveSize, 0, &validateError))
+        error = QString("Optimized archive failed validation: ") + mz_zip_get_error_string(validateError);
+    if (error.isEmpty() && !dryRun)
+    {
+        // QSaveFile writes next to the original and renames over it only once everything is on disk
+        QSaveFile saveFile(path);
+        if (!saveFile.open(QIODevice::WriteOnly)
+            || saveFile.write(static_cast<const char*>(archiveData), static_cast<qint64>(archiveSize)) != static_cast<qint64>(archiveSize)
+            || !saveFile.commit())
+            error = "Unable to write optimized archive: " + saveFile.errorString();
+    }
+    if (archiveData)
+        mz_free(archiveData);
+    if (!error.isEmpty())
+        return Outcome::Failed;
+    bytesAfter = static_cast<qint64>(archiveSize);
+    if (!dryRun)
+    {
+        // Keep the original timestamp, the song hasn't changed as far as anything else is concerned
+        QFile optimized(path);
+        if (optimized.open(QIODevice::Append))
+            optimized.setFileTime(modified, QFileDevice::FileModificationTime);
+    }
+    return Outcome::Optimized;
+}
@@ -0,0 +1,60 @@
+#ifndef ZIPOPTIMIZER_H
+#define ZIPOPTIMIZER_H
+
+#include <QObject>
+#include <QStringList>
+#include <atomic>
+#include <spdlog/spdlog.h>
+#include <spdlog/async_logger.h>
+#include <spdlog/fmt/ostr.h>
+
+std::ostream& operator<<(std::ostream& os, const QString& s);
+
+// Rewrites karaoke zips into a canonical layout that's cheap to play: just the cdg and audio members, cdg first,
+// both stored uncompressed.  Members are CRC checked on the way out and the new archive is validated in memory
+// before it atomically replaces the original, an archive is never left half written.
+// Archives already in the canonical layout are recognized from the central directory alone, so an interrupted run
+// can simply be started again.  A dry run does all the work except replacing the files.
+class ZipOptimizer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Report {
+        bool dryRun{false};
+        bool cancelled{false};
+        int scanned{0};
+        int alreadyOptimized{0};
+        int optimized{0};
+        int failed{0};
+        int entriesRemoved{0};
+        qint64 bytesBefore{0};
+        qint64 bytesAfter{0};
+        qint64 elapsedMs{0};
+        QStringList errors;
+    };
+
+    explicit ZipOptimizer(QObject *parent = nullptr);
+    // Blocks until every archive has been handled or cancel() is called, meant to be run off the GUI thread
+    Report run(const QStringList &paths, bool dryRun);
+    void cancel() { m_cancelled = true; }
+
+signals:
+    void progressChanged(int done, int total);
+    void progressMessage(const QString &message);
+    void stateChanged(const QString &state);
+
+private:
+    enum class Outcome {
+        AlreadyOptimized,
+        Optimized,
+        Failed
+    };
+    std::string m_loggingPrefix{"[ZipOptimizer]"};
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::atomic<bool> m_cancelled{false};
+
+    Outcome optimizeArchive(const QString &path, bool dryRun, qint64 &bytesBefore, qint64 &bytesAfter,
+                            int &entriesRemoved, QString &error);
+};
+
+#endif // ZIPOPTIMIZER_H